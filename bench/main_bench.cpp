@@ -0,0 +1,781 @@
+// 离屏基准测试入口
+// 在无窗口环境（例如只有 Mesa llvmpipe 的 Linux 构建服务器）下创建 EGL 上下文，
+// 按脚本场景驱动 Renderer 固定帧数，并输出逐帧/逐通道的 CPU、GPU 耗时报告（JSON）。
+//
+// 用法：MyGR_bench [scene.json ...] [--out report.json] [--frames N] [--no-gpu-timing] [--no-render-queue] [--no-culling] [--no-bvh] [--multi-draw] [--gpu-culling] [--occlusion] [--sw-occlusion] [--occlusion-queries] [--no-clustered-lighting] [--depth-prepass] [--compact-gbuffer] [--ssao-full] [--ssao-temporal] [--dynamic-resolution] [--trace trace.json]
+// --trace 需要以 ENABLE_CPU_PROFILER 编译，导出 CPU 区间的 Chrome trace。
+// 不指定场景时运行 res/bench/ 目录下的所有 .json 场景。
+
+#include <glad/glad.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <cstdlib>
+#include <cmath>
+#include <random>
+
+#if defined(__linux__)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
+#include <GLFW/glfw3.h>
+#endif
+
+#include "Camera.h"
+#include "Renderer.h"
+#include "Model.h"
+#include "InstancedModel.h"
+#include "Light.h"
+#include "GlobalSettings.h"
+#include "GpuProfiler.h"
+#include "GLStats.h"
+#include "CpuProfiler.h"
+
+#include <glm/glm.hpp>
+
+// ---------------------------------------------------------------------------
+// 离屏上下文
+// ---------------------------------------------------------------------------
+class HeadlessContext {
+public:
+    bool create(int width, int height);
+    void destroy();
+
+private:
+#if defined(__linux__)
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+#else
+    GLFWwindow* window = nullptr;
+#endif
+};
+
+#if defined(__linux__)
+bool HeadlessContext::create(int width, int height)
+{
+    // llvmpipe 只报告 4.5，而着色器统一使用 #version 460，这里在未手动指定时覆盖版本号
+    setenv("MESA_GL_VERSION_OVERRIDE", "4.6", 0);
+    setenv("MESA_GLSL_VERSION_OVERRIDE", "460", 0);
+
+    // 优先使用 surfaceless 平台，不依赖 X11/Wayland
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay) {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        std::cerr << "Failed to initialize EGL display" << std::endl;
+        return false;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24, EGL_STENCIL_SIZE, 8,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+        std::cerr << "Failed to choose EGL config" << std::endl;
+        return false;
+    }
+
+    eglBindAPI(EGL_OPENGL_API);
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 6,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create OpenGL 4.6 core context" << std::endl;
+        return false;
+    }
+
+    // 渲染器会直接绑定默认帧缓冲（FBO 0），因此用 pbuffer 充当“屏幕”
+    const EGLint pbufferAttribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+    surface = eglCreatePbufferSurface(display, config, pbufferAttribs);
+    if (surface == EGL_NO_SURFACE) {
+        std::cerr << "Warning: pbuffer unavailable, falling back to surfaceless context" << std::endl;
+    }
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+        std::cerr << "Failed to make EGL context current" << std::endl;
+        return false;
+    }
+
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void HeadlessContext::destroy()
+{
+    if (display == EGL_NO_DISPLAY) return;
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+    if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+    eglTerminate(display);
+    display = EGL_NO_DISPLAY;
+}
+#else
+// 非 Linux 平台没有 surfaceless EGL，退化为隐藏的 GLFW 窗口
+bool HeadlessContext::create(int width, int height)
+{
+    if (!glfwInit()) return false;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    window = glfwCreateWindow(width, height, "MyGR_bench", NULL, NULL);
+    if (!window) {
+        std::cerr << "Failed to create hidden GLFW window" << std::endl;
+        glfwTerminate();
+        return false;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void HeadlessContext::destroy()
+{
+    if (!window) return;
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    window = nullptr;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// 场景脚本
+// ---------------------------------------------------------------------------
+struct SceneObjectGroup {
+    BasicGeom geom = BasicGeom::Sphere;
+    glm::ivec3 count = glm::ivec3(1);       // 网格排布数量
+    glm::vec3 spacing = glm::vec3(2.5f);
+    glm::vec3 origin = glm::vec3(0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+    bool instanced = false;                 // 整组作为一个实例化模型绘制
+    bool occluder = false;                  // 整组标记为遮挡物（软件遮挡剔除）
+    bool transparent = false;               // 整组由透明通道（OIT + 分簇前向光照）绘制
+    std::vector<std::pair<TextureType, std::string>> textures;
+};
+
+// 不投射阴影的动态点光：在以 origin 为中心、半边长为 extent 的盒子内按固定种子随机分布，每帧上下浮动
+struct SceneLightGroup {
+    int count = 0;
+    glm::vec3 origin = glm::vec3(0.0f);
+    glm::vec3 extent = glm::vec3(10.0f, 1.0f, 10.0f);
+    float radius = 0.0f;            // 影响半径，0 表示按衰减系数计算
+    float intensity = 1.0f;         // 漫反射/镜面反射强度
+    float bobAmplitude = 0.5f;      // 浮动幅度
+    unsigned int seed = 1;
+};
+
+struct BenchScene {
+    std::string name;
+    int width = 1920;
+    int height = 1080;
+    int warmupFrames = 20;
+    int frames = 300;
+
+    // 摄像机绕目标点匀速环绕，保证每次运行的画面序列一致
+    glm::vec3 cameraTarget = glm::vec3(0.0f);
+    float cameraRadius = 6.0f;
+    float cameraHeight = 2.0f;
+    float orbitDegreesPerFrame = 0.5f;
+
+    bool depthPrepass = false;              // PBR 的 G-Buffer 阶段之前做深度预渲染
+    bool compactGBuffer = false;            // PBR 使用紧凑 G-Buffer 布局
+    int ssaoResolutionDivisor = 2;          // SSAO 分辨率因子（1/2/4）
+    int ssaoKernelSize = 16;                // SSAO 每像素采样数
+    bool ssaoBlur = true;                   // SSAO 双边模糊
+    bool ssaoTemporal = false;              // SSAO 时域累积
+    int ssaoTemporalSamples = 8;            // 时域模式每帧的采样数
+    bool dynamicResolution = false;         // 按 GPU 耗时调整渲染分辨率
+    float dynamicResolutionTargetMs = 16.6f;    // GPU 帧耗时预算
+    float dynamicResolutionMinScale = 0.5f;
+
+    std::vector<SceneObjectGroup> objects;
+    SceneLightGroup lights;
+};
+
+static glm::vec3 readVec3(const json& j, const char* key, const glm::vec3& fallback)
+{
+    if (!j.contains(key)) return fallback;
+    const json& v = j[key];
+    if (v.is_number()) return glm::vec3(v.get<float>());
+    return glm::vec3(v[0].get<float>(), v[1].get<float>(), v[2].get<float>());
+}
+
+static bool loadScene(const std::string& path, BenchScene& scene)
+{
+    std::ifstream inFile(path);
+    if (!inFile.is_open()) {
+        std::cerr << "Failed to open scene: " << path << std::endl;
+        return false;
+    }
+    json j;
+    inFile >> j;
+
+    scene.name = j.value("name", std::filesystem::path(path).stem().string());
+    scene.width = j.value("width", scene.width);
+    scene.height = j.value("height", scene.height);
+    scene.warmupFrames = j.value("warmup_frames", scene.warmupFrames);
+    scene.frames = j.value("frames", scene.frames);
+    scene.depthPrepass = j.value("depth_prepass", scene.depthPrepass);
+    scene.compactGBuffer = j.value("compact_gbuffer", scene.compactGBuffer);
+    if (j.contains("ssao")) {
+        const json& ssao = j["ssao"];
+        scene.ssaoResolutionDivisor = ssao.value("resolution_divisor", scene.ssaoResolutionDivisor);
+        scene.ssaoKernelSize = ssao.value("kernel_size", scene.ssaoKernelSize);
+        scene.ssaoBlur = ssao.value("blur", scene.ssaoBlur);
+        scene.ssaoTemporal = ssao.value("temporal", scene.ssaoTemporal);
+        scene.ssaoTemporalSamples = ssao.value("temporal_samples", scene.ssaoTemporalSamples);
+    }
+    if (j.contains("dynamic_resolution")) {
+        const json& drs = j["dynamic_resolution"];
+        scene.dynamicResolution = drs.value("enabled", true);
+        scene.dynamicResolutionTargetMs = drs.value("target_ms", scene.dynamicResolutionTargetMs);
+        scene.dynamicResolutionMinScale = drs.value("min_scale", scene.dynamicResolutionMinScale);
+    }
+
+    if (j.contains("camera")) {
+        const json& cam = j["camera"];
+        scene.cameraTarget = readVec3(cam, "target", scene.cameraTarget);
+        scene.cameraRadius = cam.value("radius", scene.cameraRadius);
+        scene.cameraHeight = cam.value("height", scene.cameraHeight);
+        scene.orbitDegreesPerFrame = cam.value("orbit_degrees_per_frame", scene.orbitDegreesPerFrame);
+    }
+
+    static const std::unordered_map<std::string, BasicGeom> geomNames = {
+        {"Plane", BasicGeom::Plane}, {"Cube", BasicGeom::Cube}, {"Sphere", BasicGeom::Sphere}
+    };
+    static const std::unordered_map<std::string, TextureType> textureNames = {
+        {"diffuse", TextureType::Diffuse}, {"normal", TextureType::Normal},
+        {"metallic", TextureType::Metallic}, {"roughness", TextureType::Roughness},
+        {"ao", TextureType::AO}, {"height", TextureType::Height}
+    };
+
+    if (j.contains("objects")) {
+        for (const auto& o : j["objects"]) {
+            SceneObjectGroup group;
+            auto geomIt = geomNames.find(o.value("geom", std::string("Sphere")));
+            if (geomIt == geomNames.end()) {
+                std::cerr << "Unknown geom in scene " << path << std::endl;
+                return false;
+            }
+            group.geom = geomIt->second;
+            if (o.contains("count")) {
+                group.count = glm::ivec3(o["count"][0].get<int>(), o["count"][1].get<int>(), o["count"][2].get<int>());
+            }
+            group.spacing = readVec3(o, "spacing", group.spacing);
+            group.origin = readVec3(o, "origin", group.origin);
+            group.scale = readVec3(o, "scale", group.scale);
+            group.instanced = o.value("instanced", group.instanced);
+            group.occluder = o.value("occluder", group.occluder);
+            group.transparent = o.value("transparent", group.transparent);
+            if (o.contains("textures")) {
+                for (auto& [k, v] : o["textures"].items()) {
+                    auto texIt = textureNames.find(k);
+                    if (texIt != textureNames.end()) {
+                        group.textures.push_back({texIt->second, v.get<std::string>()});
+                    }
+                }
+            }
+            scene.objects.push_back(group);
+        }
+    }
+    if (j.contains("lights")) {
+        const json& l = j["lights"];
+        scene.lights.count = l.value("count", scene.lights.count);
+        scene.lights.origin = readVec3(l, "origin", scene.lights.origin);
+        scene.lights.extent = readVec3(l, "extent", scene.lights.extent);
+        scene.lights.radius = l.value("radius", scene.lights.radius);
+        scene.lights.intensity = l.value("intensity", scene.lights.intensity);
+        scene.lights.bobAmplitude = l.value("bob_amplitude", scene.lights.bobAmplitude);
+        scene.lights.seed = l.value("seed", scene.lights.seed);
+    }
+    return true;
+}
+
+// 生成场景的动态点光并注册到 Renderer，baseUnits 返回每个灯光的初始参数（用于逐帧浮动）
+static std::shared_ptr<Light> populateLights(const BenchScene& scene, std::vector<LightUnit>& baseUnits)
+{
+    baseUnits.clear();
+    if (scene.lights.count <= 0) return nullptr;
+    // mt19937 的输出序列与平台无关，自行换算到 [0, 1) 保证每次运行的灯光分布一致
+    std::mt19937 rng(scene.lights.seed);
+    auto random01 = [&rng]() { return static_cast<float>(rng() / 4294967296.0); };
+    for (int i = 0; i < scene.lights.count; ++i) {
+        LightUnit unit;
+        glm::vec3 r(random01(), random01(), random01());
+        unit.position = scene.lights.origin + (r * 2.0f - 1.0f) * scene.lights.extent;
+        unit.color = glm::vec3(0.3f) + 0.7f * glm::vec3(random01(), random01(), random01());
+        unit.intensity = glm::vec3(0.0f, scene.lights.intensity, scene.lights.intensity);
+        unit.radius = scene.lights.radius;
+        baseUnits.push_back(unit);
+    }
+    std::shared_ptr<Light> light = std::make_shared<Light>();
+    light->set_dynamicLights(baseUnits);
+    Renderer::getInstance().add_light(light);
+    Renderer::getInstance().set_light_renderType(RenderType::Basic, light);
+    return light;
+}
+
+static int populateScene(const BenchScene& scene)
+{
+    int modelCount = 0;
+    for (const auto& group : scene.objects) {
+        RenderType renderType = group.transparent ? RenderType::Transparent : RenderType::Basic;
+        if (group.instanced) {
+            Texture* texture = nullptr;
+            if (!group.textures.empty()) {
+                texture = new Texture();
+                for (const auto& [type, file] : group.textures) {
+                    texture->add_image(file, type);
+                }
+            }
+            std::shared_ptr<Model> prototype = std::make_shared<Model>();
+            prototype->add_basic_geom(group.geom, texture);
+            std::shared_ptr<InstancedModel> instancedModel = std::make_shared<InstancedModel>(prototype);
+            for (int x = 0; x < group.count.x; ++x)
+            for (int y = 0; y < group.count.y; ++y)
+            for (int z = 0; z < group.count.z; ++z) {
+                instancedModel->add_instance(group.origin + group.spacing * glm::vec3((float)x, (float)y, (float)z), glm::vec3(0.0f), group.scale);
+                modelCount++;
+            }
+            Renderer::getInstance().add_instancedModel(instancedModel, renderType);
+            continue;
+        }
+        for (int x = 0; x < group.count.x; ++x)
+        for (int y = 0; y < group.count.y; ++y)
+        for (int z = 0; z < group.count.z; ++z) {
+            // Mesh 析构时会释放纹理，所以每个模型持有独立的 Texture（图片本身由纹理缓存共享）
+            Texture* texture = nullptr;
+            if (!group.textures.empty()) {
+                texture = new Texture();
+                for (const auto& [type, file] : group.textures) {
+                    texture->add_image(file, type);
+                }
+            }
+            std::shared_ptr<Model> model = std::make_shared<Model>();
+            model->add_basic_geom(group.geom, texture);
+            model->set_scale(group.scale);
+            model->set_position(group.origin + group.spacing * glm::vec3((float)x, (float)y, (float)z));
+            model->set_occluder(group.occluder);
+            Renderer::getInstance().set_model_renderType(model, renderType);
+            modelCount++;
+        }
+    }
+    return modelCount;
+}
+
+// ---------------------------------------------------------------------------
+// 统计
+// ---------------------------------------------------------------------------
+static json summarize(std::vector<double> samples)
+{
+    json j;
+    if (samples.empty()) {
+        j["mean"] = j["p50"] = j["p95"] = j["p99"] = 0.0;
+        return j;
+    }
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double v : samples) sum += v;
+    // 最近秩法求百分位
+    auto percentile = [&samples](double p) {
+        size_t rank = (size_t)std::ceil(p / 100.0 * samples.size());
+        return samples[std::min(samples.size() - 1, rank > 0 ? rank - 1 : 0)];
+    };
+    j["mean"] = sum / samples.size();
+    j["p50"] = percentile(50.0);
+    j["p95"] = percentile(95.0);
+    j["p99"] = percentile(99.0);
+    j["min"] = samples.front();
+    j["max"] = samples.back();
+    return j;
+}
+
+static json runScene(const BenchScene& scene, bool gpuTiming)
+{
+    Renderer& renderer = Renderer::getInstance();
+    GpuProfiler& gpuProfiler = GpuProfiler::getInstance();
+
+    Camera camera;
+    camera.setPerspective(45.0f, (float)scene.width / (float)scene.height, 0.1f, 100.0f);
+    renderer.set_camera(&camera);
+    renderer.set_depthPrepassEnabled(scene.depthPrepass);
+    renderer.set_compactGBufferEnabled(scene.compactGBuffer);   // 下一帧起从帧缓冲池申请新布局的 G-Buffer
+    AmbientOcclusion& ambientOcclusion = renderer.get_ambientOcclusion();
+    ambientOcclusion.set_resolutionDivisor(scene.ssaoResolutionDivisor);
+    ambientOcclusion.set_kernelSize(scene.ssaoKernelSize);
+    ambientOcclusion.set_blurEnabled(scene.ssaoBlur);
+    ambientOcclusion.set_temporalEnabled(scene.ssaoTemporal);
+    ambientOcclusion.set_temporalSampleCount(scene.ssaoTemporalSamples);
+    ambientOcclusion.reset_history();   // 上一个场景的历史不可用
+    DynamicResolution& dynamicResolution = renderer.get_dynamicResolution();
+    dynamicResolution.set_targetFrameMs(scene.dynamicResolutionTargetMs);
+    dynamicResolution.set_minScale(scene.dynamicResolutionMinScale);
+    dynamicResolution.reset();          // 每个场景从完整分辨率开始
+    renderer.set_dynamicResolutionEnabled(scene.dynamicResolution);
+    int modelCount = populateScene(scene);
+    std::vector<LightUnit> baseLights;
+    std::shared_ptr<Light> light = populateLights(scene, baseLights);
+    std::vector<LightUnit> frameLights = baseLights;
+    renderer.setupRenderPasses();
+    renderer.set_passTimingEnabled(true);
+    gpuProfiler.set_enabled(gpuTiming || scene.dynamicResolution);  // 动态分辨率的控制器依赖 GPU 计时
+    gpuProfiler.set_recording(gpuTiming);
+    gpuProfiler.clear_recordedFrames();
+
+    std::vector<double> frameCpu;
+    std::vector<double> renderScales;
+    // 按通道名记录：渲染图每帧重新编译，剔除或开关通道后同一步骤序号可能对应不同的通道
+    std::vector<std::string> passNames;     // 首次出现的顺序
+    std::unordered_map<std::string, std::vector<double>> passCpu;
+    std::vector<unsigned long long> profilerFrames;   // 每个计入统计的帧在 GpuProfiler 中的序号
+    std::vector<std::vector<double>> glCounters(GLStats::COUNTER_COUNT);
+    json perFrame = json::array();
+
+    int totalFrames = scene.warmupFrames + scene.frames;
+    for (int frame = 0; frame < totalFrames; ++frame) {
+        float angle = glm::radians(scene.orbitDegreesPerFrame * frame);
+        glm::vec3 eye = scene.cameraTarget + glm::vec3(scene.cameraRadius * std::cos(angle), scene.cameraHeight, scene.cameraRadius * std::sin(angle));
+        camera.setCameraPosition(eye);
+        camera.setCameraLookAt(scene.cameraTarget);
+        if (light) {
+            // 每帧移动全部灯光并重新上传，分簇结果随之变化
+            for (size_t i = 0; i < baseLights.size(); ++i) {
+                frameLights[i].position.y = baseLights[i].position.y + scene.lights.bobAmplitude * std::sin(0.05f * frame + (float)i);
+            }
+            light->set_dynamicLights(frameLights);
+        }
+
+        unsigned long long profilerFrame = gpuProfiler.get_frameIndex();
+        auto start = std::chrono::high_resolution_clock::now();
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        renderer.renderAll();
+        auto end = std::chrono::high_resolution_clock::now();
+
+        // pbuffer 没有交换链来限制提交队列，每帧结束后等待 GPU，避免排队过深（不计入 CPU 时间）
+        glFinish();
+
+        if (frame < scene.warmupFrames) continue;
+
+        const auto& timings = renderer.get_passTimings();
+
+        double cpuMs = std::chrono::duration<double, std::milli>(end - start).count();
+        json frameJson;
+        frameJson["cpu_ms"] = cpuMs;
+        double renderScale = (double)renderer.get_renderWidth() / scene.width;
+        frameJson["render_scale"] = renderScale;
+        renderScales.push_back(renderScale);
+        json passesJson = json::object();
+        for (const auto& t : timings) {
+            if (passCpu.find(t.name) == passCpu.end()) passNames.push_back(t.name);
+            passCpu[t.name].push_back(t.cpuMs);
+            passesJson[t.name] = { {"cpu_ms", t.cpuMs} };
+        }
+        frameJson["passes"] = passesJson;
+        // 状态切换次数与提交量，用于对比优化前后的调用开销
+        const GLStats::FrameCounters& glFrame = GLStats::getInstance().get_lastFrame();
+        json glJson = json::object();
+        for (int c = 0; c < GLStats::COUNTER_COUNT; ++c) {
+            glCounters[c].push_back((double)glFrame.values[c]);
+            glJson[GLStats::get_counterName(static_cast<GLStats::Counter>(c))] = glFrame.values[c];
+        }
+        frameJson["gl"] = glJson;
+        json cullingJson = json::object();
+        for (const auto& stats : renderer.get_cullingStats()) {
+            cullingJson[stats.name] = { {"drawn", stats.drawn}, {"culled", stats.culled} };
+        }
+        frameJson["culling"] = cullingJson;
+        perFrame.push_back(frameJson);
+        frameCpu.push_back(cpuMs);
+        profilerFrames.push_back(profilerFrame);
+    }
+    renderer.set_passTimingEnabled(false);
+    renderer.set_camera(nullptr);
+
+    // GPU 结果延迟若干帧回读，这里一次性取回并按帧序号对应到 per_frame
+    std::vector<double> frameGpu;
+    std::unordered_map<std::string, std::vector<double>> zoneGpu;
+    std::vector<std::string> zoneNames;
+    if (gpuTiming) {
+        gpuProfiler.flush();
+        std::unordered_map<unsigned long long, const GpuProfiler::FrameResult*> resultByFrame;
+        for (const auto& result : gpuProfiler.get_recordedFrames()) {
+            resultByFrame[result.frame] = &result;
+        }
+        for (size_t i = 0; i < profilerFrames.size(); ++i) {
+            auto it = resultByFrame.find(profilerFrames[i]);
+            if (it == resultByFrame.end()) continue;   // 该帧的查询被丢弃
+            const GpuProfiler::FrameResult& result = *it->second;
+            frameGpu.push_back(result.totalMs);
+            perFrame[i]["gpu_ms"] = result.totalMs;
+            for (const auto& zone : result.zones) {
+                if (zoneGpu.find(zone.path) == zoneGpu.end()) zoneNames.push_back(zone.path);
+                zoneGpu[zone.path].push_back(zone.ms);
+                if (zone.depth == 0) perFrame[i]["passes"][zone.path]["gpu_ms"] = zone.ms;
+            }
+        }
+        gpuProfiler.set_recording(false);
+        gpuProfiler.clear_recordedFrames();
+    }
+
+    json report;
+    report["scene"] = scene.name;
+    report["width"] = scene.width;
+    report["height"] = scene.height;
+    report["models"] = modelCount;
+    report["lights"] = scene.lights.count;
+    report["depth_prepass"] = scene.depthPrepass;
+    report["compact_gbuffer"] = scene.compactGBuffer;
+    report["gbuffer_bytes_per_pixel"] = renderer.get_gBufferBytesPerPixel();
+    report["ssao"] = {
+        {"resolution_divisor", ambientOcclusion.get_resolutionDivisor()},
+        {"kernel_size", ambientOcclusion.get_kernelSize()},
+        {"blur", ambientOcclusion.is_blurEnabled()},
+        {"temporal", ambientOcclusion.is_temporalEnabled()},
+        {"temporal_samples", ambientOcclusion.get_temporalSampleCount()}
+    };
+    report["dynamic_resolution"] = {
+        {"enabled", renderer.is_dynamicResolutionEnabled()},
+        {"target_ms", dynamicResolution.get_targetFrameMs()},
+        {"min_scale", dynamicResolution.get_minScale()},
+        {"render_scale", summarize(renderScales)}
+    };
+    // 帧缓冲池：场景结束时池中的帧缓冲和附件纹理（含上一个场景闲置未满 MAX_IDLE_FRAMES 帧的）与纹理的累计创建次数
+    FramebufferPool& framebufferPool = renderer.get_framebufferPool();
+    report["framebuffer_pool"] = {
+        {"framebuffers", framebufferPool.get_framebufferCount()},
+        {"textures", framebufferPool.get_textureCount()},
+        {"bytes", framebufferPool.get_allocatedBytes()},
+        {"allocations", framebufferPool.get_allocationCount()}
+    };
+    // 渲染图：最后一帧实际执行的通道顺序，以及被剔除（产出无人读取）和关闭的通道
+    RenderGraph& renderGraph = renderer.get_renderGraph();
+    json executedPasses = json::array();
+    for (const auto& step : renderGraph.get_steps()) executedPasses.push_back(step.pass->get_name());
+    report["render_graph"] = {
+        {"passes", executedPasses},
+        {"culled", renderGraph.get_culledPasses()},
+        {"disabled", renderGraph.get_disabledPasses()}
+    };
+    report["warmup_frames"] = scene.warmupFrames;
+    report["frames"] = scene.frames;
+    report["frame"] = { {"cpu_ms", summarize(frameCpu)}, {"gpu_ms", summarize(frameGpu)} };
+    json passes = json::array();
+    for (const auto& name : passNames) {
+        passes.push_back({ {"name", name}, {"cpu_ms", summarize(passCpu[name])}, {"gpu_ms", summarize(zoneGpu[name])} });
+    }
+    report["passes"] = passes;
+    // 包含通道内子阶段（如 "PBR/SSAO"）的 GPU 统计
+    json gpuZones = json::array();
+    for (const auto& name : zoneNames) {
+        gpuZones.push_back({ {"name", name}, {"gpu_ms", summarize(zoneGpu[name])} });
+    }
+    report["gpu_zones"] = gpuZones;
+    json glStats = json::object();
+    for (int c = 0; c < GLStats::COUNTER_COUNT; ++c) {
+        glStats[GLStats::get_counterName(static_cast<GLStats::Counter>(c))] = summarize(glCounters[c]);
+    }
+    report["gl_stats"] = glStats;
+    report["per_frame"] = perFrame;
+    return report;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> scenePaths;
+    std::string outPath = "bench_report.json";
+    int framesOverride = -1;
+    bool gpuTiming = true;
+    bool renderQueue = true;
+    bool culling = true;
+    bool sceneBVH = true;
+    bool multiDraw = false;
+    bool gpuCulling = false;
+    bool occlusion = false;
+    bool softwareOcclusion = false;
+    bool occlusionQueries = false;
+    bool clusteredLighting = true;
+    bool depthPrepass = false;
+    bool compactGBuffer = false;
+    bool ssaoFull = false;
+    bool ssaoTemporal = false;
+    bool dynamicResolution = false;
+    std::string tracePath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (arg == "--frames" && i + 1 < argc) {
+            framesOverride = std::atoi(argv[++i]);
+        } else if (arg == "--no-gpu-timing") {
+            gpuTiming = false;
+        } else if (arg == "--no-render-queue") {
+            renderQueue = false;
+        } else if (arg == "--no-culling") {
+            culling = false;
+        } else if (arg == "--no-bvh") {
+            sceneBVH = false;
+        } else if (arg == "--multi-draw") {
+            multiDraw = true;
+        } else if (arg == "--gpu-culling") {
+            gpuCulling = true;
+        } else if (arg == "--occlusion") {
+            // 遮挡剔除依赖 GPU 剔除
+            gpuCulling = true;
+            occlusion = true;
+        } else if (arg == "--sw-occlusion") {
+            softwareOcclusion = true;
+        } else if (arg == "--occlusion-queries") {
+            occlusionQueries = true;
+        } else if (arg == "--no-clustered-lighting") {
+            clusteredLighting = false;
+        } else if (arg == "--depth-prepass") {
+            depthPrepass = true;
+        } else if (arg == "--compact-gbuffer") {
+            compactGBuffer = true;
+        } else if (arg == "--ssao-full") {
+            ssaoFull = true;
+        } else if (arg == "--ssao-temporal") {
+            ssaoTemporal = true;
+        } else if (arg == "--dynamic-resolution") {
+            dynamicResolution = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else {
+            scenePaths.push_back(arg);
+        }
+    }
+    if (scenePaths.empty() && std::filesystem::is_directory("res/bench")) {
+        for (const auto& entry : std::filesystem::directory_iterator("res/bench")) {
+            if (entry.path().extension() == ".json") scenePaths.push_back(entry.path().string());
+        }
+        std::sort(scenePaths.begin(), scenePaths.end());
+    }
+    if (scenePaths.empty()) {
+        std::cerr << "No bench scenes found." << std::endl;
+        return -1;
+    }
+#ifndef ENABLE_CPU_PROFILER
+    if (!tracePath.empty()) {
+        std::cerr << "--trace ignored: built without ENABLE_CPU_PROFILER" << std::endl;
+        tracePath.clear();
+    }
+#endif
+    CPU_PROFILE_THREAD_NAME("Main");
+
+    if (!GlobalSettings::getInstance().LoadFromFile("res/settings.json")) {
+        std::cerr << "Failed to load settings.\n";
+    }
+
+    // 同一进程内只初始化一次渲染器，所有场景共用同一分辨率（取第一个场景）
+    std::vector<BenchScene> scenes;
+    for (const auto& path : scenePaths) {
+        BenchScene scene;
+        if (!loadScene(path, scene)) return -1;
+        if (framesOverride > 0) scene.frames = framesOverride;
+        if (depthPrepass) scene.depthPrepass = true;
+        if (compactGBuffer) scene.compactGBuffer = true;
+        if (ssaoFull) {
+            // 原来的 SSAO：全分辨率 64 个采样，不模糊
+            scene.ssaoResolutionDivisor = 1;
+            scene.ssaoKernelSize = 64;
+            scene.ssaoBlur = false;
+        }
+        if (ssaoTemporal) scene.ssaoTemporal = true;
+        if (dynamicResolution) scene.dynamicResolution = true;
+        if (!scenes.empty()) {
+            scene.width = scenes.front().width;
+            scene.height = scenes.front().height;
+        }
+        scenes.push_back(scene);
+    }
+    GlobalSettings::getInstance().SetInt("SCREEN_WIDTH", scenes.front().width);
+    GlobalSettings::getInstance().SetInt("SCREEN_HEIGHT", scenes.front().height);
+
+    HeadlessContext context;
+    if (!context.create(scenes.front().width, scenes.front().height)) return -1;
+
+    glViewport(0, 0, scenes.front().width, scenes.front().height);
+    glEnable(GL_DEPTH_TEST);
+
+    json report;
+    report["gl_renderer"] = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    report["gl_version"] = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    report["gpu_timing"] = gpuTiming;
+    report["render_queue"] = renderQueue;
+    report["frustum_culling"] = culling;
+    report["scene_bvh"] = sceneBVH;
+    report["multi_draw"] = multiDraw;
+    report["gpu_culling"] = gpuCulling;
+    report["occlusion_culling"] = occlusion;
+    report["software_occlusion"] = softwareOcclusion;
+    report["occlusion_queries"] = occlusionQueries;
+    report["clustered_lighting"] = clusteredLighting;
+
+    Renderer& renderer = Renderer::getInstance();
+    renderer.set_headless(true);
+    renderer.set_renderQueueEnabled(renderQueue);
+    renderer.set_frustumCullingEnabled(culling);
+    renderer.set_sceneBVHEnabled(sceneBVH);
+    renderer.set_multiDrawEnabled(multiDraw);
+    renderer.set_gpuCullingEnabled(gpuCulling);
+    renderer.set_occlusionCullingEnabled(occlusion);
+    renderer.set_softwareOcclusionEnabled(softwareOcclusion);
+    renderer.set_occlusionQueriesEnabled(occlusionQueries);
+    renderer.set_clusteredLightingEnabled(clusteredLighting);
+    renderer.initialize();
+
+    json sceneReports = json::array();
+    for (const auto& scene : scenes) {
+        std::cout << "Running scene: " << scene.name << std::endl;
+        renderer.clear_scene();
+        sceneReports.push_back(runScene(scene, gpuTiming));
+    }
+    renderer.clear_scene();
+    report["scenes"] = sceneReports;
+
+    std::ofstream outFile(outPath);
+    if (!outFile.is_open()) {
+        std::cerr << "Failed to write report: " << outPath << std::endl;
+        GpuProfiler::getInstance().shutdown();
+        context.destroy();
+        return -1;
+    }
+    outFile << report.dump(4);
+    std::cout << "Report written to " << outPath << std::endl;
+
+#ifdef ENABLE_CPU_PROFILER
+    if (!tracePath.empty() && CpuProfiler::getInstance().exportChromeTrace(tracePath)) {
+        std::cout << "CPU trace written to " << tracePath << std::endl;
+    }
+#endif
+
+    GpuProfiler::getInstance().shutdown();
+    context.destroy();
+    return 0;
+}
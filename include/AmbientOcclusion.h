@@ -0,0 +1,104 @@
+#pragma once
+#include <glad/glad.h>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "BufferObject.h"
+
+class Shader;
+class Texture;
+class Mesh;
+
+// 屏幕空间环境光遮蔽（SSAO）
+// 遮蔽在 1/resolutionDivisor 分辨率下计算，结果与该像素到摄像机的距离一起写入 RG16F 的低分辨率缓冲；
+// 之后可选做两次一维的双边模糊（按距离和法线差异降低权重，避免跨越几何边缘），
+// 最后按距离加权的双线性插值上采样到全分辨率的目标帧缓冲（分辨率因子为 1 时省略上采样）。
+// 采样内核放在 UBO 中，只在内核大小改变时上传。
+// 动态分辨率下 G-Buffer 与 target 只有左下角的渲染区域有效：缓冲按 target 的完整大小分配，各阶段只绘制对应的子区域。
+// 时域模式下每帧只取完整内核中交错的一小组采样并旋转噪声，再按上一帧的视图投影矩阵重投影历史结果混合：
+// 重投影点的距离与历史中记录的距离不符（被遮挡或刚露出）时丢弃历史，几帧之后收敛到完整内核的质量。
+class AmbientOcclusion {
+public:
+    // 与 SSAO.shader 一致
+    static const GLuint KERNEL_UBO_BINDING = 1;
+    static const int MAX_KERNEL_SIZE = 64;
+
+    // SSAO 读取的 G-Buffer 输入
+    struct GBufferInputs {
+        GLuint position = 0;        // 完整布局为 gPosition（a 分量为到摄像机的距离），紧凑布局为深度纹理
+        GLuint normal = 0;          // 完整布局为世界空间法线，紧凑布局为八面体编码
+        bool compact = false;
+        glm::mat4 inverseViewProjection = glm::mat4(1.0f);  // 紧凑布局重建位置用
+        // 时域模式重投影用（上一帧的摄像机）
+        glm::mat4 previousViewProjection = glm::mat4(1.0f);
+        glm::vec3 previousViewPosition = glm::vec3(0.0f);
+        // G-Buffer 中有效的渲染区域，为 0 时取 target 的大小
+        int width = 0;
+        int height = 0;
+    };
+
+    AmbientOcclusion() = default;
+    ~AmbientOcclusion();
+    AmbientOcclusion(const AmbientOcclusion&) = delete;
+    AmbientOcclusion& operator=(const AmbientOcclusion&) = delete;
+
+    // 计算遮蔽并写入 target 的第 0 个颜色附件（渲染分辨率，r 分量为遮蔽因子）
+    void compute(Shader* ssaoShader, const GBufferInputs& gBuffer, Framebuffer& target, Mesh& screen, float strength);
+
+    // 分辨率因子：1 为全分辨率，2 为一半，4 为四分之一
+    void set_resolutionDivisor(int divisor);
+    int get_resolutionDivisor() const { return resolutionDivisor; }
+    // 每像素采样数，范围 [1, MAX_KERNEL_SIZE]，改变后重新生成并上传内核
+    void set_kernelSize(int size);
+    int get_kernelSize() const { return kernelSize; }
+    // 深度/法线感知的可分离模糊
+    void set_blurEnabled(bool enabled) { blurEnabled = enabled; }
+    bool is_blurEnabled() const { return blurEnabled; }
+    // 时域累积：开启后每帧采样 temporalSampleCount 个点（取代 kernelSize），切换时丢弃历史
+    void set_temporalEnabled(bool enabled);
+    bool is_temporalEnabled() const { return temporalEnabled; }
+    void set_temporalSampleCount(int count);
+    int get_temporalSampleCount() const { return temporalSampleCount; }
+    // 完整覆盖一遍内核所需的帧数，也是历史累积的上限
+    int get_temporalFrameCount() const { return MAX_KERNEL_SIZE / temporalSampleCount; }
+    // 丢弃历史，下一帧只用当前结果（摄像机跳变、场景切换时调用）
+    void reset_history() { historyValid = false; }
+
+    // 本帧低分辨率遮蔽的大小
+    int get_width() const { return viewportWidth; }
+    int get_height() const { return viewportHeight; }
+
+private:
+    static Shader* get_blur_shader();       // 懒加载，推迟到 OpenGL 上下文创建之后编译
+    static Shader* get_upsample_shader();
+    static Shader* get_temporal_shader();
+
+    // 目标分辨率或分辨率因子变化时重新分配时域历史（其余低分辨率缓冲每次从帧缓冲池申请）
+    void resize(int targetWidth, int targetHeight);
+    void uploadKernel();
+    // position / normal 选择要绑定的输入（各着色器只声明用到的采样器）
+    static void bindGBuffer(Shader* shader, const GBufferInputs& gBuffer, bool position, bool normal);
+    // 半球内的采样点，越靠近原点越密集
+    static std::vector<glm::vec3> generateKernel(int kernelSize);
+
+    int resolutionDivisor = 2;
+    int kernelSize = 16;
+    bool blurEnabled = true;
+    bool temporalEnabled = false;
+    int temporalSampleCount = 8;
+
+    int width = 0;      // 低分辨率缓冲的大小（遮蔽与距离为 RG16F，模糊时在两个之间来回交换，只在 compute() 内持有）
+    int height = 0;
+    int viewportWidth = 0;      // 本帧使用的区域（渲染分辨率 / resolutionDivisor），改变时历史作废
+    int viewportHeight = 0;
+
+    // 首次使用时创建（需要 OpenGL 上下文）
+    std::unique_ptr<Texture> noiseTexture;      // 4x4 随机旋转
+    std::unique_ptr<UBO> kernelUBO;             // vec4 samples[MAX_KERNEL_SIZE]
+    int uploadedKernelSize = 0;                 // UBO 中的内核大小，时域模式始终为完整内核
+    std::unique_ptr<Framebuffer> historyFramebuffers[2];    // 时域历史：r 遮蔽，g 距离，b 已累积的帧数，每帧交换读写
+    int historyIndex = 0;                       // 本帧写入的历史
+    bool historyValid = false;
+    unsigned int frameIndex = 0;
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cfloat>
+
+// 轴对齐包围盒
+struct AABB {
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+
+    inline bool is_valid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+    inline glm::vec3 center() const { return (min + max) * 0.5f; }
+    inline glm::vec3 extent() const { return (max - min) * 0.5f; }
+
+    inline void expand(const glm::vec3& point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+    inline void expand(const AABB& other) {
+        if (!other.is_valid()) return;
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    // 变换后重新求包围盒（结果仍是轴对齐的，会比原物体略大）
+    AABB transformed(const glm::mat4& matrix) const;
+};
+
+// 射线与包围盒求交（slab 方法），invDirection 为方向的倒数，命中时返回进入距离
+bool intersectRayAABB(const glm::vec3& origin, const glm::vec3& invDirection, const AABB& box, float maxDistance, float& tEnter);
+
+// 包围球
+struct BoundingSphere {
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = -1.0f;   // 小于 0 表示无效
+
+    inline bool is_valid() const { return radius >= 0.0f; }
+};
+
+// 视锥体（6 个朝内的平面），也可以表示任意由 6 个平面围成的凸体（如点光源的阴影范围）
+class Frustum {
+public:
+    enum Plane { Left, Right, Bottom, Top, Near, Far, PLANE_COUNT };
+    enum class Containment { Outside, Intersects, Inside };
+
+    Frustum() = default;
+    // 从（投影 * 观察）矩阵提取平面
+    explicit Frustum(const glm::mat4& viewProjection);
+    // 轴对齐的盒子
+    static Frustum from_box(const glm::vec3& center, const glm::vec3& halfExtent);
+
+    // 保守测试：返回 false 时一定在体外，返回 true 时可能相交
+    bool intersects(const BoundingSphere& sphere) const;
+    bool intersects(const AABB& box) const;
+    // 区分完全在内和部分相交，层次遍历时完全在内的子树不必再测试
+    Containment classify(const AABB& box) const;
+
+    // 6 个平面，顺序同 Plane，供上传到着色器
+    const glm::vec4* get_planes() const { return planes; }
+
+private:
+    glm::vec4 planes[PLANE_COUNT];  // xyz 为法线（已归一化），w 为距离，内侧 dot(n, p) + w >= 0
+};
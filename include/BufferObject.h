@@ -1,8 +1,10 @@
 #pragma once
 #include <glad/glad.h>
 #include <vector>
+#include <algorithm>
 #include <iostream>
-#include "GlobalSettings.h"
+#include <stdexcept>
+#include "GLStats.h"
 
 namespace {
 
@@ -21,7 +23,7 @@ public:
         glGenBuffers(1, &m_RendererID);
         glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);  
         // 把用户定义的数据复制到当前绑定缓冲, GL_STATIC_DRAW ：数据不会或几乎不会改变; GL_DYNAMIC_DRAW：数据会被改变很多; GL_STREAM_DRAW ：数据每次绘制时都会改变
-        glBufferData(GL_ARRAY_BUFFER, size, data.data(), GL_STATIC_DRAW);
+        gl::bufferData(GL_ARRAY_BUFFER, size, data.data(), GL_STATIC_DRAW);
     }
 
     ~VertexBuffer();
@@ -73,34 +75,35 @@ public:
         static_assert(sizeof(T) == 0, "push is not supported for this type");
     }
 
-    template<>
-    void push<float>(unsigned int count)
-    {   
-        BufferLayoutElement element = {GL_FLOAT, count, GL_FALSE};
-        m_Elements.push_back(element);
-        m_Stride += count * sizeof(GL_FLOAT);
-    }
-
-    template<>
-    void push<unsigned int>(unsigned int count)
-    {   
-        BufferLayoutElement element = {GL_UNSIGNED_INT, count, GL_FALSE};
-        m_Elements.push_back(element);
-        m_Stride += count * sizeof(GL_UNSIGNED_INT);
-    }
-
-    template<>
-    void push<unsigned char>(unsigned int count)
-    {   
-        BufferLayoutElement element = {GL_UNSIGNED_BYTE, count, GL_TRUE};
-        m_Elements.push_back(element);
-        m_Stride += count * sizeof(GL_UNSIGNED_BYTE);
-    }
-
     inline unsigned int get_stride() const {return m_Stride;};
     inline const std::vector<BufferLayoutElement>& get_element() const {return m_Elements;};
     
 };
+
+// 显式特化需放在命名空间作用域（GCC/Clang 不支持类内特化）
+template<>
+inline void VertexBufferLayout::push<float>(unsigned int count)
+{   
+    BufferLayoutElement element = {GL_FLOAT, count, GL_FALSE};
+    m_Elements.push_back(element);
+    m_Stride += count * sizeof(GL_FLOAT);
+}
+
+template<>
+inline void VertexBufferLayout::push<unsigned int>(unsigned int count)
+{   
+    BufferLayoutElement element = {GL_UNSIGNED_INT, count, GL_FALSE};
+    m_Elements.push_back(element);
+    m_Stride += count * sizeof(GL_UNSIGNED_INT);
+}
+
+template<>
+inline void VertexBufferLayout::push<unsigned char>(unsigned int count)
+{   
+    BufferLayoutElement element = {GL_UNSIGNED_BYTE, count, GL_TRUE};
+    m_Elements.push_back(element);
+    m_Stride += count * sizeof(GL_UNSIGNED_BYTE);
+}
 }
 
 class VertexArrayObject
@@ -140,6 +143,7 @@ public:
 
     void bind();
     void unbind();
+    inline unsigned int get_id() const { return m_RendererID; }
     
 };
 
@@ -170,6 +174,33 @@ public:
 
 
 
+// glDrawElementsIndirect / glMultiDrawElementsIndirect 的命令格式
+struct DrawElementsIndirectCommand {
+    GLuint count;           // 索引数
+    GLuint instanceCount;
+    GLuint firstIndex;      // 在索引缓冲中的起始位置（元素数）
+    GLint baseVertex;       // 加到每个索引上的顶点偏移
+    GLuint baseInstance;
+};
+
+// 间接绘制命令缓冲（GL_DRAW_INDIRECT_BUFFER），容量不足时按两倍扩容
+class IndirectBuffer {
+public:
+    IndirectBuffer();
+    ~IndirectBuffer();
+    IndirectBuffer(const IndirectBuffer&) = delete;
+    IndirectBuffer& operator=(const IndirectBuffer&) = delete;
+
+    void updateData(const std::vector<DrawElementsIndirectCommand>& commands);
+    void bind() const;
+    void unbind() const;
+    inline GLuint get_id() const { return buffer; }
+
+private:
+    GLuint buffer;
+    size_t capacity = 0;    // 命令数
+};
+
 template <typename T>
 class SSBO {
 public:
@@ -177,8 +208,9 @@ public:
      * @brief 构造函数，创建一个 Shader Storage Buffer Object (SSBO)
      * @param bindingPoint 绑定点索引
      * @param maxDataSize 最大数据容量（元素数量）
+     * @param usage 用途提示，实例、逐绘制数据和灯光每帧都会重写，默认 GL_DYNAMIC_DRAW
      */
-    SSBO(GLuint bindingPoint, unsigned int maxDataSize);
+    SSBO(GLuint bindingPoint, unsigned int maxDataSize, GLenum usage = GL_DYNAMIC_DRAW);
     
     /**
      * @brief 析构函数，释放 SSBO 资源
@@ -192,6 +224,23 @@ public:
      * @throws std::runtime_error 如果数据超出缓冲区大小
      */
     void updateData(const std::vector<T>& data, size_t offset = 0);
+
+    /**
+     * @brief 重新分配缓冲区（原有数据丢弃），用于容量不足时扩容
+     * @param maxDataSize 新的最大数据容量（元素数量）
+     */
+    void resize(unsigned int maxDataSize);
+    /**
+     * @brief 保证至少能容纳 count 个元素，不足时按两倍扩容（原有数据丢弃）
+     */
+    void reserve(size_t count);
+    size_t get_capacity() const { return bufferSize / sizeof(T); }
+
+    /**
+     * @brief 重新绑定到绑定点，多个 SSBO 共用同一绑定点时在绘制前调用
+     */
+    void bindBase() const;
+    inline GLuint get_id() const { return ssbo; }
     
     void bind() const;
     void unbind() const;
@@ -200,14 +249,15 @@ private:
     GLuint ssbo; ///< SSBO 句柄
     GLuint bindingPoint; ///< 绑定点索引
     size_t bufferSize; ///< SSBO 分配的缓冲区大小（字节）
+    GLenum usage; ///< glBufferData 的用途提示，扩容时沿用
 };
 
 template <typename T>
-SSBO<T>::SSBO(GLuint bindingPoint, unsigned int maxDataSize) : bindingPoint(bindingPoint){
+SSBO<T>::SSBO(GLuint bindingPoint, unsigned int maxDataSize, GLenum usage) : bindingPoint(bindingPoint), usage(usage){
     bufferSize = maxDataSize * sizeof(T);
     glGenBuffers(1, &ssbo);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, bufferSize, nullptr, GL_STATIC_DRAW);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bufferSize, nullptr, usage);
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, ssbo);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
@@ -224,10 +274,30 @@ void SSBO<T>::updateData(const std::vector<T>& data, size_t offset) {
         throw std::runtime_error("SSBO::updateData: Data exceeds buffer size");
     }
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
-    glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, dataSize, data.data());
+    gl::bufferSubData(GL_SHADER_STORAGE_BUFFER, offset, dataSize, data.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+template <typename T>
+void SSBO<T>::resize(unsigned int maxDataSize) {
+    bufferSize = maxDataSize * sizeof(T);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bufferSize, nullptr, usage);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, ssbo);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
+template <typename T>
+void SSBO<T>::reserve(size_t count) {
+    if (count <= get_capacity()) return;
+    resize(static_cast<unsigned int>(std::max(count, get_capacity() * 2)));
+}
+
+template <typename T>
+void SSBO<T>::bindBase() const {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, ssbo);
+}
+
 template <typename T>
 void SSBO<T>::bind() const {
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
@@ -280,7 +350,7 @@ public:
     // 更新指定偏移量的数据
     void UpdateData(const void* data, size_t size, size_t customOffset) {
         Bind();
-        glBufferSubData(GL_UNIFORM_BUFFER, customOffset, size, data);
+        gl::bufferSubData(GL_UNIFORM_BUFFER, customOffset, size, data);
         Unbind();
     }
 
@@ -314,7 +384,8 @@ class Framebuffer {
             GLenum type;
         };
     
-        Framebuffer(int width, int height, const std::vector<AttachmentConfig>& attachments, bool useDepth = true, bool useStencil = true)
+        // depthTexture 为真时深度（模板）附件用纹理代替渲染缓冲，之后的通道可以采样（如 Hi-Z 构建）
+        Framebuffer(int width, int height, const std::vector<AttachmentConfig>& attachments, bool useDepth = true, bool useStencil = true, bool depthTexture = false)
             : width(width), height(height), useDepth(useDepth), useStencil(useStencil), colorAttachments(attachments.size()) {
             glGenFramebuffers(1, &fbo);
             glBindFramebuffer(GL_FRAMEBUFFER, fbo);
@@ -340,7 +411,16 @@ class Framebuffer {
             }
     
             // 创建深度和模板缓冲
-            if (useDepth || useStencil) {
+            if (depthTexture && useDepth) {
+                glGenTextures(1, &depthTextureID);
+                glBindTexture(GL_TEXTURE_2D, depthTextureID);
+                allocateDepthTexture();
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, useStencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTextureID, 0);
+            } else if (useDepth || useStencil) {
                 glGenRenderbuffers(1, &rbo);
                 glBindRenderbuffer(GL_RENDERBUFFER, rbo);
                 if (useDepth && useStencil) {
@@ -359,20 +439,50 @@ class Framebuffer {
             glBindFramebuffer(GL_FRAMEBUFFER, 0);
         }
     
+        // 用已分配好的纹理组装帧缓冲（帧缓冲池的附件纹理），不持有这些纹理；depthTexture 为 0 时没有深度附件
+        Framebuffer(int width, int height, const std::vector<GLuint>& colorTextures, GLuint depthTexture, bool useStencil)
+            : textures(colorTextures), depthTextureID(depthTexture), width(width), height(height),
+              useDepth(depthTexture != 0), useStencil(useStencil), colorAttachments(colorTextures.size()), ownsTextures(false) {
+            glGenFramebuffers(1, &fbo);
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            std::vector<GLenum> drawBuffers;
+            for (int i = 0; i < colorAttachments; ++i) {
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, textures[i], 0);
+                drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + i);
+            }
+            if (colorAttachments > 1) {
+                glDrawBuffers(drawBuffers.size(), drawBuffers.data());
+            }
+            if (depthTextureID) {
+                glFramebufferTexture2D(GL_FRAMEBUFFER, useStencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTextureID, 0);
+            }
+
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+                std::cerr << "ERROR: Framebuffer is not complete!" << std::endl;
+            }
+
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+    
         ~Framebuffer() {
             glDeleteFramebuffers(1, &fbo);
-            glDeleteTextures(textures.size(), textures.data());
+            if (ownsTextures) {
+                glDeleteTextures(textures.size(), textures.data());
+                if (depthTextureID) {
+                    glDeleteTextures(1, &depthTextureID);
+                }
+            }
             if (rbo) {
                 glDeleteRenderbuffers(1, &rbo);
             }
         }
     
         void bind() const {
-            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            gl::bindFramebuffer(GL_FRAMEBUFFER, fbo);
         }
     
         void unbind() const {
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            gl::bindFramebuffer(GL_FRAMEBUFFER, 0);
         }
     
         // 获取帧缓冲的结果
@@ -382,14 +492,38 @@ class Framebuffer {
             }
             return 0;
         }
+        // 深度纹理，未使用深度纹理时返回 0
+        GLuint get_depthTexture() const { return depthTextureID; }
+        int get_width() const { return width; }
+        int get_height() const { return height; }
     
-        void switch_depth_component_to_default() {
-            glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0); // 写入到默认帧缓冲
-            glBlitFramebuffer(
-              0, 0, GlobalSettings::getInstance().GetInt("SCREEN_WIDTH"), GlobalSettings::getInstance().GetInt("SCREEN_HEIGHT"), 0, 0, GlobalSettings::getInstance().GetInt("SCREEN_WIDTH"), GlobalSettings::getInstance().GetInt("SCREEN_HEIGHT"), GL_DEPTH_BUFFER_BIT, GL_NEAREST);
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        // 把 source 的深度纹理直接挂到本帧缓冲上，两者共用同一份深度（不复制）；source 为空时换回自己的深度附件。
+        // 深度附件没有变化时不做任何事
+        void share_depth(const Framebuffer* source) {
+            GLuint texture = source ? source->depthTextureID : 0;
+            if (texture == sharedDepthTextureID) return;
+            sharedDepthTextureID = texture;
+            gl::bindFramebuffer(GL_FRAMEBUFFER, fbo);
+            // 先同时摘掉深度和模板，再按来源的格式挂上
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, 0);
+            if (texture) {
+                glFramebufferTexture2D(GL_FRAMEBUFFER, source->useStencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+            } else if (depthTextureID) {
+                glFramebufferTexture2D(GL_FRAMEBUFFER, useStencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTextureID, 0);
+            } else if (rbo) {
+                glFramebufferRenderbuffer(GL_FRAMEBUFFER, useStencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rbo);
+            }
+            gl::bindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+
+        // 把左下角 srcWidth x srcHeight 的区域复制到 drawFramebuffer 左下角 dstWidth x dstHeight 的区域（大小不同时按 filter 缩放）
+        void blit_to(GLuint drawFramebuffer, int srcWidth, int srcHeight, int dstWidth, int dstHeight, GLbitfield mask, GLenum filter = GL_NEAREST) const {
+            gl::bindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+            gl::bindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer);
+            gl::blitFramebuffer(0, 0, srcWidth, srcHeight, 0, 0, dstWidth, dstHeight, mask, filter);
+            gl::bindFramebuffer(GL_FRAMEBUFFER, 0);
         }
+        GLuint get_fbo() const { return fbo; }
 
         // 直接重新创建会更方便，这个用不上
         void resize(int newWidth, int newHeight, const std::vector<AttachmentConfig>& attachments) {
@@ -403,6 +537,10 @@ class Framebuffer {
                 glTexImage2D(GL_TEXTURE_2D, 0, attachments[i].internalFormat, width, height, 0, attachments[i].format, attachments[i].type, nullptr);
             }
     
+            if (depthTextureID) {
+                glBindTexture(GL_TEXTURE_2D, depthTextureID);
+                allocateDepthTexture();
+            }
             if (rbo) {
                 glBindRenderbuffer(GL_RENDERBUFFER, rbo);
                 if (useDepth && useStencil) {
@@ -416,10 +554,22 @@ class Framebuffer {
         }
     
     private:
+        // 格式与渲染缓冲版本相同
+        void allocateDepthTexture() {
+            if (useStencil) {
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+            } else {
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+            }
+        }
+
         GLuint fbo;
         std::vector<GLuint> textures;
+        GLuint depthTextureID = 0;
         GLuint rbo = 0;
+        GLuint sharedDepthTextureID = 0;    // share_depth() 挂上的其他帧缓冲的深度纹理，0 为使用自己的
         int width, height;
         bool useDepth, useStencil;
         int colorAttachments;
+        bool ownsTextures = true;   // 为假时纹理属于帧缓冲池，析构时只删除帧缓冲对象
     };
@@ -35,6 +35,10 @@ private:
     // 最终的摄像机变换矩阵
     glm::mat4 viewProjectionMatrix;
 
+    // 上一帧结束时的变换矩阵和位置，用于时域重投影
+    glm::mat4 previousViewProjectionMatrix;
+    glm::vec3 previousPos;
+
     // 摄像机移动速度和鼠标灵敏度
     float cameraSpeed;
     float cameraSensitivity;
@@ -58,9 +62,19 @@ public:
     // 一些访问接口
     inline const glm::mat4& getViewMatrix() const {return viewMatrix;}
     inline const glm::mat4& getViewProjectionMatrix() const {return viewProjectionMatrix;}
+    inline const glm::mat4& getProjectionMatrix() const {return projectionMatrix;}
 
     inline const float getCameraSensitivity() const {return cameraSensitivity;}
     inline const glm::vec3 getCameradirection() const {return direction;}
+    inline const glm::vec3& getCameraPosition() const {return pos;}
+    inline float getNearPlane() const {return nearPlane;}
+    inline float getFarPlane() const {return farPlane;}
+    inline bool isOrthographic() const {return orthographic;}
+    inline const glm::mat4& getPreviousViewProjectionMatrix() const {return previousViewProjectionMatrix;}
+    inline const glm::vec3& getPreviousCameraPosition() const {return previousPos;}
+
+    // 一帧结束时调用（Renderer::renderAll），记录本帧的矩阵和位置作为下一帧的"上一帧"
+    void endFrame();
 
     // 处理按键
     void processKey(bool Press_W, bool Press_A, bool Press_S, bool Press_D, float deltaTime);
@@ -0,0 +1,51 @@
+#pragma once
+#include <glad/glad.h>
+#include <memory>
+#include <glm/glm.hpp>
+
+#include "BufferObject.h"
+
+class Camera;
+class Light;
+class Shader;
+
+// 分簇（froxel）光照剔除
+// 视锥在屏幕上分为 GRID_X x GRID_Y 个瓦片，深度方向按指数分为 GRID_Z 层（越远越厚），每个格子为一个簇。
+// 每帧由计算着色器求出每个簇的观察空间包围盒，对照 Light 的 SSBO（绑定点 1）中所有灯光的影响球测试，
+// 相交的灯光序号写入该簇在索引缓冲中的固定区段（最多 MAX_LIGHTS_PER_CLUSTER 个）。
+// 光照阶段由像素的屏幕位置和观察空间深度找到所属的簇，只计算其中的灯光；平行光影响范围无限，出现在每个簇中。
+class ClusteredLighting {
+public:
+    // 与 Light_cluster.shader 和使用分簇结果的光照着色器一致
+    static const GLuint CLUSTER_COUNT_BINDING = 9;
+    static const GLuint CLUSTER_INDEX_BINDING = 10;
+    static const int GRID_X = 16;
+    static const int GRID_Y = 9;
+    static const int GRID_Z = 24;
+    static const int MAX_LIGHTS_PER_CLUSTER = 256;
+    static const unsigned int WORKGROUP_SIZE = 128;
+
+    ClusteredLighting() = default;
+    ClusteredLighting(const ClusteredLighting&) = delete;
+    ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+
+    // 按摄像机当前的投影划分簇，并把 light 中的全部灯光分配到簇中
+    void cull(const Camera& camera, Light& light);
+    // 光照阶段读取簇所需的 uniform（观察矩阵与远近平面），需在同一帧的 cull() 之后调用
+    void bind(Shader* shader) const;
+
+    static int get_clusterCount() { return GRID_X * GRID_Y * GRID_Z; }
+    int get_lightCount() const { return lightCount; }
+
+private:
+    static Shader* get_cull_shader();  // 懒加载，推迟到 OpenGL 上下文创建之后编译
+
+    glm::mat4 viewMatrix = glm::mat4(1.0f);
+    float nearPlane = 0.1f;
+    float farPlane = 100.0f;
+    int lightCount = 0;
+
+    // 首次使用时创建（需要 OpenGL 上下文），大小只由簇的数量决定
+    std::unique_ptr<SSBO<GLuint>> countSSBO;    // 每个簇的灯光数
+    std::unique_ptr<SSBO<GLuint>> indexSSBO;    // 每个簇 MAX_LIGHTS_PER_CLUSTER 个灯光序号
+};
@@ -0,0 +1,88 @@
+#pragma once
+// CPU 计时器
+// 用 CPU_PROFILE_SCOPE("名字") 标记作用域，结束时记录一次耗时区间。
+// 每个线程写入自己的环形缓冲（无锁），导出为 Chrome/Perfetto 的 trace JSON（chrome://tracing 或 ui.perfetto.dev 打开）。
+// 只有定义了 ENABLE_CPU_PROFILER 时才会编译进来，否则宏展开为空语句。
+
+#ifdef ENABLE_CPU_PROFILER
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class CpuProfiler {
+public:
+    static const size_t EVENTS_PER_THREAD = 1 << 18;   // 写满后覆盖最旧的记录
+
+    struct Event {
+        const char* name;   // 必须是静态存储期的字符串（字面量）
+        uint64_t startNs;
+        uint64_t durationNs;
+    };
+
+    static CpuProfiler& getInstance() {
+        static CpuProfiler instance;
+        return instance;
+    }
+
+    CpuProfiler(const CpuProfiler&) = delete;
+    CpuProfiler& operator=(const CpuProfiler&) = delete;
+
+    // 相对于计时器创建时刻的纳秒数
+    uint64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    // 写入当前线程的缓冲，不加锁
+    void record(const char* name, uint64_t startNs, uint64_t endNs);
+    // 设置当前线程在 trace 中显示的名称
+    void set_threadName(const std::string& name);
+
+    // 导出与清空应在其他线程不再记录时调用
+    bool exportChromeTrace(const std::string& filename) const;
+    void clear();
+
+private:
+    CpuProfiler() : epoch(std::chrono::steady_clock::now()) {}
+
+    struct ThreadBuffer {
+        std::unique_ptr<Event[]> events;
+        std::atomic<uint64_t> count{0};     // 累计写入数量，release 写 / acquire 读
+        uint32_t threadId = 0;
+        std::string name;
+    };
+    ThreadBuffer& threadBuffer();
+
+    std::chrono::steady_clock::time_point epoch;
+    mutable std::mutex registryMutex;   // 只在线程首次记录（注册缓冲）和导出时使用
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+class CpuProfileScope {
+public:
+    explicit CpuProfileScope(const char* name) : name(name), startNs(CpuProfiler::getInstance().now()) {}
+    ~CpuProfileScope() { CpuProfiler::getInstance().record(name, startNs, CpuProfiler::getInstance().now()); }
+
+    CpuProfileScope(const CpuProfileScope&) = delete;
+    CpuProfileScope& operator=(const CpuProfileScope&) = delete;
+
+private:
+    const char* name;
+    uint64_t startNs;
+};
+
+#define CPU_PROFILE_CONCAT_IMPL(a, b) a##b
+#define CPU_PROFILE_CONCAT(a, b) CPU_PROFILE_CONCAT_IMPL(a, b)
+#define CPU_PROFILE_SCOPE(name) CpuProfileScope CPU_PROFILE_CONCAT(cpuProfileScope_, __LINE__)(name)
+#define CPU_PROFILE_THREAD_NAME(name) CpuProfiler::getInstance().set_threadName(name)
+
+#else
+
+#define CPU_PROFILE_SCOPE(name) ((void)0)
+#define CPU_PROFILE_THREAD_NAME(name) ((void)0)
+
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+#include <deque>
+
+// 动态分辨率控制器
+// 收集最近 historyLength 帧的 GPU 耗时（来自 GpuProfiler，回读有几帧延迟），平均值超出预算或明显低于预算时
+// 按像素数与耗时成正比估计新的比例（比例的平方与耗时成正比），量化到 SCALE_STEP 后生效。
+// 比例改变后丢弃旧样本，只采用新比例下渲染的帧，避免在回读延迟期间反复调整。
+class DynamicResolution {
+public:
+    static constexpr float SCALE_STEP = 0.05f;
+
+    // 每回读到一帧的 GPU 耗时调用一次；frame 为该帧在 GpuProfiler 中的序号，nextFrame 为下一帧的序号
+    // 返回比例是否改变
+    bool addSample(unsigned long long frame, double gpuMs, unsigned long long nextFrame);
+    // 比例回到上限并清空样本
+    void reset();
+
+    float get_scale() const { return scale; }
+    void set_targetFrameMs(float ms) { targetFrameMs = ms > 0.1f ? ms : 0.1f; }
+    float get_targetFrameMs() const { return targetFrameMs; }
+    void set_minScale(float minScale);
+    float get_minScale() const { return minScale; }
+    void set_maxScale(float maxScale);
+    float get_maxScale() const { return maxScale; }
+    void set_historyLength(int length) { historyLength = length > 1 ? length : 1; }
+    int get_historyLength() const { return historyLength; }
+    // 最近一次决策所用的平均 GPU 耗时
+    double get_averageFrameMs() const { return averageFrameMs; }
+
+private:
+    float scale = 1.0f;
+    float targetFrameMs = 16.6f;
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    float headroom = 0.85f;         // 平均耗时低于预算的这一比例时才放大，避免在预算附近来回切换
+    int historyLength = 8;
+
+    std::deque<double> samples;
+    unsigned long long settleFrame = 0;     // 早于这一帧的样本属于旧比例
+    double averageFrameMs = 0.0;
+};
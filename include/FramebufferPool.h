@@ -0,0 +1,82 @@
+#pragma once
+#include <glad/glad.h>
+#include <memory>
+#include <vector>
+
+#include "BufferObject.h"
+
+// 帧缓冲池
+// 通道按格式和大小申请帧缓冲，只在用到的那段时间持有：acquire() 之后由通道 release() 归还。
+// 复用以单张附件纹理为单位：每个颜色附件和深度附件按（格式, 大小）从池中取一张空闲纹理，再组装成帧缓冲，
+// 因此生命周期不重叠的通道即使附件组合不同，同格式同大小的附件也共用同一块显存（如 OIT 的 RGBA16F 复用 G-Buffer 归还的 gPosition）。
+// 组装出的帧缓冲对象按所用的纹理缓存，每帧申请顺序不变时不会重新创建；
+// 连续 MAX_IDLE_FRAMES 帧没有被申请的纹理（分辨率改变、通道关闭后的旧附件）在 endFrame() 中释放。
+// 深度附件总是纹理（Desc::depthTexture 为假时同样可用）。归还后内容不保留，使用前需自行清除。
+class FramebufferPool {
+public:
+    static const int MAX_IDLE_FRAMES = 16;
+
+    struct Desc {
+        int width = 0;
+        int height = 0;
+        std::vector<Framebuffer::AttachmentConfig> attachments;
+        bool useDepth = false;
+        bool useStencil = false;
+        bool depthTexture = false;      // 之后的通道要采样深度；池中的深度附件总是纹理
+    };
+
+    FramebufferPool() = default;
+    ~FramebufferPool();
+    FramebufferPool(const FramebufferPool&) = delete;
+    FramebufferPool& operator=(const FramebufferPool&) = delete;
+
+    // 申请一个符合描述的帧缓冲，需要成对调用 release()
+    Framebuffer* acquire(const Desc& desc);
+    void release(Framebuffer* framebuffer);
+
+    // 帧边界，由 Renderer::renderAll() 调用：释放长期闲置的纹理
+    void endFrame();
+    // 释放所有未被持有的纹理和帧缓冲
+    void trim();
+
+    int get_framebufferCount() const { return static_cast<int>(framebuffers.size()); }
+    int get_textureCount() const { return static_cast<int>(textures.size()); }
+    int get_inUseCount() const;
+    // 池中所有附件纹理的显存估算（字节）
+    size_t get_allocatedBytes() const;
+    // 累计创建的附件纹理数，稳定运行时不应增长
+    int get_allocationCount() const { return allocationCount; }
+
+private:
+    struct TextureKey {
+        Framebuffer::AttachmentConfig config;
+        int width = 0;
+        int height = 0;
+
+        bool operator==(const TextureKey& other) const;
+    };
+    struct TextureEntry {
+        TextureKey key;
+        GLuint texture = 0;
+        bool inUse = false;
+        unsigned long long lastUsedFrame = 0;
+    };
+    // 由池中纹理组装的帧缓冲，附件纹理（颜色附件依次排列，深度附件在最后）完全相同时复用
+    struct FramebufferEntry {
+        std::vector<GLuint> attachments;
+        std::unique_ptr<Framebuffer> framebuffer;
+        bool inUse = false;
+    };
+
+    GLuint acquireTexture(const TextureKey& key);
+    void releaseTexture(GLuint texture);
+    // 删除满足条件的空闲纹理，以及引用它们的帧缓冲
+    template <typename Predicate>
+    void eraseTextures(Predicate predicate);
+    static TextureKey depthKey(const Desc& desc);
+
+    std::vector<TextureEntry> textures;
+    std::vector<FramebufferEntry> framebuffers;
+    unsigned long long frame = 0;
+    int allocationCount = 0;
+};
@@ -0,0 +1,148 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// GL 调用层
+// GL_CALL 在调用后检查错误；会改变状态或提交工作的 GL 调用改用下面 gl:: 中的同名包装，
+// 调用时自动累加到当前帧的统计中，计数不会与实际调用脱节（创建资源时的调用不经过包装，不计入）。
+// GL_COUNT 只用于不对应单个 GL 调用的量（如间接绘制的三角形数）。帧边界由 Renderer::renderAll() 划分。
+#define GL_CALL(func) \
+    func; \
+    checkGLError(__FILE__, __LINE__)
+
+#define GL_COUNT(counter, amount) \
+    GLStats::getInstance().add(GLStats::counter, (amount))
+
+void checkGLError(const char* file, int line);
+
+class GLStats {
+public:
+    enum Counter {
+        DrawCalls,
+        Triangles,
+        ProgramBinds,
+        VertexArrayBinds,
+        TextureBinds,
+        UniformUploads,
+        BufferUploads,
+        BufferUploadBytes,
+        FramebufferBinds,
+        Blits,
+        Copies,
+        ComputeDispatches,
+        COUNTER_COUNT
+    };
+
+    // 一帧的计数结果
+    struct FrameCounters {
+        unsigned long long frame = 0;
+        uint64_t values[COUNTER_COUNT] = {};
+    };
+
+    static GLStats& getInstance() {
+        static GLStats instance;
+        return instance;
+    }
+
+    GLStats(const GLStats&) = delete;
+    GLStats& operator=(const GLStats&) = delete;
+
+    // 计数项在 JSON/界面中的名称，如 "draw_calls"
+    static const char* get_counterName(Counter counter);
+
+    void add(Counter counter, uint64_t amount) { current.values[counter] += amount; }
+
+    // 帧边界，由 Renderer::renderAll() 调用；帧外的调用（如加载资源）在下一次 beginFrame 时清零，不计入任何帧
+    void beginFrame();
+    void endFrame();
+
+    // 上一个完整帧的计数（当前帧还未结束，ImGui 显示的是这一份）
+    const FrameCounters& get_lastFrame() const { return lastFrame; }
+
+    // 开启后保留每一帧的计数，可导出为 JSON
+    void set_recording(bool recording) { this->recording = recording; }
+    bool is_recording() const { return recording; }
+    const std::vector<FrameCounters>& get_recordedFrames() const { return recordedFrames; }
+    void clear_recordedFrames() { recordedFrames.clear(); }
+    bool exportJson(const std::string& filename) const;
+
+private:
+    GLStats() = default;
+
+    FrameCounters current;
+    FrameCounters lastFrame;
+    unsigned long long frameCounter = 0;
+    bool recording = false;
+    std::vector<FrameCounters> recordedFrames;
+};
+
+// 计数的 GL 调用，参数与对应的 gl* 函数相同
+namespace gl {
+inline void useProgram(GLuint program) {
+    glUseProgram(program);
+    GL_COUNT(ProgramBinds, 1);
+}
+// glUniform* 各版本参数不同，统一经过这里计数，如 gl::uniform(glUniform1f, location, value)
+template <typename Func, typename... Args>
+inline void uniform(Func func, Args... args) {
+    func(args...);
+    GL_COUNT(UniformUploads, 1);
+}
+inline void bindVertexArray(GLuint array) {
+    glBindVertexArray(array);
+    GL_COUNT(VertexArrayBinds, 1);
+}
+inline void bindTexture(GLenum target, GLuint texture) {
+    glBindTexture(target, texture);
+    GL_COUNT(TextureBinds, 1);
+}
+inline void bindFramebuffer(GLenum target, GLuint framebuffer) {
+    glBindFramebuffer(target, framebuffer);
+    GL_COUNT(FramebufferBinds, 1);
+}
+inline void bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    glBufferData(target, size, data, usage);
+    GL_COUNT(BufferUploads, 1);
+    GL_COUNT(BufferUploadBytes, size);
+}
+inline void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    glBufferSubData(target, offset, size, data);
+    GL_COUNT(BufferUploads, 1);
+    GL_COUNT(BufferUploadBytes, size);
+}
+inline void drawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+    glDrawElements(mode, count, type, indices);
+    GL_COUNT(DrawCalls, 1);
+    if (mode == GL_TRIANGLES) GL_COUNT(Triangles, count / 3);
+}
+inline void drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount) {
+    glDrawElementsInstanced(mode, count, type, indices, instanceCount);
+    GL_COUNT(DrawCalls, 1);
+    if (mode == GL_TRIANGLES) GL_COUNT(Triangles, (uint64_t)(count / 3) * instanceCount);
+}
+// 间接绘制的三角形数在命令缓冲里，由调用方在已知时用 GL_COUNT(Triangles, ...) 累加
+inline void multiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride) {
+    glMultiDrawElementsIndirect(mode, type, indirect, drawCount, stride);
+    GL_COUNT(DrawCalls, 1);
+}
+inline void multiDrawElementsIndirectCount(GLenum mode, GLenum type, const void* indirect, GLintptr drawCount, GLsizei maxDrawCount, GLsizei stride) {
+    glMultiDrawElementsIndirectCount(mode, type, indirect, drawCount, maxDrawCount, stride);
+    GL_COUNT(DrawCalls, 1);
+}
+inline void dispatchCompute(GLuint groupsX, GLuint groupsY, GLuint groupsZ) {
+    glDispatchCompute(groupsX, groupsY, groupsZ);
+    GL_COUNT(ComputeDispatches, 1);
+}
+inline void blitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter) {
+    glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+    GL_COUNT(Blits, 1);
+}
+inline void copyImageSubData(GLuint srcName, GLenum srcTarget, GLint srcLevel, GLint srcX, GLint srcY, GLint srcZ,
+                             GLuint dstName, GLenum dstTarget, GLint dstLevel, GLint dstX, GLint dstY, GLint dstZ,
+                             GLsizei width, GLsizei height, GLsizei depth) {
+    glCopyImageSubData(srcName, srcTarget, srcLevel, srcX, srcY, srcZ, dstName, dstTarget, dstLevel, dstX, dstY, dstZ, width, height, depth);
+    GL_COUNT(Copies, 1);
+}
+}
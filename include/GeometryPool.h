@@ -0,0 +1,62 @@
+#pragma once
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "BufferObject.h"
+
+class Mesh;
+
+// 共享几何缓冲
+// 所有参与多重间接绘制的静态网格从同一对顶点/索引缓冲中分配范围，共用一个 VAO，
+// 这样整批绘制只需绑定一次 VAO。网格在第一次以多重绘制方式提交时登记（acquire），析构时自动释放；
+// 登记或释放后下一次 sync() 从所有在册网格重新生成缓冲（静态几何很少变化，整体重建最简单，也顺带压缩了空洞）。
+// 另有一份只含位置的顶点流（索引和范围相同），只写深度的通道用它减少顶点读取量。
+class GeometryPool {
+public:
+    static GeometryPool& getInstance() {
+        static GeometryPool instance;
+        return instance;
+    }
+
+    // 网格在共享缓冲中的位置，对应 DrawElementsIndirectCommand 的 firstIndex / count / baseVertex
+    struct Range {
+        unsigned int firstIndex = 0;
+        unsigned int indexCount = 0;
+        int baseVertex = 0;
+    };
+
+    // 登记网格，已登记时直接返回；新登记的网格要在 sync() 之后范围才有效
+    void acquire(Mesh* mesh);
+    void release(Mesh* mesh);
+    // 有变化时重建共享缓冲并重新计算所有范围
+    void sync();
+    const Range& get_range(const Mesh* mesh) const { return ranges.at(mesh); }
+
+    void bind();
+    void unbind();
+    // 只含位置的 VAO（location 0），用于深度预渲染和阴影等只写深度的通道
+    void bindPositions();
+    void unbindPositions();
+
+    int get_meshCount() const { return static_cast<int>(meshes.size()); }
+    size_t get_vertexCount() const { return vertexCount; }
+    size_t get_indexCount() const { return indexCount; }
+    int get_rebuildCount() const { return rebuildCount; }
+
+private:
+    GeometryPool() = default;
+    ~GeometryPool();
+    GeometryPool(const GeometryPool&) = delete;
+    GeometryPool& operator=(const GeometryPool&) = delete;
+
+    std::vector<Mesh*> meshes;
+    std::unordered_map<const Mesh*, Range> ranges;
+    std::unique_ptr<VertexArrayObject> VAO;
+    std::unique_ptr<VertexArrayObject> positionVAO;
+    bool dirty = false;
+
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    int rebuildCount = 0;
+};
@@ -0,0 +1,98 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "BufferObject.h"
+#include "Bounds.h"
+#include "InstancedModel.h"
+
+class Model;
+class Mesh;
+class HiZBuffer;
+class Shader;
+class Texture;
+
+// 参与 GPU 剔除的网格，与 Cull_frustum.shader 中的 CullObject 布局一致（std430）
+struct CullObject {
+    glm::mat4 modelMatrix;
+    glm::vec4 sphere;       // xyz 为世界空间球心，w 为半径（小于 0 表示总是可见）
+    glm::uvec4 draw;        // x indexCount，y firstIndex，z baseVertex，w 材质槽
+    glm::uvec4 batch;       // x 批次序号，y 批次第一条命令的位置，z 是否可见，w 保留
+};
+
+// GPU 视锥剔除
+// 一组模型的所有网格登记到 GeometryPool，网格参数常驻 SSBO。每帧由计算着色器逐网格测试包围球，
+// 可见的网格通过原子计数压缩写入间接命令缓冲（每个材质批次占一段连续区域），逐绘制数据写入绑定点 2，
+// 再以 glMultiDrawElementsIndirectCount 提交，绘制数量直接从 GPU 端的计数缓冲读取，CPU 不回读。
+// 几何着色器沿用多重间接绘制的路径（multiDraw + drawOffset + gl_DrawID），不需要额外修改。
+//
+// 遮挡剔除分两个阶段：Visible 只绘制上一帧可见（且在视锥内）的网格，用其深度构建 Hi-Z 后，
+// Occlusion 对全部网格做视锥 + Hi-Z 测试，补画本帧新出现的网格，并记下每个网格的可见性供下一帧使用。
+// 两个阶段的命令写入不同区域，第二阶段的计算着色器不会覆盖第一阶段仍在使用的命令。
+class GpuCulling {
+public:
+    static const GLuint DRAW_DATA_BINDING = InstancedModel::INSTANCE_BINDING;
+    static const GLuint OBJECT_BINDING = 5;
+    static const GLuint COMMAND_BINDING = 6;
+    static const GLuint COUNT_BINDING = 7;
+    static const GLuint VISIBILITY_BINDING = 8;
+    static const unsigned int WORKGROUP_SIZE = 64;
+
+    enum class Phase {
+        Single,     // 只做视锥剔除
+        Visible,    // 遮挡剔除第一阶段：上一帧可见的网格
+        Occlusion   // 遮挡剔除第二阶段：对照 Hi-Z 测试全部网格，只输出第一阶段没画过的
+    };
+
+    GpuCulling() = default;
+    GpuCulling(const GpuCulling&) = delete;
+    GpuCulling& operator=(const GpuCulling&) = delete;
+
+    // 场景结构或共享几何缓冲变化时重建对象列表和批次，否则只在网格变换/可视性变化时重新上传对象数据。
+    // depthOnly 时所有网格合为一批（阴影通道不绑定材质）
+    void update(const std::vector<std::shared_ptr<Model>>& models, bool depthOnly = false);
+    // 运行剔除计算着色器，frustum 为空时使用 CameraUBO 中的观察投影矩阵。
+    // 遮挡剔除的两个阶段只用于摄像机（frustum 为空），Occlusion 阶段需要传入本帧已构建的 hiZ
+    void cull(const Frustum* frustum = nullptr, Phase phase = Phase::Single, const HiZBuffer* hiZ = nullptr);
+    // 提交剔除后的绘制，需在同一阶段的 cull() 之后调用；命令保留到下一次同阶段的 cull()，可以重复提交。
+    // depthOnly 时不绑定材质，并使用只含位置的顶点流
+    void draw(Shader* shader, bool depthOnly = false, Phase phase = Phase::Single);
+
+    int get_objectCount() const { return static_cast<int>(objects.size()); }
+    int get_batchCount() const { return static_cast<int>(batches.size()); }
+    int get_rebuildCount() const { return rebuildCount; }
+
+private:
+    static Shader* get_cull_shader();  // 懒加载，推迟到 OpenGL 上下文创建之后编译
+    void rebuild(const std::vector<std::shared_ptr<Model>>& models, bool depthOnly);
+    void refreshObjects();
+    // Occlusion 阶段使用第二段命令区域和计数
+    static int regionOf(Phase phase) { return phase == Phase::Occlusion ? 1 : 0; }
+
+    struct Batch {
+        Texture* texture;   // 为空时不绑定材质
+        int first;          // 批次在命令缓冲中的起始位置
+        int count;          // 批次最多容纳的命令数
+    };
+
+    std::vector<Mesh*> meshes;
+    std::vector<CullObject> objects;
+    std::vector<Batch> batches;
+
+    // 判断是否需要重建/重新上传
+    const void* modelList = nullptr;
+    size_t modelCount = 0;
+    bool builtDepthOnly = false;
+    unsigned int sceneVersion = 0;
+    int poolRebuildCount = -1;
+    unsigned long long meshVersion = 0;
+    int rebuildCount = 0;
+
+    // 首次使用时创建（需要 OpenGL 上下文），容量不足时按两倍扩容
+    std::unique_ptr<SSBO<CullObject>> objectSSBO;
+    std::unique_ptr<SSBO<DrawElementsIndirectCommand>> commandSSBO;
+    std::unique_ptr<SSBO<GLuint>> countSSBO;
+    std::unique_ptr<SSBO<InstanceData>> drawDataSSBO;
+    std::unique_ptr<SSBO<GLuint>> visibilitySSBO;  // 每个网格上一帧是否可见（遮挡剔除）
+};
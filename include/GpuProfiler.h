@@ -0,0 +1,131 @@
+#pragma once
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+
+// GPU 计时器
+// 每个计时区间用一对 GL_TIMESTAMP 查询记录起止时间（GL_TIME_ELAPSED 不允许嵌套，而通道内还有子阶段），
+// 查询对象按帧组成环形缓冲，结果在 FRAMES_IN_FLIGHT 帧之后才回读，因此不会阻塞管线。
+class GpuProfiler {
+public:
+    static const int FRAMES_IN_FLIGHT = 4;  // 回读延迟的帧数
+    static const int HISTORY_SIZE = 240;    // 每个区间保留的历史样本数（用于 ImGui 曲线）
+
+    // 单个区间在某一帧的耗时
+    struct ZoneResult {
+        std::string path;   // 以 '/' 连接的层级名，如 "PBR/SSAO"
+        int depth;
+        double ms;
+    };
+    // 一帧完整的计时结果
+    struct FrameResult {
+        unsigned long long frame;
+        double totalMs;
+        std::vector<ZoneResult> zones;
+    };
+    // 区间的滑动统计
+    struct ZoneHistory {
+        int depth = 0;
+        std::deque<float> samples;
+        double lastMs = 0.0;
+        double average() const;
+    };
+
+    static GpuProfiler& getInstance() {
+        static GpuProfiler instance;
+        return instance;
+    }
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    void set_enabled(bool enabled);
+    bool is_enabled() const { return enabled; }
+    // 下一帧的序号（基准测试用来把结果对应回帧）
+    unsigned long long get_frameIndex() const { return frameCounter; }
+
+    // 帧边界，由 Renderer::renderAll() 调用
+    void beginFrame();
+    void endFrame();
+
+    // 区间可以嵌套，必须成对调用
+    void beginZone(const char* name);
+    void endZone();
+
+    // 阻塞读取所有未完成的查询（基准测试结束或导出前调用）
+    void flush();
+    // 释放查询对象，必须在 OpenGL 上下文销毁之前调用（单例析构时上下文已经不在了）
+    void shutdown();
+
+    // 时间序列记录：开启后保留每一帧的完整结果，可导出为 JSON
+    void set_recording(bool recording) { this->recording = recording; }
+    bool is_recording() const { return recording; }
+    const std::vector<FrameResult>& get_recordedFrames() const { return recordedFrames; }
+    void clear_recordedFrames() { recordedFrames.clear(); }
+    bool exportTimeSeries(const std::string& filename) const;
+
+    // 按首次出现顺序排列的区间统计
+    const std::vector<std::string>& get_zoneOrder() const { return zoneOrder; }
+    const ZoneHistory* get_zoneHistory(const std::string& path) const;
+    const std::deque<float>& get_frameHistory() const { return frameHistory; }
+    // 最近一次回读到的帧（序号与 get_frameIndex() 一致），还没有结果时返回 false
+    bool get_lastFrame(unsigned long long& frame, double& ms) const {
+        frame = lastFrame;
+        ms = lastFrameMs;
+        return hasLastFrame;
+    }
+
+private:
+    GpuProfiler() = default;
+    ~GpuProfiler() = default;
+
+    struct PendingZone {
+        std::string path;
+        int depth;
+        GLuint beginQuery;
+        GLuint endQuery;
+    };
+    // 环形缓冲中的一帧
+    struct FrameSlot {
+        std::vector<GLuint> queryPool;
+        size_t usedQueries = 0;
+        GLuint frameBegin = 0;
+        GLuint frameEnd = 0;
+        std::vector<PendingZone> zones;
+        unsigned long long frame = 0;
+        bool pending = false;
+    };
+
+    GLuint acquireQuery(FrameSlot& slot);
+    bool collect(FrameSlot& slot, bool wait);   // 读取一帧的结果，wait 为 false 时结果未就绪则放弃
+    void pushHistory(const FrameResult& result);
+
+    bool enabled = false;
+    bool inFrame = false;
+    bool recording = false;
+    unsigned long long frameCounter = 0;
+    FrameSlot slots[FRAMES_IN_FLIGHT];
+
+    std::vector<std::string> zoneStack;     // 当前打开的区间路径
+    std::vector<size_t> openZoneIndex;
+
+    std::vector<std::string> zoneOrder;
+    std::unordered_map<std::string, ZoneHistory> zoneHistories;
+    std::deque<float> frameHistory;
+    unsigned long long lastFrame = 0;
+    double lastFrameMs = 0.0;
+    bool hasLastFrame = false;
+    std::vector<FrameResult> recordedFrames;
+};
+
+// 作用域内自动开始/结束一个 GPU 计时区间
+class GpuProfileScope {
+public:
+    explicit GpuProfileScope(const char* name) { GpuProfiler::getInstance().beginZone(name); }
+    ~GpuProfileScope() { GpuProfiler::getInstance().endZone(); }
+
+    GpuProfileScope(const GpuProfileScope&) = delete;
+    GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+};
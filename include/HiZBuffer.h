@@ -0,0 +1,35 @@
+#pragma once
+#include <glad/glad.h>
+
+class Shader;
+
+// 层次深度缓冲（Hi-Z）
+// 深度纹理逐级取 2x2 最大值（最远深度）生成的 mip 链，第 0 级为深度纹理的一半分辨率。
+// 遮挡测试时按物体屏幕投影的大小选一级，最多读 2x2 个纹素：物体最近深度比这些纹素都远则一定被遮挡。
+class HiZBuffer {
+public:
+    HiZBuffer() = default;
+    ~HiZBuffer();
+    HiZBuffer(const HiZBuffer&) = delete;
+    HiZBuffer& operator=(const HiZBuffer&) = delete;
+
+    // depthWidth / depthHeight 为源深度纹理的分辨率，变化时重新分配
+    void resize(int depthWidth, int depthHeight);
+    // 从深度纹理重建整条 mip 链（每级一次计算着色器调度）
+    void build(GLuint depthTexture);
+
+    GLuint get_texture() const { return texture; }
+    int get_width() const { return width; }
+    int get_height() const { return height; }
+    int get_levelCount() const { return levelCount; }
+
+private:
+    static Shader* get_build_shader();  // 懒加载，推迟到 OpenGL 上下文创建之后编译
+
+    GLuint texture = 0;
+    int depthWidth = 0;
+    int depthHeight = 0;
+    int width = 0;      // 第 0 级
+    int height = 0;
+    int levelCount = 0;
+};
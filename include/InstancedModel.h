@@ -0,0 +1,85 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <glm/glm.hpp>
+
+#include "BufferObject.h"
+#include "Bounds.h"
+
+class Model;
+class Shader;
+
+// 每个实例的数据，与着色器中的 InstanceData 布局一致（std430）
+struct InstanceData {
+    glm::mat4 modelMatrix;
+    glm::uvec4 material;    // x 为材质索引，其余保留
+};
+
+// 实例材质：与原型网格的纹理采样结果相乘的系数
+struct InstanceMaterial {
+    glm::vec4 albedo = glm::vec4(1.0f);                 // rgb 反照率，a 透明度
+    glm::vec4 metallicRoughnessAO = glm::vec4(1.0f);    // x 金属度，y 粗糙度，z 环境光遮蔽
+};
+
+// 实例化模型：一份原型几何（Model 的网格、纹理和 VAO）加一组实例变换与材质索引。
+// 实例数据放在 SSBO 中，每个网格每个通道只提交一次 glDrawElementsInstanced；
+// 剔除在 CPU 端逐实例进行，可见实例的索引另存一个 SSBO，由着色器按 gl_InstanceID 间接读取。
+// 实例矩阵代替原型网格自身的模型矩阵。
+class InstancedModel {
+public:
+    static const GLuint INSTANCE_BINDING = 2;
+    static const GLuint MATERIAL_BINDING = 3;
+    static const GLuint VISIBLE_BINDING = 4;
+
+    explicit InstancedModel(std::shared_ptr<Model> prototype);
+    InstancedModel(const InstancedModel&) = delete;
+    InstancedModel& operator=(const InstancedModel&) = delete;
+
+    // 返回实例索引
+    int add_instance(const glm::mat4& modelMatrix, unsigned int materialIndex = 0);
+    int add_instance(const glm::vec3& position, const glm::vec3& rotation = glm::vec3(0.0f),
+                     const glm::vec3& scale = glm::vec3(1.0f), unsigned int materialIndex = 0);
+    void set_instanceTransform(int index, const glm::mat4& modelMatrix);
+    void set_instanceMaterial(int index, unsigned int materialIndex);
+    // 与最后一个实例交换后删除，原最后一个实例的索引变为 index
+    void remove_instance(int index);
+    void clear_instances();
+    inline int get_instanceCount() const {return static_cast<int>(instances.size());}
+
+    // 材质 0 为默认材质（系数全为 1），返回新材质的索引
+    unsigned int add_material(const InstanceMaterial& material);
+    void set_material(unsigned int index, const InstanceMaterial& material);
+
+    // 剔除 frustum 之外的实例后绘制，返回绘制的实例数，剔除的实例数写入 culled。
+    // depthOnly 时不绑定纹理（阴影通道）
+    int draw(Shader* shader, const Frustum* frustum, bool depthOnly, int& culled);
+
+    inline const std::shared_ptr<Model>& get_prototype() const {return prototype;}
+    inline const AABB& get_worldBounds() {updateBounds(); return worldBounds;}
+    // 实例增删或变换改变时更新为新的全局变化版本（材质不影响），阴影缓存据此判断是否重新渲染
+    inline unsigned long long get_version() const {return version;}
+    static unsigned long long get_changeVersion() {return s_ChangeVersion;}
+
+private:
+    void updateBounds();
+    void upload();
+
+    std::shared_ptr<Model> prototype;
+    AABB localBounds;           // 原型所有网格的局部包围盒
+
+    std::vector<InstanceData> instances;
+    std::vector<AABB> instanceBounds;
+    AABB worldBounds;
+    std::vector<InstanceMaterial> materials;
+    std::vector<unsigned int> visibleInstances;
+    bool boundsDirty = true;
+    bool instancesDirty = true;
+    bool materialsDirty = true;
+    unsigned long long version = 0;
+    static unsigned long long s_ChangeVersion;
+
+    // 首次绘制时创建（需要 OpenGL 上下文），容量不足时按两倍扩容
+    std::unique_ptr<SSBO<InstanceData>> instanceSSBO;
+    std::unique_ptr<SSBO<InstanceMaterial>> materialSSBO;
+    std::unique_ptr<SSBO<unsigned int>> visibleSSBO;
+};
@@ -1,11 +1,14 @@
 #pragma once
 #include <vector>
+#include <algorithm>
 #include <glm/glm.hpp>
 #include "Mesh.h"
 #include "Model.h"
 #include "Shader.h"
 #include "GlobalSettings.h"
 #include "BufferObject.h"
+#include "RenderQueue.h"
+#include "GpuCulling.h"
 #include <string>
 
 // 灯光基础信息
@@ -24,37 +27,82 @@ struct LightUnit {
     alignas(4) int visibility = 1;
     alignas(4) int isDirectional = 0;
 
-    alignas(4) float padding1;
+    alignas(4) float radius = 0.0f;     // 点光的影响半径（分簇光照剔除用），不大于 0 时按衰减系数自动计算
     alignas(4) float padding2;
     alignas(4) float padding3;
 };
 
 // 灯光的阴影贴图相关信息
 struct ShadowMapInfo {
-    bool isDirectional;  // true：平行光使用2D阴影；false：点光使用立方体阴影
+    bool isDirectional;  // true：平行光使用级联阴影；false：点光使用立方体阴影
     unsigned int fbo;    // 帧缓冲对象
-    unsigned int texture; // 阴影贴图纹理ID，平行光为2D纹理，点光为立方体纹理
+    unsigned int texture; // 阴影贴图纹理ID，平行光为 2D 纹理数组（每级一层），点光为立方体纹理
+    int width = 0;       // 每层（面）的大小
+    int height = 0;
+    int layers = 1;      // 平行光为级联数，点光为 6
+    std::vector<glm::mat4> cascadeMatrices;     // 平行光：上次渲染时各级的光空间矩阵
+
+    // 静态投射物层：只有存在静态投射物时创建，动态投射物每次在它的副本上叠加绘制
+    unsigned int staticFbo = 0;
+    unsigned int staticTexture = 0;
+    bool staticValid = false;
+
+    // 缓存：记录上次渲染时的灯光与投射物，都没有变化时不重新渲染
+    bool valid = false;
+    glm::vec3 bakedPosition = glm::vec3(0.0f);
+    glm::vec3 bakedDirection = glm::vec3(0.0f);
+    unsigned long long meshVersion = 0;         // Mesh::get_changeVersion()
+    unsigned long long instanceVersion = 0;     // InstancedModel::get_changeVersion()
+    unsigned int sceneVersion = 0;
+    std::vector<const Mesh*> casters;                       // 在影响范围内的网格（排序，移出范围时也要重新渲染）
+    std::vector<const InstancedModel*> instancedCasters;    // 同上（排序）
 };
 
 class Light
 {
 private:
     std::vector<LightUnit> lights;
+    // 不投射阴影的动态点光：数量不受阴影槽限制，在 SSBO 中排在带阴影的灯光之后，由分簇光照计算
+    std::vector<LightUnit> dynamicLights;
     const int MAX_SHADOW_MAP_SLOTS = GlobalSettings::getInstance().GetInt("MAX_SHADOW_MAP_TEXTURE_SLOTS");
     int directionalLightCount = 0;
     int pointLightCount = 0;
     std::vector<ShadowMapInfo> shadowMaps; // 每个灯光对应一个阴影贴图信息
 
     // 阴影贴图尺寸
-    const unsigned int SHADOW_RATE = 1;  // 屏幕的SHADOW_RATE倍分辨率
     const unsigned int CUBE_SHADOW_SIZE = 1024;
 
-    // 平行光的投影矩阵
-    const float orthoSize = 15.0f;
-    glm::mat4 lightProjection = glm::ortho(-orthoSize, orthoSize, -orthoSize, orthoSize, 0.1f, 100.0f);
+    // 平行光级联阴影：摄像机视锥在 shadowDistance 内按实用分割（对数与均匀分割按 cascadeSplitLambda 混合）分为 cascadeCount 段，
+    // 每段用包围球拟合正交投影（旋转摄像机时大小不变），投影中心对齐到纹素，摄像机平移时阴影边缘不闪烁
+    int cascadeCount = 4;
+    int cascadeResolution = 2048;
+    float cascadeSplitLambda = 0.75f;
+    float shadowDistance = 60.0f;
+    // 每一级的正交投影向光源方向额外延伸的距离，级联范围之外、挡在光线路径上的投射物仍然写入阴影
+    const float cascadeCasterDistance = 50.0f;
+    // 最近一次烘焙使用的分割与摄像机观察矩阵，着色器据此选择级联
+    glm::vec4 cascadeSplits = glm::vec4(0.0f);
+    glm::mat4 cascadeViewMatrix = glm::mat4(1.0f);
     // 点阴影远裁剪面
     float far_plane = 20.0f;
 
+    // 阴影只写深度，按着色器和 VAO 排序即可；每个灯光的剔除范围不同，逐个灯光重新收集
+    RenderQueue shadowQueue;
+    GpuCulling shadowCulling;   // 开启 GPU 剔除时代替 shadowQueue，所有灯光共用（每次烘焙前重新剔除）
+    GpuCulling staticShadowCulling;     // 静态投射物层使用，模型列表与 shadowCulling 分开以免来回重建
+
+    // 阴影缓存
+    bool shadowCacheEnabled = true;
+    // 按 Model::is_static() 拆分的投射物，场景版本或模型列表变化时重新拆分
+    std::vector<std::shared_ptr<Model>> staticCasters;
+    std::vector<std::shared_ptr<Model>> dynamicCasters;
+    const std::vector<std::shared_ptr<Model>>* partitionSource = nullptr;
+    size_t partitionSize = 0;
+    unsigned int partitionSceneVersion = 0;
+    // 最近一次 bakeShadows() 中重新渲染和跳过的阴影贴图数
+    int shadowRenderCount = 0;
+    int shadowSkipCount = 0;
+
 
 public:
     Light();
@@ -65,13 +113,42 @@ public:
 
     // 添加灯光
     void add_light(LightUnit lightUnit);
-
-    // 设置灯光的SSBO
+    // 修改带阴影的灯光（移动、转向等），阴影贴图在下次烘焙时重新渲染
+    void set_light(int index, const LightUnit& lightUnit);
+    inline const LightUnit& get_light(int index) const {return lights[index];}
+    // 添加/整体替换不投射阴影的动态点光（每帧移动灯光时调用 set_dynamicLights 重新上传）
+    void add_dynamicLight(LightUnit lightUnit);
+    void set_dynamicLights(const std::vector<LightUnit>& units);
+    // SSBO 中的灯光总数（带阴影的灯光 + 动态点光）
+    int get_lightCount() const { return static_cast<int>(lights.size() + dynamicLights.size()); }
+
+    // 设置灯光数量（只包含带阴影的灯光，逐像素遍历的着色器按顺序对应阴影贴图）
     void set_sUniform_light(Shader* shader);
     void draw(Shader* shader);
 
-    // 烘焙阴影贴图
-    void bakeShadows(Shader* shadowMapShader_directionalLight, Shader* shadowMapShader_pointLight, std::vector<std::shared_ptr<Model>>& models);
+    // 烘焙阴影贴图：灯光没有移动、影响范围内的投射物也没有变化时保留上次的结果。
+    // 静态投射物（Model::set_static）单独缓存一层，只有动态投射物变化时从该层复制后叠加绘制动态投射物
+    void bakeShadows(Shader* shadowMapShader_directionalLight, Shader* shadowMapShader_pointLight, std::vector<std::shared_ptr<Model>>& models,
+                     std::vector<std::shared_ptr<InstancedModel>>& instancedModels);
+
+    // 级联阴影配置：级数 [1, MAX_CASCADES] 和每级分辨率改变时重新创建平行光的阴影贴图
+    static const int MAX_CASCADES = 4;  // 与着色器一致
+    void set_cascadeCount(int count);
+    int get_cascadeCount() const { return cascadeCount; }
+    void set_cascadeResolution(int resolution);
+    int get_cascadeResolution() const { return cascadeResolution; }
+    // 0 为均匀分割，1 为对数分割
+    void set_cascadeSplitLambda(float lambda) { cascadeSplitLambda = glm::clamp(lambda, 0.0f, 1.0f); }
+    float get_cascadeSplitLambda() const { return cascadeSplitLambda; }
+    // 级联覆盖的最远观察距离（不超过摄像机远平面）
+    void set_shadowDistance(float distance) { shadowDistance = std::max(distance, 0.1f); }
+    float get_shadowDistance() const { return shadowDistance; }
+
+    // 关闭后每次烘焙都重新渲染全部阴影贴图（对比用）
+    void set_shadowCacheEnabled(bool enabled);
+    bool is_shadowCacheEnabled() const { return shadowCacheEnabled; }
+    int get_shadowRenderCount() const { return shadowRenderCount; }
+    int get_shadowSkipCount() const { return shadowSkipCount; }
 
     // 绑定使用阴影贴图的着色器
     void bind_shadow(Shader* shader);
@@ -80,9 +157,36 @@ public:
     inline unsigned int get_textureID(int index) {return shadowMaps[index].texture;}
 
     static glm::vec3 hexToVec3(const std::string& hexStr);
+    // 衰减后亮度降到可忽略时的距离
+    static float computeRadius(const LightUnit& lightUnit);
 
 private:
-    // 根据灯光类型初始化阴影贴图
-    void initDirectionalShadowMap(ShadowMapInfo &shadowInfo);
-    void initPointShadowMap(ShadowMapInfo &shadowInfo);
+    // 把两组灯光依次上传到 SSBO，容量不足时扩容
+    void uploadLights();
+    // 根据灯光类型初始化阴影贴图（主贴图和静态层共用）
+    void initDirectionalShadowMap(unsigned int& fbo, unsigned int& texture, int size, int layers);
+    // 级联配置改变后按新的级数和分辨率重建全部平行光的阴影贴图
+    void recreateDirectionalShadowMaps();
+    // 按摄像机更新 cascadeSplits / cascadeViewMatrix，返回摄像机视锥在近、远平面上的角点（世界空间）
+    bool updateCascadeSplits(glm::vec3 nearCorners[4], glm::vec3 farCorners[4], float& cameraNear, float& cameraFar);
+    // 一个平行光各级的光空间矩阵与剔除视锥，influence 为覆盖全部级联的视锥（阴影缓存判断用）
+    void computeCascades(const LightUnit& light, const glm::vec3 nearCorners[4], const glm::vec3 farCorners[4], float cameraNear, float cameraFar,
+                         std::vector<glm::mat4>& matrices, std::vector<Frustum>& frustums, Frustum& influence) const;
+    void initPointShadowMap(unsigned int& fbo, unsigned int& texture, int size);
+    // 绘制一个灯光的阴影投射物：开启 GPU 剔除时走 culling，否则经过 shadowQueue
+    void drawShadowCasters(std::vector<std::shared_ptr<Model>>& models, Shader* shader, const Frustum& lightFrustum, GpuCulling& culling);
+
+    // 阴影缓存
+    void partitionCasters(const std::vector<std::shared_ptr<Model>>& models);
+    // 是否需要重新渲染；staticDirty 返回静态层是否也要重新渲染
+    bool isShadowDirty(const ShadowMapInfo& shadow, const LightUnit& light, const Frustum& lightFrustum,
+                       const std::vector<std::shared_ptr<Model>>& models,
+                       std::vector<std::shared_ptr<InstancedModel>>& instancedModels, bool& staticDirty) const;
+    // 渲染一个灯光的阴影贴图（shader 已设置好该灯光的矩阵）；layer 不小于 0 时只渲染纹理数组的这一层（级联），否则整个贴图一次渲染
+    void renderShadowMap(ShadowMapInfo& shadow, Shader* shader, const Frustum& lightFrustum, bool staticDirty,
+                         std::vector<std::shared_ptr<Model>>& models, std::vector<std::shared_ptr<InstancedModel>>& instancedModels, int layer = -1);
+    // 记录本次渲染时的灯光和影响范围内的投射物
+    void recordShadowCasters(ShadowMapInfo& shadow, const LightUnit& light, const Frustum& lightFrustum,
+                             const std::vector<std::shared_ptr<Model>>& models,
+                             std::vector<std::shared_ptr<InstancedModel>>& instancedModels) const;
 };
\ No newline at end of file
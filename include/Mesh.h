@@ -8,8 +8,11 @@
 
 #include "BufferObject.h"
 #include "Texture.h"
+#include "Bounds.h"
 
 class Shader;
+class SceneBVH;
+class GeometryPool;
 
 struct Vertexdata
 {
@@ -42,6 +45,28 @@ private:
 
     // 可视性
     bool visibility;
+    // 遮挡物：光栅化到软件遮挡缓冲中，自身不参与软件遮挡测试
+    bool occluder = false;
+    // 静态：不会移动的阴影投射物，阴影贴图把它们缓存在单独的一层
+    bool isStatic = false;
+    // 本网格最近一次变化时的全局版本
+    unsigned long long version = 0;
+
+    // 包围体：局部空间在 set_mesh 时计算，世界空间随模型矩阵更新
+    AABB localBounds;
+    BoundingSphere localSphere;
+    AABB worldBounds;
+    BoundingSphere worldSphere;
+
+    // 所在的场景 BVH，包围体变化时通知其重新拟合
+    SceneBVH* bvh = nullptr;
+    int bvhPrimitive = -1;
+
+    // 已登记到共享几何缓冲时不为空，析构或重新设置几何时从中释放
+    GeometryPool* geometryPool = nullptr;
+
+    // 任一网格的变换或可视性变化时递增，缓存了逐网格数据的使用方据此判断是否需要重新上传
+    static unsigned long long s_ChangeVersion;
 
 public:
     Mesh();
@@ -74,15 +99,46 @@ public:
         return model;
     }
 
+    // 世界空间包围体
+    inline const AABB& get_worldBounds() const {return worldBounds;}
+    inline const BoundingSphere& get_worldSphere() const {return worldSphere;}
+    inline const AABB& get_localBounds() const {return localBounds;}
+    inline void set_bvhPrimitive(SceneBVH* bvh, int primitive) {this->bvh = bvh; bvhPrimitive = primitive;}
+    // BVH 重建或析构时解除回指（网格可能已经不在新的图元中）
+    inline void detach_bvh(const SceneBVH* owner) {if (bvh == owner) {bvh = nullptr; bvhPrimitive = -1;}}
+
+    // 世界空间射线与三角形求交，返回 maxDistance 内最近的命中距离（以 direction 长度为单位）
+    bool intersect_ray(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const;
+
     // 设置可视性
     void set_visibility(const bool visiable);
     inline bool get_visibility(){return visibility;}
+    inline void set_occluder(bool occluder) {this->occluder = occluder;}
+    inline bool is_occluder() const {return occluder;}
+    inline void set_static(bool isStatic) {this->isStatic = isStatic;}
+    inline bool is_static() const {return isStatic;}
 
     void draw(Shader* shader = nullptr);
 
+    // 渲染队列使用：状态（着色器、纹理、VAO）由调用方负责，这里只提交绘制调用
+    void drawElements();
+    // 实例化绘制，每个实例的变换由着色器从实例 SSBO 读取
+    void drawElementsInstanced(int instanceCount);
+    inline Texture* get_texture() const {return texture;}
+    inline VertexArrayObject* get_vertexArray() const {return VAO;}
+
+    // 共享几何缓冲使用
+    inline const std::vector<Vertexdata>& get_vertices() const {return vertices;}
+    inline const std::vector<unsigned int>& get_indices() const {return indices;}
+    inline void set_geometryPool(GeometryPool* pool) {geometryPool = pool;}
+    static unsigned long long get_changeVersion() {return s_ChangeVersion;}
+    // 变换或可视性最近一次变化时的 s_ChangeVersion，大于某个记录的版本说明之后变化过
+    inline unsigned long long get_version() const {return version;}
+
 private:
     // 更新模型矩阵
     void updateModelMatrix();
+    void updateWorldBounds();
 
     // 切线和副切线计算函数
     void calculateTangents(
@@ -41,9 +41,20 @@ class Model
         inline void set_position(const glm::vec3& pos) {for(auto mesh : meshes) mesh->set_position(pos);}
         inline void set_scale(const glm::vec3& scl) {for(auto mesh : meshes) mesh->set_scale(scl);}
         inline void set_rotation(const glm::vec3& rot) {for(auto mesh : meshes) mesh->set_rotation(rot);}
+        // 标记为遮挡物（墙、地形等大而近的物体），由 SoftwareOcclusion 光栅化
+        inline void set_occluder(bool occluder) {for(auto mesh : meshes) mesh->set_occluder(occluder);}
+        // 标记为静态（不再移动），阴影贴图把静态投射物缓存在单独的一层；需在加入渲染器之前设置
+        inline void set_static(bool isStatic) {for(auto mesh : meshes) mesh->set_static(isStatic);}
+        bool is_static() const;
 
         void draw(Shader* shader);   
         void draw_outline(Shader* outlineShader = nullptr);
+
+        inline const std::vector<Mesh*>& get_meshes() const {return meshes;}
+
+        // 世界空间包围体：所有网格的并集
+        AABB get_worldBounds() const;
+        BoundingSphere get_worldSphere() const;
     private:
         std::vector<Mesh*> meshes;
         std::string directory;
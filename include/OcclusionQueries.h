@@ -0,0 +1,61 @@
+#pragma once
+#include <glad/glad.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Bounds.h"
+
+class Model;
+class Mesh;
+class Shader;
+
+// 硬件遮挡查询（CHC++ 思路的简化版）
+// 以模型为单位，利用时间连贯性：上一帧可见的模型直接绘制，之后对所有视锥内模型的包围盒发起
+// GL_ANY_SAMPLES_PASSED_CONSERVATIVE 查询（不写颜色和深度）；上一帧不可见的模型用 glBeginConditionalRender 包住，
+// 由 GPU 根据本帧的包围盒查询决定是否光栅化，CPU 不等待结果。查询结果在之后的帧结果可用时才读取，
+// 未返回的查询不会重新发起；可见模型每隔 visibleQueryInterval 帧才查询一次，减少查询数量。
+class OcclusionQueries {
+public:
+    OcclusionQueries() = default;
+    ~OcclusionQueries();
+    OcclusionQueries(const OcclusionQueries&) = delete;
+    OcclusionQueries& operator=(const OcclusionQueries&) = delete;
+
+    // 读取已返回的查询结果，把视锥内的模型分为上一帧可见（直接绘制）和不可见（条件绘制）两组
+    void classify(const std::vector<std::shared_ptr<Model>>& models, const Frustum* frustum);
+    std::vector<std::shared_ptr<Model>>& get_visibleModels() { return visibleModels; }
+    // 在直接绘制的模型之后调用：发起包围盒查询，再以条件渲染绘制不可见组
+    void issue(Shader* shader);
+    // 场景变化时删除所有查询对象
+    void reset();
+
+    void set_visibleQueryInterval(int interval) { visibleQueryInterval = interval > 0 ? interval : 1; }
+    int get_visibleCount() const { return static_cast<int>(visibleModels.size()); }
+    int get_hiddenCount() const { return static_cast<int>(hiddenModels.size()); }
+    int get_hiddenMeshCount() const { return hiddenMeshCount; }
+    int get_frustumCulledMeshCount() const { return frustumCulledMeshCount; }
+    int get_queryCount() const { return queryCount; }
+
+private:
+    static Shader* get_box_shader();    // 懒加载，推迟到 OpenGL 上下文创建之后编译
+
+    struct State {
+        GLuint query = 0;
+        bool visible = true;    // 新模型先视为可见
+        bool pending = false;   // 查询已发起、结果还没读取
+    };
+
+    std::unordered_map<const Model*, State> states;
+    std::vector<std::shared_ptr<Model>> visibleModels;
+    std::vector<std::shared_ptr<Model>> hiddenModels;
+    std::unique_ptr<Mesh> boxMesh;  // [-1, 1] 立方体，按包围盒缩放
+    glm::vec3 viewPosition = glm::vec3(0.0f);
+
+    int visibleQueryInterval = 4;
+    unsigned int frame = 0;
+    unsigned int sceneVersion = 0;
+    int hiddenMeshCount = 0;
+    int frustumCulledMeshCount = 0;
+    int queryCount = 0;
+};
@@ -0,0 +1,92 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "FramebufferPool.h"
+
+class RenderPass;
+
+// 渲染图中的资源名，通道在 declare() 中按这些名字声明读写
+namespace RenderResource {
+    constexpr const char* OccluderDepth = "OccluderDepth";  // CPU 软件遮挡缓冲
+    constexpr const char* CullCommands = "CullCommands";    // GPU 剔除生成的间接绘制命令
+    constexpr const char* Clusters = "Clusters";            // 分簇光照的簇灯光列表
+    constexpr const char* ShadowMaps = "ShadowMaps";        // 灯光的阴影贴图
+    constexpr const char* GBuffer = "GBuffer";              // G-Buffer 的颜色附件（帧缓冲资源），只在延迟光照之前使用
+    constexpr const char* SceneDepth = "SceneDepth";        // 场景深度（只有可采样深度纹理的帧缓冲资源），G-Buffer 阶段写入，
+                                                            // 之后挂在场景缓冲上，使用场景颜色的通道都要声明读取
+    constexpr const char* SceneColor = "SceneColor";        // 渲染器持有的 HDR 场景颜色
+    constexpr const char* Backbuffer = "Backbuffer";        // 窗口，渲染图的输出
+}
+
+// 渲染图
+// 每帧开始时由各通道声明读写的资源，编译出本帧的执行步骤：
+// 1. 关闭的通道（is_enabled() 为假）不参与；
+// 2. 从写入输出资源的通道出发反向查找，产出没有被任何存活通道读取的通道被剔除；
+// 3. 同一资源的写入者按注册顺序先后执行，全部写完之后才执行只读它的通道，其余按注册顺序；
+// 4. 由通道创建（create）的帧缓冲资源在第一个使用它的步骤之前从帧缓冲池申请，最后一个使用它的步骤之后归还，
+//    生命周期不重叠的资源因此可以复用同一块显存。
+// 通道数量很少，每帧重新编译，开关通道后下一帧立即生效。
+class RenderGraph {
+public:
+    // 通道在 declare() 中通过它声明资源
+    class PassBuilder {
+    public:
+        void read(const char* resource);
+        void write(const char* resource);
+        // 由本通道写入并创建的帧缓冲资源，之后的通道用 RenderGraph::get_framebuffer() 取得
+        void create(const char* resource, const FramebufferPool::Desc& desc);
+
+    private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph& graph, int node) : graph(graph), node(node) {}
+        RenderGraph& graph;
+        int node;
+    };
+
+    // 本帧的一个执行步骤
+    struct Step {
+        RenderPass* pass = nullptr;
+        std::vector<int> acquire;   // 执行前申请的帧缓冲资源
+        std::vector<int> release;   // 执行后归还的帧缓冲资源
+    };
+
+    // 收集声明并编译，output 为最终输出的资源
+    void compile(const std::vector<std::unique_ptr<RenderPass>>& passes, const char* output);
+    const std::vector<Step>& get_steps() const { return steps; }
+    // 执行第 i 步前后调用，负责帧缓冲资源的申请与归还
+    void beginStep(size_t i, FramebufferPool& pool);
+    void endStep(size_t i, FramebufferPool& pool);
+
+    // 帧缓冲资源，不在生命周期内（或本帧没有通道创建它）时返回空指针
+    Framebuffer* get_framebuffer(const char* resource) const;
+
+    // 本帧被剔除和关闭的通道名（用于调试显示）
+    const std::vector<const char*>& get_culledPasses() const { return culledPasses; }
+    const std::vector<const char*>& get_disabledPasses() const { return disabledPasses; }
+
+private:
+    struct PassNode {
+        RenderPass* pass = nullptr;
+        std::vector<int> reads;
+        std::vector<int> writes;
+        bool live = false;
+    };
+    struct ResourceNode {
+        std::string name;
+        bool framebufferResource = false;
+        FramebufferPool::Desc desc;
+        Framebuffer* framebuffer = nullptr;
+    };
+
+    int findOrAddResource(const char* name);
+
+    std::vector<PassNode> nodes;
+    std::vector<ResourceNode> resources;
+    std::unordered_map<std::string, int> resourceIndex;
+    std::vector<Step> steps;
+    std::vector<const char*> culledPasses;
+    std::vector<const char*> disabledPasses;
+};
@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Bounds.h"
+#include "BufferObject.h"
+#include "InstancedModel.h"
+
+class Shader;
+class Texture;
+class Mesh;
+class Model;
+class SoftwareOcclusion;
+class SceneBVH;
+
+// 渲染队列
+// 收集可见网格的绘制项，编码 64 位排序键后基数排序，提交时只切换与上一项不同的状态（着色器、材质、VAO）。
+// 排序键从高到低：通道(4) | 着色器(12) | 材质(16) | VAO(16) | 深度(16)
+class RenderQueue {
+public:
+    enum class DepthOrder {
+        None,           // 不按深度排序（阴影等只关心状态切换的通道）
+        FrontToBack,    // 不透明物体，尽早通过深度测试剔除片元
+        BackToFront     // 需要按顺序混合的透明物体
+    };
+
+    struct DrawItem {
+        uint64_t key;
+        Mesh* mesh;
+        Shader* shader;
+        Texture* texture;   // 为空时不绑定材质（沿用当前已绑定的纹理）；图像相同的不同 Texture 视为同一材质
+        unsigned int vertexArray;
+    };
+
+    // 清空绘制项和剔除计数，每帧收集前调用
+    void clear();
+
+    // 收集时用于剔除的体积，传入空指针关闭剔除
+    void set_frustum(const Frustum* frustum);
+    // 收集时附加的软件遮挡测试（只用于摄像机通道），传入空指针关闭；遮挡物自身不参与测试
+    void set_occlusion(const SoftwareOcclusion* occlusion) { this->occlusion = occlusion; }
+
+    // 深度排序使用的观察点；maxDistance 之外的物体深度键饱和
+    void set_view(const glm::vec3& viewPosition, float maxDistance);
+
+    // 收集模型中可见的网格，bindTextures 为 false 时忽略材质（只写深度的通道）
+    void collect(const std::vector<std::shared_ptr<Model>>& models, Shader* shader, unsigned int passIndex = 0,
+                 DepthOrder depthOrder = DepthOrder::FrontToBack, bool bindTextures = true);
+    // 收集已经过视锥剔除的网格（如 SceneBVH 的查询结果），不再做可见性和视锥测试，软件遮挡测试仍然进行
+    void collect(const std::vector<Mesh*>& meshes, Shader* shader, unsigned int passIndex = 0,
+                 DepthOrder depthOrder = DepthOrder::FrontToBack, bool bindTextures = true);
+    // 在 BVH 中查询与 frustum 相交的网格后收集，BVH 剔除掉的网格计入剔除数
+    void collect(const SceneBVH& bvh, const Frustum& frustum, Shader* shader, unsigned int passIndex = 0,
+                 DepthOrder depthOrder = DepthOrder::FrontToBack, bool bindTextures = true);
+    // 计入由外部剔除掉的网格数
+    void add_culledCount(int count) { culledCount += count; }
+
+    // 按排序键排序并提交
+    void sort();
+    void submit();
+    // 多重间接绘制：网格几何来自 GeometryPool，逐绘制数据（模型矩阵、材质槽）写入 SSBO 由着色器按 gl_DrawID 读取，
+    // 每个（着色器, 材质）批次一次 glMultiDrawElementsIndirect。需在 sort() 之后调用。
+    // positionOnly 时使用只含位置的顶点流（只写深度的通道）
+    void submitMultiDraw(bool positionOnly = false);
+
+    size_t size() const { return items.size(); }
+    int get_culledCount() const { return culledCount; }
+    const std::vector<DrawItem>& get_items() const { return items; }
+
+private:
+    bool is_occluded(Mesh* mesh) const;
+    uint32_t get_slot(std::unordered_map<size_t, uint32_t>& slots, size_t id);
+    void push(Mesh* mesh, Shader* shader, uint32_t shaderSlot, unsigned int passIndex, DepthOrder depthOrder, bool bindTextures);
+    void radixSort();
+
+    std::vector<DrawItem> items;
+    std::vector<DrawItem> scratch;  // 基数排序的辅助缓冲，跨帧复用
+    std::vector<Mesh*> bvhMeshes;   // BVH 查询结果，跨帧复用（每个队列一份，各通道互不干扰）
+
+    // 着色器程序、材质（图像组合）映射为本帧内连续的小整数，避免截断后不同对象的键冲突
+    std::unordered_map<size_t, uint32_t> shaderSlots;
+    std::unordered_map<size_t, uint32_t> materialSlots;
+
+    glm::vec3 viewPosition = glm::vec3(0.0f);
+    float maxDistance = 100.0f;
+
+    bool cullingEnabled = false;
+    Frustum frustum;
+    const SoftwareOcclusion* occlusion = nullptr;
+    int culledCount = 0;
+
+    // 多重间接绘制：连续的同着色器、同材质的绘制项合为一批
+    struct MultiDrawBatch {
+        Shader* shader;
+        Texture* texture;
+        int first;      // 批次第一条命令在命令缓冲中的位置
+        int count;
+    };
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<InstanceData> drawData;
+    std::vector<MultiDrawBatch> batches;
+    std::unique_ptr<IndirectBuffer> indirectBuffer;     // 首次使用时创建
+    std::unique_ptr<SSBO<InstanceData>> drawDataSSBO;
+};
@@ -2,29 +2,44 @@
 #include <glad/glad.h>
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include <unordered_map>
 #include <memory>
 
 #include "Shader.h"
 #include "Mesh.h"
 #include "Texture.h"
+#include "GLStats.h"
+#include "RenderQueue.h"
+#include "SceneBVH.h"
+#include "GpuCulling.h"
+#include "HiZBuffer.h"
+#include "SoftwareOcclusion.h"
+#include "OcclusionQueries.h"
+#include "ClusteredLighting.h"
+#include "AmbientOcclusion.h"
+#include "DynamicResolution.h"
+#include "FramebufferPool.h"
+#include "RenderGraph.h"
 
 #include "imgui.h"
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
 
 class Model;
+class InstancedModel;
 class Camera;
 class Light;
 class Renderer;
 
-#define GL_CALL(func) \
-    func; \
-    checkGLError(__FILE__, __LINE__)
-
-void checkGLError(const char* file, int line);
-
-std::vector<glm::vec3> generateSSAOKernel(int kernelSize);   
+// 绘制一组模型：先剔除 frustum 之外的网格，开启渲染队列时排序后提交，否则按插入顺序逐个绘制。
+// depthOnly 用于阴影等只写深度的通道（不绑定材质、不画轮廓，开启多重间接绘制时从共享几何缓冲的位置流提交）。剔除结果以 passName 计入 Renderer 的统计
+// 硬件遮挡查询按帧轮换、只跟踪一组模型，只有不透明几何通道传 occlusionQueries = true
+void drawModels(RenderQueue& queue, std::vector<std::shared_ptr<Model>>& models, Shader* shader,
+                const char* passName, const Frustum* frustum, bool depthOnly = false, bool occlusionQueries = true);
+// 绘制一组实例化模型：逐实例剔除后每个网格一次实例化绘制，剔除结果同样计入 passName（按实例计数）
+void drawInstancedModels(std::vector<std::shared_ptr<InstancedModel>>& instancedModels, Shader* shader,
+                         const char* passName, const Frustum* frustum, bool depthOnly = false);
 
 enum class RenderType{
     Basic,
@@ -35,8 +50,74 @@ class RenderPass {
     public:
         virtual ~RenderPass() = default;
         virtual void execute() = 0;  // 纯虚函数，具体实现由子类完成
+        virtual const char* get_name() const = 0;  // 通道名称，用于性能统计和调试显示
+        // 向渲染图声明本帧读写的资源（见 RenderResource），每帧在执行之前调用
+        virtual void declare(RenderGraph::PassBuilder& builder) = 0;
+        // 关闭的通道不参与本帧的渲染图
+        virtual bool is_enabled() const { return true; }
     };
 
+// 单个渲染通道在一帧内的CPU耗时（毫秒），GPU耗时见 GpuProfiler
+struct PassTiming {
+    const char* name;
+    double cpuMs;
+};
+
+// 几何通道在一帧内的视锥剔除结果（网格数），同名通道（如多个灯光的阴影）累加
+struct CullingStats {
+    const char* name;
+    int drawn;
+    int culled;
+};
+
+// GPU 剔除：在几何通道之前用计算着色器剔除并生成间接绘制命令，关闭 GPU 剔除时不做任何事
+class GpuCullingPass : public RenderPass {
+public:
+    GpuCullingPass(GpuCulling& gpuCulling, std::vector<std::shared_ptr<Model>>& models)
+        : gpuCulling(gpuCulling), models(models) {}
+
+    void execute() override;
+    const char* get_name() const override { return "GpuCulling"; }
+    void declare(RenderGraph::PassBuilder& builder) override;
+    bool is_enabled() const override;
+
+private:
+    GpuCulling& gpuCulling;
+    std::vector<std::shared_ptr<Model>>& models;
+};
+
+// 软件遮挡：在几何通道之前把遮挡物光栅化到 CPU 深度缓冲，之后摄像机通道收集网格时对照测试
+class SoftwareOcclusionPass : public RenderPass {
+public:
+    SoftwareOcclusionPass(SoftwareOcclusion& occlusion, std::vector<std::shared_ptr<Model>>& models)
+        : occlusion(occlusion), models(models) {}
+
+    void execute() override;
+    const char* get_name() const override { return "SoftwareOcclusion"; }
+    void declare(RenderGraph::PassBuilder& builder) override;
+    bool is_enabled() const override;
+
+private:
+    SoftwareOcclusion& occlusion;
+    std::vector<std::shared_ptr<Model>>& models;
+};
+
+// 分簇光照剔除：在 PBR 光照阶段之前把灯光分配到视锥的簇中，关闭分簇光照或没有灯光时不做任何事
+class LightCullingPass : public RenderPass {
+public:
+    LightCullingPass(ClusteredLighting& clusteredLighting, std::shared_ptr<Light>& light)
+        : clusteredLighting(clusteredLighting), light(light) {}
+
+    void execute() override;
+    const char* get_name() const override { return "LightCulling"; }
+    void declare(RenderGraph::PassBuilder& builder) override;
+    bool is_enabled() const override;
+
+private:
+    ClusteredLighting& clusteredLighting;
+    std::shared_ptr<Light>& light;
+};
+
 // 天空盒绘制
 class SkyboxPass : public RenderPass {
 public:
@@ -44,6 +125,8 @@ public:
         : shader(shader), texture(texture), dummyCube(dummyCube), ifDeferred(ifDeferred) {}
 
     void execute() override;
+    const char* get_name() const override { return "Skybox"; }
+    void declare(RenderGraph::PassBuilder& builder) override;
 
 private:
     std::shared_ptr<Shader> shader;
@@ -62,11 +145,14 @@ public:
             : shader(basicShader), models(models), light(light) {}
     
     void execute() override;
+    const char* get_name() const override { return "Opaque"; }
+    void declare(RenderGraph::PassBuilder& builder) override;
 
 private:
     std::shared_ptr<Shader> shader;
     std::vector<std::shared_ptr<Model>>& models;
     std::shared_ptr<Light> light;
+    RenderQueue queue;
     
 };
 
@@ -76,35 +162,29 @@ class OpaqueDeferredPass : public RenderPass {
     OpaqueDeferredPass(std::shared_ptr<Shader> deferred_g_shader,
             std::shared_ptr<Shader> deferred_l_shader,
             std::shared_ptr<Shader> ssao_shader,
-            std::shared_ptr<Framebuffer> deferredFramebuffer,
-            std::shared_ptr<Framebuffer> ssaoFrameBuffer,
             std::vector<std::shared_ptr<Model>>& models,
+            std::vector<std::shared_ptr<InstancedModel>>& instancedModels,
             std::shared_ptr<Light> light,
             std::shared_ptr<Mesh> dummy_screen)
                 : deferred_g_shader(deferred_g_shader), deferred_l_shader(deferred_l_shader), ssao_shader(ssao_shader), 
-                deferredFramebuffer(deferredFramebuffer), ssaoFrameBuffer(ssaoFrameBuffer),
-                models(models), light(light), dummy_screen(dummy_screen){
-                    noiseTexture = std::make_unique<Texture>();
-                    noiseTexture->add_noise_texture(); // 添加噪声纹理
-
-                    ssaoKernel = generateSSAOKernel(64); // 生成SSAO采样内核
-                }
+                models(models), instancedModels(instancedModels), light(light), dummy_screen(dummy_screen){}
         
         void execute() override;
+        const char* get_name() const override { return "OpaqueDeferred"; }
+        void declare(RenderGraph::PassBuilder& builder) override;
 
     private:
         std::shared_ptr<Shader> deferred_g_shader;
         std::shared_ptr<Shader> deferred_l_shader;
         std::shared_ptr<Shader> ssao_shader;
         std::vector<std::shared_ptr<Model>>& models;
+        std::vector<std::shared_ptr<InstancedModel>>& instancedModels;
         std::shared_ptr<Light> light;
+        RenderQueue queue;
 
-        std::unique_ptr<Texture> noiseTexture; // 噪声纹理
-        std::vector<glm::vec3> ssaoKernel; // SSAO采样内核
         std::shared_ptr<Mesh> dummy_screen;
 
-        std::shared_ptr<Framebuffer> deferredFramebuffer;
-        std::shared_ptr<Framebuffer> ssaoFrameBuffer;
+        Framebuffer* deferredFramebuffer = nullptr;     // 渲染图资源 GBuffer，本帧执行时取得
 };
 
 // PBR管线绘制
@@ -113,19 +193,15 @@ public:
     PBRPass(std::shared_ptr<Shader> pbr_g_shader,
             std::shared_ptr<Shader> pbr_l_shader,
             std::shared_ptr<Shader> ssao_shader,
-            std::shared_ptr<Framebuffer> pbrDeferredFramebuffer,
-            std::shared_ptr<Framebuffer> ssaoFrameBuffer,
+            std::shared_ptr<Shader> depth_prepass_shader,
             std::shared_ptr<Texture> prefilterMap,
             std::vector<std::shared_ptr<Model>>& models,
+            std::vector<std::shared_ptr<InstancedModel>>& instancedModels,
+            std::shared_ptr<Light>& light,
             std::shared_ptr<Mesh> dummy_screen)
-                : pbr_g_shader(pbr_g_shader), pbr_l_shader(pbr_l_shader), ssao_shader(ssao_shader), 
-                pbrDeferredFramebuffer(pbrDeferredFramebuffer), ssaoFrameBuffer(ssaoFrameBuffer),
+                : pbr_g_shader(pbr_g_shader), pbr_l_shader(pbr_l_shader), ssao_shader(ssao_shader), depth_prepass_shader(depth_prepass_shader),
                 prefilterMap(prefilterMap),
-                models(models), dummy_screen(dummy_screen){
-                    noiseTexture = std::make_unique<Texture>();
-                    noiseTexture->add_noise_texture(); // 添加噪声纹理
-                    ssaoKernel = generateSSAOKernel(64); // 生成SSAO采样内核
-
+                models(models), instancedModels(instancedModels), light(light), dummy_screen(dummy_screen){
                     brdfLUT = std::make_unique<Texture>();
                     brdfLUT->add_preCal_CT_BRDF(512); // 添加brdfLUT纹理
 
@@ -133,22 +209,25 @@ public:
                 }
         
         void execute() override;
+        const char* get_name() const override { return "PBR"; }
+        void declare(RenderGraph::PassBuilder& builder) override;
 
 private:
     std::shared_ptr<Shader> pbr_g_shader;
     std::shared_ptr<Shader> pbr_l_shader;
     std::shared_ptr<Shader> ssao_shader;
+    std::shared_ptr<Shader> depth_prepass_shader;
     std::vector<std::shared_ptr<Model>>& models;
+    std::vector<std::shared_ptr<InstancedModel>>& instancedModels;
+    std::shared_ptr<Light>& light;  // 直接光照的灯光（引用 Renderer 中的灯光分组，场景切换后仍有效）
+    RenderQueue queue;
 
-    std::unique_ptr<Texture> noiseTexture; // 噪声纹理
     std::unique_ptr<Texture> brdfLUT; // brdfLUT
     std::shared_ptr<Texture> prefilterMap; // 预过滤的立方体贴图
 
-    std::vector<glm::vec3> ssaoKernel; // SSAO采样内核
     std::shared_ptr<Mesh> dummy_screen;
 
-    std::shared_ptr<Framebuffer> pbrDeferredFramebuffer;
-    std::shared_ptr<Framebuffer> ssaoFrameBuffer;
+    Framebuffer* pbrDeferredFramebuffer = nullptr;  // 渲染图资源 GBuffer，本帧执行时取得（本通道之后归还）
 };
 
 // 透明物体绘制
@@ -156,21 +235,27 @@ class TransparentPass : public RenderPass {
 public:
     TransparentPass(std::shared_ptr<Shader> accumShader,
         std::shared_ptr<Shader> drawShader,
-        std::shared_ptr<Framebuffer> oitFramebuffer,
         std::vector<std::shared_ptr<Model>>& models,
+        std::vector<std::shared_ptr<InstancedModel>>& instancedModels,
+        std::shared_ptr<Light>& light,
         std::shared_ptr<Mesh> dummy_screen)
-        : accumShader(accumShader), drawShader(drawShader), oitFramebuffer(oitFramebuffer),
-        models(models), dummy_screen(dummy_screen) {}
+        : accumShader(accumShader), drawShader(drawShader),
+        models(models), instancedModels(instancedModels), light(light), dummy_screen(dummy_screen) {}
 
     void execute() override;
+    const char* get_name() const override { return "Transparent"; }
+    void declare(RenderGraph::PassBuilder& builder) override;
+    bool is_enabled() const override;
 
 private:
     std::shared_ptr<Shader> accumShader;
     std::shared_ptr<Shader> drawShader;
     std::vector<std::shared_ptr<Model>>& models;
+    std::vector<std::shared_ptr<InstancedModel>>& instancedModels;
+    RenderQueue queue;
+    // 前向光照（Forward+）：与不透明物体共用场景灯光和 LightCullingPass 的分簇结果，每个片段只计算所在簇的灯光
+    std::shared_ptr<Light>& light;
     std::shared_ptr<Mesh> dummy_screen;
-
-    std::shared_ptr<Framebuffer> oitFramebuffer;
 };
         
 // 灯光绘制
@@ -180,6 +265,8 @@ public:
         : shader(lightShader), lights(lights), ifDeferred(ifDeferred) {}
 
     void execute() override;
+    const char* get_name() const override { return "Light"; }
+    void declare(RenderGraph::PassBuilder& builder) override;
 
 private:
     bool ifDeferred; // 是否使用延迟渲染
@@ -193,17 +280,35 @@ public:
     BakePass(std::shared_ptr<Shader> shadowMapShader_directionalLight, 
         std::shared_ptr<Shader> shadowMapShader_pointLight, 
         std::vector<std::shared_ptr<Light>>& lights, 
-        std::vector<std::shared_ptr<Model>>& models)
+        std::vector<std::shared_ptr<Model>>& models,
+        std::vector<std::shared_ptr<InstancedModel>>& instancedModels)
         : shadowMapShader_directionalLight(shadowMapShader_directionalLight), shadowMapShader_pointLight(shadowMapShader_pointLight), 
-        lights(lights), models(models) {}
+        lights(lights), models(models), instancedModels(instancedModels) {}
 
     void execute() override;
+    const char* get_name() const override { return "Bake"; }
+    void declare(RenderGraph::PassBuilder& builder) override;
 
 private:
     std::shared_ptr<Shader> shadowMapShader_directionalLight;
     std::shared_ptr<Shader> shadowMapShader_pointLight;
     std::vector<std::shared_ptr<Light>>& lights;
     std::vector<std::shared_ptr<Model>>& models;
+    std::vector<std::shared_ptr<InstancedModel>>& instancedModels;
+};
+
+// 合成：对 HDR 场景颜色做色调映射和 gamma 校正后写到窗口；开启动态分辨率时同时把渲染区域双线性放大到窗口大小
+class CompositePass : public RenderPass {
+public:
+    CompositePass(std::shared_ptr<Shader> shader, std::shared_ptr<Mesh> dummyScreen)
+        : shader(shader), dummyScreen(dummyScreen) {}
+    void execute() override;
+    const char* get_name() const override { return "Composite"; }
+    void declare(RenderGraph::PassBuilder& builder) override;
+
+private:
+    std::shared_ptr<Shader> shader;
+    std::shared_ptr<Mesh> dummyScreen;
 };
 
 // ImGui 绘制
@@ -211,10 +316,14 @@ class ImGuiPass : public RenderPass {
 public:
     ImGuiPass(){}    
     void execute() override;
+    const char* get_name() const override { return "ImGui"; }
+    void declare(RenderGraph::PassBuilder& builder) override;
     
 private:
     // ImGui 相关成员变量和方法
     // 例如：ImGui上下文、窗口、UI元素等
+    void drawGpuProfiler();
+    void drawGLStats();
 };
 
 
@@ -227,6 +336,8 @@ public:
         : view_texture_shader(view_texture_shader), textureID(textureID), dummyScreen(dummyScreen){}
 
     void execute() override;
+    const char* get_name() const override { return "View"; }
+    void declare(RenderGraph::PassBuilder& builder) override;
 
 private:
     std::shared_ptr<Shader> view_texture_shader;
@@ -247,12 +358,101 @@ public:
     void resizeFBOIfNeeded(int screenWidth, int screenHeight);
 
     // 调用绘制
-    void renderAll() {
-        for (auto& pass : renderPasses) {
-            pass->execute();
-        }
+    void renderAll();
+
+    // 通道计时：开启后renderAll()记录每个通道的CPU耗时
+    void set_passTimingEnabled(bool enabled) { passTimingEnabled = enabled; }
+    const std::vector<PassTiming>& get_passTimings() const { return passTimings; }
+
+    // 无窗口模式（离屏基准测试）下不注册 ImGui 通道
+    void set_headless(bool headless) { this->headless = headless; }
+
+    // 当前摄像机，用于按深度排序等需要观察点的计算
+    void set_camera(Camera* camera) { this->camera = camera; }
+    Camera* get_camera() const { return camera; }
+
+    // 渲染队列：关闭时退回按插入顺序逐个绘制（便于对比状态切换次数）
+    void set_renderQueueEnabled(bool enabled) { renderQueueEnabled = enabled; }
+    bool is_renderQueueEnabled() const { return renderQueueEnabled; }
+    // 多重间接绘制：渲染队列排序后从共享几何缓冲一次提交整批网格（需开启渲染队列）
+    void set_multiDrawEnabled(bool enabled) { multiDrawEnabled = enabled; }
+    bool is_multiDrawEnabled() const { return multiDrawEnabled; }
+    // GPU 剔除：几何通道和阴影改由计算着色器剔除、glMultiDrawElementsIndirectCount 提交（不经过渲染队列）
+    void set_gpuCullingEnabled(bool enabled) { gpuCullingEnabled = enabled; }
+    bool is_gpuCullingEnabled() const { return gpuCullingEnabled; }
+    GpuCulling& get_gpuCulling() { return gpuCulling; }
+    // 遮挡剔除（需开启 GPU 剔除）：几何通道分两阶段绘制，中间用本帧已画的深度构建 Hi-Z
+    void set_occlusionCullingEnabled(bool enabled) { occlusionCullingEnabled = enabled; }
+    bool is_occlusionCullingEnabled() const { return gpuCullingEnabled && occlusionCullingEnabled; }
+    HiZBuffer& get_hiZBuffer() { return hiZBuffer; }
+    // CPU 软件遮挡剔除：只作用于摄像机通道的 CPU 提交路径（渲染队列/逐模型），关闭或没有摄像机时返回空指针
+    void set_softwareOcclusionEnabled(bool enabled) { softwareOcclusionEnabled = enabled; }
+    bool is_softwareOcclusionEnabled() const { return softwareOcclusionEnabled; }
+    SoftwareOcclusion& get_softwareOcclusion() { return softwareOcclusion; }
+    const SoftwareOcclusion* get_activeSoftwareOcclusion() const {
+        return softwareOcclusionEnabled && frustumCullingEnabled && camera ? &softwareOcclusion : nullptr;
+    }
+    // 硬件遮挡查询：摄像机几何通道的 CPU 提交路径按模型发起包围盒查询并条件渲染，关闭或没有摄像机时返回空指针
+    void set_occlusionQueriesEnabled(bool enabled) { occlusionQueriesEnabled = enabled; }
+    bool is_occlusionQueriesEnabled() const { return occlusionQueriesEnabled; }
+    OcclusionQueries* get_activeOcclusionQueries() {
+        return occlusionQueriesEnabled && frustumCullingEnabled && camera ? &occlusionQueries : nullptr;
     }
 
+    // 深度预渲染：PBR 的 G-Buffer 阶段之前先只写深度，G-Buffer 以 GL_EQUAL 比较、不写深度，消除 G-Buffer 的过度绘制
+    void set_depthPrepassEnabled(bool enabled) { depthPrepassEnabled = enabled; }
+    bool is_depthPrepassEnabled() const { return depthPrepassEnabled; }
+    // 紧凑 G-Buffer：不存位置（由深度纹理和逆视图投影矩阵重建），法线八面体编码到 RG16，反照率 SRGB8_ALPHA8，金属度/粗糙度/AO 为 RGBA8
+    // G-Buffer 每帧按当前布局从帧缓冲池申请，切换后下一帧生效，旧布局的缓冲闲置一段时间后释放
+    void set_compactGBufferEnabled(bool enabled) { compactGBufferEnabled = enabled; }
+    bool is_compactGBufferEnabled() const { return compactGBufferEnabled; }
+    // 当前布局每像素占用的字节数（含深度）
+    int get_gBufferBytesPerPixel() const { return compactGBufferEnabled ? 16 : 30; }
+    // 分簇光照：PBR 光照阶段只计算像素所在簇的灯光，关闭时逐像素遍历全部灯光（用于对比）
+    void set_clusteredLightingEnabled(bool enabled) { clusteredLightingEnabled = enabled; }
+    bool is_clusteredLightingEnabled() const { return clusteredLightingEnabled; }
+    ClusteredLighting& get_clusteredLighting() { return clusteredLighting; }
+    // SSAO：分辨率、采样数和模糊由 AmbientOcclusion 配置，强度为 ssaoStrength
+    AmbientOcclusion& get_ambientOcclusion() { return ambientOcclusion; }
+    // 动态分辨率：场景渲染到按窗口大小分配的缓冲的左下角区域（比例变化时不重新分配），最后由 CompositePass 放大到窗口。
+    // 比例由 DynamicResolution 按最近几帧的 GPU 耗时调整，开启时同时开启 GpuProfiler
+    void set_dynamicResolutionEnabled(bool enabled);
+    bool is_dynamicResolutionEnabled() const { return dynamicResolutionEnabled; }
+    DynamicResolution& get_dynamicResolution() { return dynamicResolution; }
+    // 本帧的渲染分辨率（未开启动态分辨率时与窗口相同）及其占已分配缓冲的比例，采样 G-Buffer 等缓冲时乘以该比例
+    int get_renderWidth() const { return renderWidth; }
+    int get_renderHeight() const { return renderHeight; }
+    glm::vec2 get_renderUVScale() const {
+        return glm::vec2(static_cast<float>(renderWidth) / std::max(currentWidth, 1), static_cast<float>(renderHeight) / std::max(currentHeight, 1));
+    }
+    // 场景颜色的绘制目标：渲染器持有的 HDR 场景缓冲，视口设为渲染区域。
+    // 延迟路径把渲染图资源 SceneDepth 的深度纹理直接挂到场景缓冲上（share_depth），天空盒和灯光图标就地深度测试，不再复制深度；
+    // 最后由 CompositePass 色调映射后写到窗口
+    void bind_sceneTarget() const;
+    Framebuffer* get_sceneFramebuffer() const { return sceneFramebuffer.get(); }
+    int get_windowWidth() const { return currentWidth; }
+    int get_windowHeight() const { return currentHeight; }
+    // 帧缓冲池：通道内使用的临时缓冲和本帧内跨通道读取的缓冲都从这里申请，不再按窗口大小预先分配
+    FramebufferPool& get_framebufferPool() { return framebufferPool; }
+
+    // 视锥剔除：摄像机视锥在每帧开始时由 renderAll() 更新，未设置摄像机或关闭剔除时返回空指针
+    void set_frustumCullingEnabled(bool enabled) { frustumCullingEnabled = enabled; }
+    bool is_frustumCullingEnabled() const { return frustumCullingEnabled; }
+    const Frustum* get_cameraFrustum() const { return frustumCullingEnabled && camera ? &cameraFrustum : nullptr; }
+    void add_cullingStats(const char* name, int drawn, int culled);
+    const std::vector<CullingStats>& get_cullingStats() const { return cullingStats; }
+
+    // 场景 BVH：每个 RenderType 的模型列表各有一棵，返回前先按需重建或重新拟合；关闭时返回空指针（退回逐网格测试）
+    void set_sceneBVHEnabled(bool enabled) { sceneBVHEnabled = enabled; }
+    bool is_sceneBVHEnabled() const { return sceneBVHEnabled; }
+    SceneBVH* get_sceneBVH(const std::vector<std::shared_ptr<Model>>& models);
+    const SceneBVH* get_sceneBVH(RenderType rt) const {
+        auto it = renderType_bvh_map.find(rt);
+        return sceneBVHEnabled && it != renderType_bvh_map.end() ? &it->second : nullptr;
+    }
+    // 拾取：从摄像机穿过屏幕点（NDC 坐标，[-1, 1]）的射线与场景最近的交点
+    bool pick(float ndcX, float ndcY, SceneBVH::RayHit& hit);
+
     // 注册场景对象(灯光和模型等)
     void add_light(std::shared_ptr<Light> light) {
         if (light) {
@@ -271,10 +471,40 @@ public:
 
         // 添加 Model 到新 Shader 组
         renderType_model_map[rt].push_back(model);
+        sceneVersion++;
+        // 场景结构变化，BVH 下次使用前重建
+        for (auto& [type, bvh] : renderType_bvh_map) {
+            bvh.invalidate();
+        }
+    }
+    // 实例化模型按 RenderType 分组，由对应的几何通道和阴影通道绘制
+    void add_instancedModel(std::shared_ptr<InstancedModel> instancedModel, RenderType rt = RenderType::Basic) {
+        if (instancedModel) {
+            renderType_instanced_map[rt].push_back(instancedModel);
+        }
     }
     void set_light_renderType(RenderType rt, std::shared_ptr<Light> light) {
         renderType_light_map[rt] = light;
     }
+    // 清空场景对象（只清空列表内容，渲染通道持有的列表引用保持有效）
+    void clear_scene() {
+        lights.clear();
+        for (auto& [rt, modelList] : renderType_model_map) {
+            modelList.clear();
+        }
+        for (auto& [rt, instancedList] : renderType_instanced_map) {
+            instancedList.clear();
+        }
+        for (auto& [rt, light] : renderType_light_map) {
+            light.reset();
+        }
+        for (auto& [rt, bvh] : renderType_bvh_map) {
+            bvh.invalidate();
+        }
+        sceneVersion++;
+    }
+    // 场景中模型增删时递增，缓存了模型列表派生数据的对象（如 GpuCulling）据此重建
+    unsigned int get_sceneVersion() const { return sceneVersion; }
 
     // 设置调试模式
     void set_debugMode(int mode) {
@@ -284,16 +514,8 @@ public:
     int get_debugMode() const {
         return debugMode;
     }
-    std::shared_ptr<Framebuffer> get_DeferedFramebufferForPass() const {
-        for (auto& pass : renderPasses){
-            if (dynamic_cast<OpaqueDeferredPass*>(pass.get())) {
-                return deferredFramebuffer; // 如果是 OpaqueDeferredPass，返回 deferredFramebuffer
-            } else if (dynamic_cast<PBRPass*>(pass.get())) {
-                return pbrDeferredFramebuffer; // 如果是 PBRPass，返回 pbrDeferredFramebuffer
-            }
-        }
-        return nullptr; // 如果不是这两种类型，返回空指针
-    }
+    // 渲染图：renderPasses 为注册顺序，每帧按各通道声明的资源编译出实际执行的步骤
+    RenderGraph& get_renderGraph() { return renderGraph; }
 
 public:
     float ssaoStrength = 1.0f; // SSAO强度
@@ -306,10 +528,9 @@ private:
     std::vector<std::unique_ptr<RenderPass>> renderPasses_deferred; // 延迟渲染通道列表
 
     // Framebuffer对象
-    std::shared_ptr<Framebuffer> deferredFramebuffer;   // 延迟渲染-几何阶段
-    std::shared_ptr<Framebuffer> oitFramebuffer;        // OIT-累积阶段
-    std::shared_ptr<Framebuffer> ssaoFrameBuffer;       // SSAO-颜色缓冲区
-    std::shared_ptr<Framebuffer> pbrDeferredFramebuffer; // PBR-几何阶段
+    FramebufferPool framebufferPool;
+    RenderGraph renderGraph;
+    std::unique_ptr<Framebuffer> sceneFramebuffer;  // HDR 场景颜色（R11G11B10F），窗口大小改变时重建
 
     // 着色器资源
     std::shared_ptr<Shader> basicShader;    // 基础着色
@@ -320,11 +541,13 @@ private:
     std::shared_ptr<Shader> shadowMapShader_directionalLight;   // 阴影贴图-平行光
     std::shared_ptr<Shader> shadowMapShader_pointLight;         // 阴影贴图-点光
     std::shared_ptr<Shader> view_texture_shader;    // 预览FBO
+    std::shared_ptr<Shader> compositeShader;        // 最终合成（色调映射）
     std::shared_ptr<Shader> deferred_g_shader;      // 延迟渲染-几何阶段
     std::shared_ptr<Shader> deferred_l_shader;      // 延迟渲染-光照阶段
     std::shared_ptr<Shader> ssao_shader;           // SSAO着色器
     std::shared_ptr<Shader> pbr_g_shader;          // PBR-几何阶段
     std::shared_ptr<Shader> pbr_l_shader;          // PBR-光照阶段
+    std::shared_ptr<Shader> depthPrepassShader;    // 深度预渲染
 
     std::shared_ptr<Texture> skyBoxCubemap;
     std::shared_ptr<Mesh> dummyCube;
@@ -332,6 +555,7 @@ private:
     // 场景对象
     std::vector<std::shared_ptr<Light>> lights;
     std::unordered_map<RenderType, std::vector<std::shared_ptr<Model>>> renderType_model_map;
+    std::unordered_map<RenderType, std::vector<std::shared_ptr<InstancedModel>>> renderType_instanced_map;
     std::unordered_map<RenderType, std::shared_ptr<Light>> renderType_light_map;
 
     std::shared_ptr<Mesh> dummyScreen;
@@ -341,8 +565,45 @@ private:
 
 
     int debugMode = 0; // 调试模式，默认值为 0
-    int currentWidth;
-    int currentHeight;
+    bool headless = false;
+    bool renderQueueEnabled = true;
+    bool multiDrawEnabled = false;
+    bool gpuCullingEnabled = false;
+    GpuCulling gpuCulling;
+    bool occlusionCullingEnabled = false;
+    HiZBuffer hiZBuffer;
+    bool softwareOcclusionEnabled = false;
+    SoftwareOcclusion softwareOcclusion;
+    bool occlusionQueriesEnabled = false;
+    OcclusionQueries occlusionQueries;
+    bool depthPrepassEnabled = false;
+    bool compactGBufferEnabled = false;
+    bool clusteredLightingEnabled = true;
+    ClusteredLighting clusteredLighting;
+    AmbientOcclusion ambientOcclusion;
+    bool dynamicResolutionEnabled = false;
+    DynamicResolution dynamicResolution;
+    unsigned long long dynamicResolutionSamples = 0;   // 已交给控制器的 GPU 帧数（序号 + 1）
+    int renderWidth = 0;
+    int renderHeight = 0;
+    Camera* camera = nullptr;
+
+    // 视锥剔除
+    bool frustumCullingEnabled = true;
+    Frustum cameraFrustum;
+    std::vector<CullingStats> cullingStats;
+
+    unsigned int sceneVersion = 0;
+
+    // 场景 BVH
+    bool sceneBVHEnabled = true;
+    std::unordered_map<RenderType, SceneBVH> renderType_bvh_map;
+
+    // 通道计时
+    bool passTimingEnabled = false;
+    std::vector<PassTiming> passTimings;
+    int currentWidth = 0;
+    int currentHeight = 0;
 };
 
 
@@ -0,0 +1,84 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Bounds.h"
+
+class Mesh;
+class Model;
+
+// 场景包围体层次（BVH）
+// 叶子是网格的世界空间包围盒。模型列表变化时用分箱 SAH 重建；网格移动时由 Mesh 标记脏图元，
+// 下一次 update() 只沿脏叶子向上重新拟合（refit），移动的图元过多时才整体重建。
+// 图元保存网格的裸指针：网格析构时通知 BVH 摘掉自己，BVH 析构或重建时解除旧网格的回指，两边不会悬空。
+class SceneBVH {
+public:
+    static const int MAX_LEAF_SIZE = 4;
+    static const int SAH_BINS = 12;
+
+    struct RayHit {
+        Mesh* mesh = nullptr;
+        float distance = 0.0f;
+        glm::vec3 position = glm::vec3(0.0f);
+    };
+
+    SceneBVH() = default;
+    ~SceneBVH();
+    SceneBVH(const SceneBVH&) = delete;
+    SceneBVH& operator=(const SceneBVH&) = delete;
+
+    // 场景增删模型后调用，下一次 update() 重建
+    void invalidate() { needsRebuild = true; }
+    // 查询前调用：需要时重建，否则重新拟合脏图元
+    void update(const std::vector<std::shared_ptr<Model>>& models);
+    // 由 Mesh 在世界包围体变化时调用
+    void mark_dirty(int primitive, const Mesh* mesh);
+    // 由 Mesh 在析构时调用，下一次 update() 重建
+    void remove_primitive(int primitive, const Mesh* mesh);
+
+    // 收集与体积相交的可见网格
+    void query(const Frustum& frustum, std::vector<Mesh*>& result) const;
+    // 最近的三角形命中（拾取），direction 不必归一化，distance 以 direction 的长度为单位
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const;
+
+    int get_primitiveCount() const { return static_cast<int>(primitives.size()); }
+    // 当前可见的图元数，隐藏的网格不参与查询，也不应计为被剔除
+    int get_visiblePrimitiveCount() const;
+    int get_nodeCount() const { return static_cast<int>(nodes.size()); }
+    int get_rebuildCount() const { return rebuildCount; }
+    int get_lastRefitCount() const { return lastRefitCount; }   // 最近一次 update() 重新拟合的图元数
+
+private:
+    // count > 0 为叶子，图元为 primitives[first, first + count)；span 为整棵子树的图元数（子树图元连续存放）
+    struct Node {
+        AABB bounds;
+        int parent = -1;
+        int left = -1;
+        int right = -1;
+        int first = 0;
+        int count = 0;
+        int span = 0;
+    };
+    struct Primitive {
+        Mesh* mesh;
+        AABB bounds;
+        glm::vec3 centroid;
+        int leaf;
+    };
+
+    void build();
+    int buildNode(int first, int count, int parent);
+    void refit();
+    void collectSubtree(int nodeIndex, std::vector<Mesh*>& result) const;
+    void detachPrimitives();
+
+    std::vector<Node> nodes;
+    std::vector<Primitive> primitives;
+    std::vector<int> dirtyPrimitives;
+    std::vector<char> primitiveDirty;
+
+    bool needsRebuild = true;
+    std::vector<const Model*> builtModels;  // 构建时的模型列表，列表有任何变化（包括替换）都重建
+    int rebuildCount = 0;
+    int lastRefitCount = 0;
+};
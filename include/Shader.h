@@ -20,12 +20,14 @@ private:
     unsigned int m_Program;
     std::string m_FilePath;
     std::unordered_map<std::string, int> m_UniformLocationCache; // 缓存全局变量位置
+    static unsigned int s_BoundProgram; // 当前绑定的程序，用于跳过重复的 glUseProgram
 public:
     Shader(const std::string& filepath);
     ~Shader();
 
     void bind() const;
     void unbind() const;
+    inline unsigned int get_programID() const {return m_Program;}
 
     // set light
     //void set_light(Light* light);
@@ -38,8 +40,10 @@ public:
     void setUniform3f(const std::string& name, float v1, float v2, float v3);
     void setUniform4f(const std::string& name, float v1, float v2, float v3, float v4);
     void setUniform1i(const std::string& name, int v1);
+    void setUniform2i(const std::string& name, int v1, int v2);
     void setUniform1iv(const std::string& name, int count, const int* values); 
     void setUniform3fv(const std::string& name, int count, const float* values);
+    void setUniform4fv(const std::string& name, int count, const float* values);
     void setUniform4fv(const std::string& name, glm::mat4& mat);
 
 private:
@@ -47,4 +51,5 @@ private:
     std::vector<std::stringstream> ParseShader();
     unsigned int CompileShader(unsigned int type, const std::string& source);
     void CreateShader(const std::string& VertexShader, const std::string& FragmentShader, const std::string& GeometryShader = "");
+    void CreateComputeShader(const std::string& ComputeShader);
 };
\ No newline at end of file
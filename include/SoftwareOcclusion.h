@@ -0,0 +1,90 @@
+#pragma once
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+
+class Model;
+class Mesh;
+
+// CPU 软件遮挡剔除
+// 每帧把标记为遮挡物的网格（Mesh::set_occluder）光栅化到一张低分辨率深度缓冲中，
+// 之后几何通道在提交 GL 调用之前用物体的包围盒对照测试：包围盒投影覆盖的像素全都比它更近时，物体一定被遮挡。
+// 光栅化按行分带交给多个常驻线程，每个线程只写自己的带，不需要同步；
+// 遮挡物只写入被三角形完全覆盖的像素，深度取像素内最远处，因此不会把实际可见的物体判为遮挡；
+// 支持 AVX2 时每次处理 8 个像素（运行时检测，否则走标量路径）。
+// 不依赖 GPU，适合软件光栅化（llvmpipe）的环境：GPU 上的遮挡测试在那里和直接绘制一样贵。
+class SoftwareOcclusion {
+public:
+    SoftwareOcclusion();
+    ~SoftwareOcclusion();
+    SoftwareOcclusion(const SoftwareOcclusion&) = delete;
+    SoftwareOcclusion& operator=(const SoftwareOcclusion&) = delete;
+
+    // 深度缓冲分辨率，宽度向上取整为 8 的倍数
+    void set_resolution(int width, int height);
+    // 光栅化使用的线程数（包括调用线程），0 表示按硬件线程数自动选择
+    void set_threadCount(int count);
+
+    // 收集 models 中的遮挡物并光栅化，viewProjection 为本帧摄像机的观察投影矩阵
+    void render(const glm::mat4& viewProjection, const std::vector<std::shared_ptr<Model>>& models);
+    // 保守测试：返回 false 时一定被遮挡。每次调用计入测试/剔除统计
+    bool is_visible(const AABB& worldBounds) const;
+
+    int get_width() const { return width; }
+    int get_height() const { return height; }
+    const std::vector<float>& get_depth() const { return depth; }  // 行优先，每行 stride 个像素，近处值小
+    bool is_avx2() const { return useAVX2; }
+    int get_occluderCount() const { return occluderCount; }
+    int get_triangleCount() const { return static_cast<int>(triangles.size()); }
+    int get_testedCount() const { return testedCount; }
+    int get_culledCount() const { return culledCount; }
+
+private:
+    // 屏幕空间三角形：三条边函数 A*x + B*y + C 和深度平面 z = zA*x + zB*y + zC，均在像素中心求值。
+    // C 已按保守光栅化调整：像素完全在三角形内时三者均不小于 0，z 为三角形在该像素内的最远深度
+    struct Triangle {
+        float edgeA[3], edgeB[3], edgeC[3];
+        float zA, zB, zC;
+        int minX, maxX, minY, maxY;
+    };
+
+    void startWorkers(int count);
+    void stopWorkers();
+    void workerLoop(int band, unsigned int seenGeneration);
+    void setupTriangles(const glm::mat4& viewProjection, const std::vector<std::shared_ptr<Model>>& models);
+    void rasterizeBand(int y0, int y1);
+    void rasterizeBandScalar(int y0, int y1);
+    void rasterizeBandAVX2(int y0, int y1);
+    bool testRectScalar(int x0, int x1, int y0, int y1, float minDepth) const;
+    bool testRectAVX2(int x0, int x1, int y0, int y1, float minDepth) const;
+
+    int width = 0;
+    int height = 0;
+    int stride = 0;     // 每行像素数（8 的倍数）
+    int threadCount = 0;
+    bool useAVX2 = false;
+
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    std::vector<float> depth;
+    std::vector<Triangle> triangles;
+    std::vector<glm::vec4> clipPositions;   // 变换后的顶点，跨帧复用
+
+    // 常驻工作线程：render() 递增 workerGeneration 唤醒，第 i 个线程光栅化第 i + 1 个行带
+    std::vector<std::thread> workers;
+    std::mutex workerMutex;
+    std::condition_variable workerWake;
+    std::condition_variable workerDone;
+    unsigned int workerGeneration = 0;
+    int bandRows = 0;
+    int pendingWorkers = 0;
+    bool stopping = false;
+
+    int occluderCount = 0;
+    mutable int testedCount = 0;
+    mutable int culledCount = 0;
+};
@@ -64,6 +64,10 @@ public:
    // TEST
    unsigned int get_textureID(int index){return images[index].textureID;} 
 
+    // 引用的图像（类型和纹理对象，经纹理缓存共享）完全相同时 bind() 的结果相同，渲染队列据此合并材质
+    bool has_same_images(const Texture& other) const;
+    size_t get_imageHash() const;
+
 private:
     unsigned char* read_image(TextureImage& image);
     unsigned char* read_image_from_memory(TextureImage& image, const unsigned char* rawData, size_t size);
@@ -0,0 +1,31 @@
+#shader vertex
+#version 460 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in vec3 tangent;
+layout (location = 4) in float tangentW;
+
+void main() {
+    gl_Position = vec4(aPos.xy, 0.0, 1.0);
+}
+
+#shader fragment
+#version 460 core
+
+out vec4 FragColor;
+
+// HDR 场景颜色，按窗口大小分配，只有左下角 uvScale 的区域有效（动态分辨率）
+uniform sampler2D sceneColor;
+uniform vec2 uvScale;
+
+void main() {
+    vec2 size = vec2(textureSize(sceneColor, 0));
+    // 按窗口像素取渲染区域内对应的位置，双线性放大；夹在区域内半个纹素，避免混入区域外的旧内容
+    vec2 uv = gl_FragCoord.xy / size * uvScale;
+    uv = min(uv, uvScale - 0.5 / size);
+    vec3 color = texture(sceneColor, uv).rgb;
+    color = color / (color + vec3(1.0)); // tone mapping
+    color = pow(color, vec3(1.0/2.2));   // gamma correction
+    FragColor = vec4(color, 1.0);
+}
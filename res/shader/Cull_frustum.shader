@@ -0,0 +1,137 @@
+#shader compute
+#version 460 core
+layout (local_size_x = 64) in;
+
+// 与 GpuCulling.h 中的 CullObject 一致
+struct CullObject {
+    mat4 modelMatrix;
+    vec4 sphere;        // xyz 球心，w 半径（小于 0 表示总是可见）
+    uvec4 draw;         // x indexCount，y firstIndex，z baseVertex，w 材质槽
+    uvec4 batch;        // x 批次序号，y 批次第一条命令的位置，z 是否可见
+};
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+struct InstanceData {
+    mat4 modelMatrix;
+    uvec4 material;
+};
+
+layout(std430, binding = 5) readonly buffer CullObjectSSBO {
+    CullObject objects[];
+};
+layout(std430, binding = 6) writeonly buffer DrawCommandSSBO {
+    DrawCommand commands[];
+};
+layout(std430, binding = 7) buffer DrawCountSSBO {
+    uint drawCounts[];
+};
+// 逐绘制数据，几何着色器按 drawOffset + gl_DrawID 读取
+layout(std430, binding = 2) writeonly buffer DrawDataSSBO {
+    InstanceData drawData[];
+};
+// 遮挡剔除：每个对象上一帧是否可见
+layout(std430, binding = 8) buffer VisibilitySSBO {
+    uint visibility[];
+};
+layout(std140, binding = 0) uniform CameraUBO {
+    mat4 viewProjectionMatrix;
+    vec3 uViewPos;
+};
+
+uniform int objectCount;
+uniform bool cullingEnabled;
+// 为真时从 CameraUBO 的观察投影矩阵提取平面，否则使用 frustumPlanes（如灯光的阴影范围）
+uniform bool useCameraFrustum;
+uniform vec4 frustumPlanes[6];
+// 0 只做视锥剔除，1 遮挡剔除第一阶段（上一帧可见的对象），2 遮挡剔除第二阶段（对照 Hi-Z 测试全部对象）
+uniform int phase;
+// 本阶段的命令/计数区域起点
+uniform int commandBase;
+uniform int countBase;
+uniform sampler2D hiZ;
+uniform ivec2 hiZSize;     // 第 0 级尺寸
+uniform int hiZLevelCount;
+uniform vec2 hiZUVScale;   // 动态分辨率下深度只覆盖左下角的渲染区域，屏幕坐标乘以该比例
+
+vec4 extractPlane(int index)
+{
+    // Gribb-Hartmann：m[col][row]
+    mat4 m = viewProjectionMatrix;
+    vec4 row3 = vec4(m[0][3], m[1][3], m[2][3], m[3][3]);
+    int axis = index / 2;
+    vec4 row = vec4(m[0][axis], m[1][axis], m[2][axis], m[3][axis]);
+    vec4 plane = (index % 2 == 0) ? row3 + row : row3 - row;
+    return plane / length(plane.xyz);
+}
+
+bool sphereVisible(vec4 sphere)
+{
+    if (!cullingEnabled || sphere.w < 0.0) return true;
+    for (int i = 0; i < 6; ++i) {
+        vec4 plane = useCameraFrustum ? extractPlane(i) : frustumPlanes[i];
+        if (dot(plane.xyz, sphere.xyz) + plane.w < -sphere.w) return false;
+    }
+    return true;
+}
+
+// 包围球的包围盒投影到屏幕，取覆盖它的 2x2 个 Hi-Z 纹素中最远的深度，物体最近点比它还远则被遮挡
+bool sphereOccluded(vec4 sphere)
+{
+    if (sphere.w < 0.0) return false;
+    vec3 lo = vec3(1.0);
+    vec3 hi = vec3(0.0);
+    for (int i = 0; i < 8; ++i) {
+        vec3 offset = vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip = viewProjectionMatrix * vec4(sphere.xyz + offset * sphere.w, 1.0);
+        // 跨过摄像机所在平面时投影不可靠，保守视为可见
+        if (clip.w <= 0.0) return false;
+        vec3 window = clip.xyz / clip.w * 0.5 + 0.5;
+        lo = min(lo, window);
+        hi = max(hi, window);
+    }
+    lo.xy = clamp(lo.xy, 0.0, 1.0) * hiZUVScale;
+    hi.xy = clamp(hi.xy, 0.0, 1.0) * hiZUVScale;
+
+    // 选一级使屏幕矩形不超过一个纹素，这样最多跨 2x2 个纹素
+    vec2 extent = (hi.xy - lo.xy) * vec2(hiZSize);
+    int level = int(ceil(log2(max(max(extent.x, extent.y), 1.0))));
+    level = clamp(level, 0, hiZLevelCount - 1);
+    ivec2 levelSize = max(hiZSize >> level, ivec2(1));
+    ivec2 texelLo = clamp(ivec2(lo.xy * vec2(levelSize)), ivec2(0), levelSize - 1);
+    ivec2 texelHi = clamp(ivec2(hi.xy * vec2(levelSize)), ivec2(0), levelSize - 1);
+
+    float depth = texelFetch(hiZ, texelLo, level).r;
+    depth = max(depth, texelFetch(hiZ, ivec2(texelHi.x, texelLo.y), level).r);
+    depth = max(depth, texelFetch(hiZ, ivec2(texelLo.x, texelHi.y), level).r);
+    depth = max(depth, texelFetch(hiZ, texelHi, level).r);
+    return lo.z > depth;
+}
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= uint(objectCount)) return;
+
+    CullObject object = objects[index];
+    bool visible = object.batch.z != 0u && sphereVisible(object.sphere);
+    if (phase == 1) {
+        visible = visible && visibility[index] != 0u;
+    } else if (phase == 2) {
+        visible = visible && !(cullingEnabled && sphereOccluded(object.sphere));
+        // 上一帧可见的对象已在第一阶段画过，这里只更新可见性
+        bool drawn = visibility[index] != 0u;
+        visibility[index] = visible ? 1u : 0u;
+        if (drawn) return;
+    }
+    if (!visible) return;
+
+    // 在所属批次的区域内压缩写入
+    uint slot = uint(commandBase) + object.batch.y + atomicAdd(drawCounts[uint(countBase) + object.batch.x], 1u);
+    commands[slot] = DrawCommand(object.draw.x, 1u, object.draw.y, int(object.draw.z), slot);
+    drawData[slot] = InstanceData(object.modelMatrix, uvec4(object.draw.w, 0u, 0u, 0u));
+}
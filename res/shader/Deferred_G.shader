@@ -13,7 +13,8 @@ out VS_OUT {
     mat3 TBN; // 切线空间矩阵
 } vs_out;
 
-uniform mat4 modelMatrix;
+#include "include/Instancing.glsl"
+flat out uint materialIndex;
 layout(std140, binding = 0) uniform CameraUBO {
     mat4 viewProjectionMatrix;
     vec3 uViewPos;
@@ -21,11 +22,14 @@ layout(std140, binding = 0) uniform CameraUBO {
 
 void main()
 {
-    mat3 normalMatrix = mat3(modelMatrix);
+    InstanceData instance = fetchInstance();
+    mat4 model = instance.modelMatrix;
+    materialIndex = instance.material.x;
+    mat3 normalMatrix = mat3(model);
     normalMatrix = inverse(transpose(normalMatrix));
 
     // 使用格拉姆-施密特正交化方法计算切线空间矩阵TBN
-    vec3 T = normalize(vec3(modelMatrix * vec4(tangent, 0.0)));
+    vec3 T = normalize(vec3(model * vec4(tangent, 0.0)));
     vec3 N = normalize(normalMatrix * aNormal); 
     // re-orthogonalize T with respect to N
     T = normalize(T - dot(T, N) * N);
@@ -33,8 +37,8 @@ void main()
     vec3 B = cross(T, N) * tangentW; // 使用 tangentW 修正副切线方向
     vs_out.TBN = mat3(T, B, N);
 
-    gl_Position = viewProjectionMatrix * modelMatrix * vec4(aPos, 1.0);
-    vs_out.FragPos = vec3(modelMatrix * vec4(aPos, 1.0));
+    gl_Position = viewProjectionMatrix * model * vec4(aPos, 1.0);
+    vs_out.FragPos = vec3(model * vec4(aPos, 1.0));
     vs_out.TexCoord = aTexCoord;
     vs_out.viewPos = uViewPos;
 }
@@ -59,6 +63,17 @@ uniform sampler2D texture_normal0;
 uniform sampler2D texture_height0;
 uniform float height_scale;
 
+// 实例材质：与网格纹理相乘的系数，按顶点着色器传来的材质索引读取
+uniform bool instanced;
+flat in uint materialIndex;
+struct InstanceMaterial {
+    vec4 albedo;                // rgb 反照率，a 透明度
+    vec4 metallicRoughnessAO;   // x 金属度，y 粗糙度，z 环境光遮蔽
+};
+layout(std430, binding = 3) readonly buffer InstanceMaterialSSBO {
+    InstanceMaterial materials[];
+};
+
 out vec4 FragColor;
 
 // 平行映射函数
@@ -86,6 +101,9 @@ void main()
     gAlbedoSpec.rgb = texture(texture_diffuse0, shiftTexCoord).rgb;
     // 存储镜面强度到gAlbedoSpec的alpha分量
     gAlbedoSpec.a = texture(texture_specular0, shiftTexCoord).r;
+    if (instanced) {
+        gAlbedoSpec.rgb *= materials[materialIndex].albedo.rgb;
+    }
 }
 
 vec2 ParallaxMapping(vec2 texCoord, vec3 viewDir)
@@ -51,7 +51,7 @@ struct Light {
     int visibility;
     int isDirectional;
 
-    float padding1;
+    float radius;
     float padding2;
     float padding3;
 };
@@ -60,10 +60,15 @@ layout(std430, binding = 1) buffer LightBuffer {
 };
 uniform int numLights;
 
-uniform mat4 lightProjection;   // 用于平行光阴影的正交投影矩阵
+// 平行光级联阴影：每个平行光一个 2D 纹理数组，第 c 层为第 c 级；矩阵按 平行光序号 * MAX_CASCADES + 级 排列
+const int MAX_CASCADES = 4;
+uniform mat4 cascadeMatrices[16];
+uniform vec4 cascadeSplits;         // 各级覆盖到的观察空间深度
+uniform int cascadeCount;
+uniform mat4 cascadeViewMatrix;     // 烘焙阴影时摄像机的观察矩阵
 // 点光源立方体阴影所需的远剪裁面
 uniform float farPlane;
-uniform sampler2D shadowMaps[3];
+uniform sampler2DArray shadowMaps[3];
 uniform samplerCube shadowCubeMaps[3];
 
 // 设置调试模式
@@ -148,11 +153,17 @@ void main()
 // 计算平行光阴影因子，传入光的属性、当前法线以及阴影贴图索引
 float ComputeDirectionalShadow(Light light, int index, vec3 norm, vec3 FragPos)
 {
-    // 构造光的观察矩阵（这里假定 up 向量为 (0,1,0)）
-    vec3 up = vec3(0.0, 1.0, 0.0);
-    mat4 lightView = lookAt(light.position, light.position + light.direction, up);
-    mat4 lightSpaceMatrix = lightProjection * lightView;
-    vec4 FragPosLightSpace = lightSpaceMatrix * vec4(FragPos, 1.0);
+    // 按观察空间深度选择级联，超出最后一级（阴影距离）的点不计算阴影
+    float viewDepth = -(cascadeViewMatrix * vec4(FragPos, 1.0)).z;
+    int cascade = -1;
+    for (int c = 0; c < cascadeCount; ++c) {
+        if (viewDepth < cascadeSplits[c]) {
+            cascade = c;
+            break;
+        }
+    }
+    if (cascade < 0) return 0.0;
+    vec4 FragPosLightSpace = cascadeMatrices[index * MAX_CASCADES + cascade] * vec4(FragPos, 1.0);
 
     // 透视除法，将坐标转换到 [0,1] 区间
     vec3 projCoords = FragPosLightSpace.xyz / FragPosLightSpace.w;
@@ -170,7 +181,7 @@ float ComputeDirectionalShadow(Light light, int index, vec3 norm, vec3 FragPos)
     // 设定深度偏移（bias）以缓解自阴影问题
     float bias = max(0.05 * (1.0 - dot(norm, normalize(-light.direction))), 0.005);
 
-    float closestDepth = texture(shadowMaps[index], projCoords.xy).r;
+    float closestDepth = texture(shadowMaps[index], vec3(projCoords.xy, float(cascade))).r;
 
     // 简单的影子测试（此处可扩展为 PCF 滤波）
     float shadow = (projCoords.z - bias > closestDepth) ? 1.0 : 0.0;
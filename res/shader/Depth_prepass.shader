@@ -0,0 +1,27 @@
+#shader vertex
+#version 460 core
+// 只读取位置（GeometryPool 的位置流只有 location 0）
+layout (location = 0) in vec3 aPos;
+
+#include "include/Instancing.glsl"
+layout(std140, binding = 0) uniform CameraUBO {
+    mat4 viewProjectionMatrix;
+    vec3 uViewPos;
+};
+
+// G-buffer 阶段以 GL_EQUAL 比较深度，两边的 gl_Position 必须逐位一致：表达式与 PBR_G.shader 相同并声明为 invariant
+invariant gl_Position;
+
+void main()
+{
+    mat4 model = fetchInstance().modelMatrix;
+    gl_Position = viewProjectionMatrix * model * vec4(aPos, 1.0);
+}
+
+
+#shader fragment
+#version 460 core
+
+void main()
+{
+}
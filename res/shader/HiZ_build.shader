@@ -0,0 +1,37 @@
+#shader compute
+#version 460 core
+layout (local_size_x = 8, local_size_y = 8) in;
+
+// fromDepth 为真时源是深度纹理（深度格式不能作为 image 绑定，只能采样），否则是上一级 mip
+uniform bool fromDepth;
+uniform sampler2D depthTexture;
+layout(r32f, binding = 0) readonly uniform image2D srcLevel;
+layout(r32f, binding = 1) writeonly uniform image2D dstLevel;
+uniform ivec2 srcSize;
+uniform ivec2 dstSize;
+
+float loadDepth(ivec2 coord)
+{
+    coord = min(coord, srcSize - 1);
+    return fromDepth ? texelFetch(depthTexture, coord, 0).r : imageLoad(srcLevel, coord).r;
+}
+
+void main()
+{
+    ivec2 dst = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(dst, dstSize))) return;
+
+    // 取 2x2 最远深度；源尺寸为奇数时最后一行/列多覆盖一个纹素，保证不漏掉
+    ivec2 src = dst * 2;
+    ivec2 extent = ivec2(2);
+    if (dst.x == dstSize.x - 1 && (srcSize.x & 1) == 1) extent.x = 3;
+    if (dst.y == dstSize.y - 1 && (srcSize.y & 1) == 1) extent.y = 3;
+
+    float depth = 0.0;
+    for (int y = 0; y < extent.y; ++y) {
+        for (int x = 0; x < extent.x; ++x) {
+            depth = max(depth, loadDepth(src + ivec2(x, y)));
+        }
+    }
+    imageStore(dstLevel, dst, vec4(depth));
+}
@@ -0,0 +1,125 @@
+#shader compute
+#version 460 core
+// 与 ClusteredLighting.h 一致
+#define GRID_X 16
+#define GRID_Y 9
+#define GRID_Z 24
+#define MAX_LIGHTS_PER_CLUSTER 256
+#define WORKGROUP_SIZE 128
+layout (local_size_x = WORKGROUP_SIZE) in;
+
+// 与 Light.h 中的 LightUnit 一致
+struct Light {
+    vec3 position;
+    vec3 direction;
+    vec3 color;
+    vec3 intensity;
+
+    float constant;
+    float linear;
+    float quadratic;
+
+    int visibility;
+    int isDirectional;
+
+    float radius;
+    float padding2;
+    float padding3;
+};
+layout(std430, binding = 1) readonly buffer LightBuffer {
+    Light lights[];
+};
+layout(std430, binding = 9) writeonly buffer ClusterLightCountSSBO {
+    uint clusterLightCounts[];
+};
+layout(std430, binding = 10) writeonly buffer ClusterLightIndexSSBO {
+    uint clusterLightIndices[];
+};
+
+uniform mat4 inverseProjection;
+uniform mat4 viewMatrix;
+uniform float zNear;
+uniform float zFar;
+uniform bool orthographic;
+uniform int lightCount;
+
+// 一批灯光的观察空间影响球，由工作组内的线程合作读入
+shared vec4 sharedSpheres[WORKGROUP_SIZE];
+
+// 瓦片角点（NDC）在近平面上对应的观察空间位置
+vec3 nearPlanePoint(vec2 ndc)
+{
+    vec4 view = inverseProjection * vec4(ndc, -1.0, 1.0);
+    return view.xyz / view.w;
+}
+
+// 从摄像机穿过近平面上的点，到观察空间深度 depth 处（正交投影沿 -z 平移）
+vec3 pointAtDepth(vec3 nearPoint, float depth)
+{
+    if (orthographic) return vec3(nearPoint.xy, -depth);
+    return nearPoint * (depth / -nearPoint.z);
+}
+
+void main()
+{
+    uint cluster = gl_GlobalInvocationID.x;
+    bool active = cluster < uint(GRID_X * GRID_Y * GRID_Z);
+
+    // 簇的观察空间包围盒：瓦片四个角在该层前后两个深度处的 8 个点
+    vec3 boxMin = vec3(0.0);
+    vec3 boxMax = vec3(0.0);
+    if (active) {
+        uint x = cluster % uint(GRID_X);
+        uint y = (cluster / uint(GRID_X)) % uint(GRID_Y);
+        uint z = cluster / uint(GRID_X * GRID_Y);
+        vec2 ndcMin = vec2(x, y) / vec2(GRID_X, GRID_Y) * 2.0 - 1.0;
+        vec2 ndcMax = vec2(x + 1u, y + 1u) / vec2(GRID_X, GRID_Y) * 2.0 - 1.0;
+        // 指数分层：第 k 层起点为 zNear * (zFar / zNear)^(k / GRID_Z)
+        float depthNear = zNear * pow(zFar / zNear, float(z) / float(GRID_Z));
+        float depthFar = zNear * pow(zFar / zNear, float(z + 1u) / float(GRID_Z));
+
+        boxMin = vec3(1e30);
+        boxMax = vec3(-1e30);
+        for (int i = 0; i < 4; ++i) {
+            vec2 ndc = vec2((i & 1) != 0 ? ndcMax.x : ndcMin.x, (i & 2) != 0 ? ndcMax.y : ndcMin.y);
+            vec3 nearPoint = nearPlanePoint(ndc);
+            vec3 a = pointAtDepth(nearPoint, depthNear);
+            vec3 b = pointAtDepth(nearPoint, depthFar);
+            boxMin = min(boxMin, min(a, b));
+            boxMax = max(boxMax, max(a, b));
+        }
+    }
+
+    uint count = 0u;
+    uint base = cluster * uint(MAX_LIGHTS_PER_CLUSTER);
+    for (int batch = 0; batch < lightCount; batch += WORKGROUP_SIZE) {
+        int lightIndex = batch + int(gl_LocalInvocationID.x);
+        vec4 sphere = vec4(0.0, 0.0, 0.0, -1.0);   // 半径小于 0 表示跳过
+        if (lightIndex < lightCount) {
+            Light light = lights[lightIndex];
+            if (light.visibility != 0) {
+                // 平行光影响所有簇
+                float radius = light.isDirectional == 1 ? 1e30 : light.radius;
+                sphere = vec4((viewMatrix * vec4(light.position, 1.0)).xyz, radius);
+            }
+        }
+        sharedSpheres[gl_LocalInvocationID.x] = sphere;
+        barrier();
+
+        int batchSize = min(WORKGROUP_SIZE, lightCount - batch);
+        for (int i = 0; active && i < batchSize && count < uint(MAX_LIGHTS_PER_CLUSTER); ++i) {
+            vec4 s = sharedSpheres[i];
+            if (s.w < 0.0) continue;
+            // 球心到包围盒的最近距离不超过半径即相交
+            vec3 nearest = clamp(s.xyz, boxMin, boxMax);
+            vec3 delta = nearest - s.xyz;
+            if (dot(delta, delta) <= s.w * s.w) {
+                clusterLightIndices[base + count] = uint(batch + i);
+                count++;
+            }
+        }
+        barrier();
+    }
+
+    if (active) clusterLightCounts[cluster] = count;
+}
@@ -6,17 +6,26 @@ layout (location = 2) in vec2 aTexCoords;
 layout (location = 3) in vec3 tangent;
 layout (location = 4) in float tangentW;
 
-uniform mat4 modelMatrix;
+#include "include/Instancing.glsl"
+flat out uint materialIndex;
 layout(std140, binding = 0) uniform CameraUBO {
     mat4 viewProjectionMatrix;
     vec3 uViewPos;
 };
 
 out vec2 TexCoords;
+out vec3 FragPos;
+out vec3 Normal;
 
 void main() {
+    InstanceData instance = fetchInstance();
+    mat4 model = instance.modelMatrix;
+    materialIndex = instance.material.x;
     TexCoords = aTexCoords;
-    gl_Position = viewProjectionMatrix * modelMatrix * vec4(aPos, 1.0);
+    vec4 worldPos = model * vec4(aPos, 1.0);
+    FragPos = worldPos.xyz;
+    Normal = inverse(transpose(mat3(model))) * aNormal;
+    gl_Position = viewProjectionMatrix * worldPos;
 }
 
 
@@ -26,14 +35,126 @@ layout (location = 0) out vec4 accumColor;
 layout (location = 1) out float accumAlpha;
 
 in vec2 TexCoords;
+in vec3 FragPos;
+in vec3 Normal;
 
 uniform sampler2D texture_diffuse0;
 
+layout(std140, binding = 0) uniform CameraUBO {
+    mat4 viewProjectionMatrix;
+    vec3 uViewPos;
+};
+
+// 与 ClusteredLighting.h 一致
+#define GRID_X 16
+#define GRID_Y 9
+#define GRID_Z 24
+#define MAX_LIGHTS_PER_CLUSTER 256
+
+// 与 Light.h 中的 LightUnit 一致
+struct Light {
+    vec3 position;
+    vec3 direction;
+    vec3 color;
+    vec3 intensity;
+
+    float constant;
+    float linear;
+    float quadratic;
+
+    int visibility;
+    int isDirectional;
+
+    float radius;
+    float padding2;
+    float padding3;
+};
+layout(std430, binding = 1) readonly buffer LightBuffer {
+    Light lights[];
+};
+// 分簇光照剔除的结果（与 PBR 光照阶段共用）
+layout(std430, binding = 9) readonly buffer ClusterLightCountSSBO {
+    uint clusterLightCounts[];
+};
+layout(std430, binding = 10) readonly buffer ClusterLightIndexSSBO {
+    uint clusterLightIndices[];
+};
+uniform int numLights;      // 为 0 时不做光照，直接使用纹理颜色
+uniform bool clustered;     // 为真时只计算片段所在簇的灯光，否则遍历全部灯光
+uniform mat4 viewMatrix;
+uniform float zNear;
+uniform float zFar;
+uniform vec2 screenSize;    // 渲染区域的分辨率（动态分辨率下小于累积缓冲），用于由 gl_FragCoord 求瓦片
+
+// 实例材质：与网格纹理相乘的系数，按顶点着色器传来的材质索引读取
+uniform bool instanced;
+flat in uint materialIndex;
+struct InstanceMaterial {
+    vec4 albedo;                // rgb 反照率，a 透明度
+    vec4 metallicRoughnessAO;   // x 金属度，y 粗糙度，z 环境光遮蔽
+};
+layout(std430, binding = 3) readonly buffer InstanceMaterialSSBO {
+    InstanceMaterial materials[];
+};
+
+// 单个灯光的漫反射与镜面反射（Blinn-Phong）
+vec3 ComputeLight(Light light, vec3 N, vec3 V, vec3 albedo)
+{
+    vec3 L;
+    float attenuation = 1.0;
+    if (light.isDirectional == 1) {
+        L = normalize(-light.direction);
+    } else {
+        vec3 toLight = light.position - FragPos;
+        float dist = length(toLight);
+        if (dist >= light.radius) return vec3(0.0);
+        L = toLight / dist;
+        attenuation = 1.0 / (light.constant + light.linear * dist + light.quadratic * dist * dist);
+        // 在影响半径处平滑衰减到 0，与 PBR 光照阶段一致
+        float falloff = clamp(1.0 - pow(dist / light.radius, 4.0), 0.0, 1.0);
+        attenuation *= falloff * falloff;
+    }
+    vec3 H = normalize(L + V);
+    float diffuse = max(dot(N, L), 0.0) * light.intensity.y;
+    float specular = pow(max(dot(N, H), 0.0), 32.0) * light.intensity.z;
+    return (albedo * diffuse + vec3(specular)) * light.color * attenuation;
+}
+
+vec3 ComputeLighting(vec3 albedo)
+{
+    vec3 N = normalize(Normal);
+    vec3 V = normalize(uViewPos - FragPos);
+    // 透明面两侧都可见，法线朝向观察者
+    if (!gl_FrontFacing) N = -N;
+    vec3 result = albedo * 0.2;    // 环境光
+    if (clustered) {
+        float viewDepth = -(viewMatrix * vec4(FragPos, 1.0)).z;
+        int slice = int(floor(log(max(viewDepth, zNear) / zNear) / log(zFar / zNear) * float(GRID_Z)));
+        ivec2 tile = ivec2(gl_FragCoord.xy / screenSize * vec2(GRID_X, GRID_Y));
+        ivec3 cell = clamp(ivec3(tile, slice), ivec3(0), ivec3(GRID_X - 1, GRID_Y - 1, GRID_Z - 1));
+        uint cluster = uint(cell.x + cell.y * GRID_X + cell.z * GRID_X * GRID_Y);
+        uint count = clusterLightCounts[cluster];
+        uint base = cluster * uint(MAX_LIGHTS_PER_CLUSTER);
+        for (uint i = 0u; i < count; ++i) {
+            result += ComputeLight(lights[clusterLightIndices[base + i]], N, V, albedo);
+        }
+    } else {
+        for (int i = 0; i < numLights; ++i) {
+            if (lights[i].visibility == 0) continue;
+            result += ComputeLight(lights[i], N, V, albedo);
+        }
+    }
+    return result;
+}
 
 void main() {
     // 采样透明物体颜色
     vec4 color = texture(texture_diffuse0, TexCoords);
+    if (instanced) {
+        color *= materials[materialIndex].albedo;
+    }
     float alpha = color.a;
+    if (numLights > 0) color.rgb = ComputeLighting(color.rgb);
 
     // 计算权重（可调整）
     float weight = max(alpha, 0.01);
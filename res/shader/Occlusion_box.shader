@@ -0,0 +1,24 @@
+#shader vertex
+#version 460 core
+layout (location = 0) in vec3 aPos;
+
+// 包围盒：[-1, 1] 立方体经 modelMatrix 缩放平移
+uniform mat4 modelMatrix;
+layout(std140, binding = 0) uniform CameraUBO {
+    mat4 viewProjectionMatrix;
+    vec3 uViewPos;
+};
+
+void main()
+{
+    gl_Position = viewProjectionMatrix * modelMatrix * vec4(aPos, 1.0);
+}
+
+
+#shader fragment
+#version 460 core
+
+// 只用于遮挡查询，颜色和深度写入均已关闭
+void main()
+{
+}
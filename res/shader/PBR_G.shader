@@ -13,19 +13,26 @@ out VS_OUT {
     mat3 TBN; // 切线空间矩阵
 } vs_out;
 
-uniform mat4 modelMatrix;
+#include "include/Instancing.glsl"
+flat out uint materialIndex;
 layout(std140, binding = 0) uniform CameraUBO {
     mat4 viewProjectionMatrix;
     vec3 uViewPos;
 };
 
+// 开启深度预渲染时以 GL_EQUAL 比较深度，gl_Position 的表达式与 Depth_prepass.shader 相同并声明为 invariant
+invariant gl_Position;
+
 void main()
 {
-    mat3 normalMatrix = mat3(modelMatrix);
+    InstanceData instance = fetchInstance();
+    mat4 model = instance.modelMatrix;
+    materialIndex = instance.material.x;
+    mat3 normalMatrix = mat3(model);
     normalMatrix = inverse(transpose(normalMatrix));
 
     // 使用格拉姆-施密特正交化方法计算切线空间矩阵TBN
-    vec3 T = normalize(vec3(modelMatrix * vec4(tangent, 0.0)));
+    vec3 T = normalize(vec3(model * vec4(tangent, 0.0)));
     vec3 N = normalize(normalMatrix * aNormal); 
     // re-orthogonalize T with respect to N
     T = normalize(T - dot(T, N) * N);
@@ -33,18 +40,22 @@ void main()
     vec3 B = cross(T, N) * tangentW; // 使用 tangentW 修正副切线方向
     vs_out.TBN = mat3(T, B, N);
 
-    gl_Position = viewProjectionMatrix * modelMatrix * vec4(aPos, 1.0);
-    vs_out.FragPos = vec3(modelMatrix * vec4(aPos, 1.0));
+    gl_Position = viewProjectionMatrix * model * vec4(aPos, 1.0);
+    vs_out.FragPos = vec3(model * vec4(aPos, 1.0));
     vs_out.TexCoord = aTexCoord;
     vs_out.viewPos = uViewPos;
 }
 
 #shader fragment
 #version 460 core
-layout (location = 0) out vec4 gPosition;
-layout (location = 1) out vec3 gNormal;
-layout (location = 2) out vec3 gAlbedo;
-layout (location = 3) out vec3 gMetallicRoughnessAO;
+// 附件布局由 compactGBuffer 决定（与 Renderer::createPBRGBuffer 一致）：
+//   完整：0 位置+线性深度，1 法线，2 反照率，3 金属度/粗糙度/AO
+//   紧凑：0 八面体编码法线（RG16），1 反照率（SRGB8_ALPHA8），2 金属度/粗糙度/AO（RGBA8），位置由深度重建
+layout (location = 0) out vec4 gBuffer0;
+layout (location = 1) out vec4 gBuffer1;
+layout (location = 2) out vec4 gBuffer2;
+layout (location = 3) out vec4 gBuffer3;
+uniform bool compactGBuffer;
 
 in VS_OUT {
     vec3 FragPos;
@@ -63,10 +74,21 @@ uniform sampler2D texture_height0;
 
 uniform float height_scale;
 
-out vec4 FragColor;
+// 实例材质：与网格纹理相乘的系数，按顶点着色器传来的材质索引读取
+uniform bool instanced;
+flat in uint materialIndex;
+struct InstanceMaterial {
+    vec4 albedo;                // rgb 反照率，a 透明度
+    vec4 metallicRoughnessAO;   // x 金属度，y 粗糙度，z 环境光遮蔽
+};
+layout(std430, binding = 3) readonly buffer InstanceMaterialSSBO {
+    InstanceMaterial materials[];
+};
 
 // 平行映射函数
 vec2 ParallaxMapping(vec2 texCoord, vec3 viewDir);
+// 单位法线的八面体编码，结果在 [0, 1]，适合存入 UNORM 格式
+vec2 EncodeNormal(vec3 n);
 
 void main()
 {
@@ -80,18 +102,45 @@ void main()
     tangentNormal = normalize(tangentNormal * 2.0 - 1.0);
     vec3 worldNormal = normalize(fs_in.TBN * tangentNormal);
 
-    // 实际片段深度
-    float linearDepth = length(fs_in.viewPos - fs_in.FragPos);
-    // 存储第一个G缓冲纹理中的片段位置向量
-    gPosition = vec4(fs_in.FragPos, linearDepth); // 将深度信息存储在gPosition.a中
-    // 存储第二个G缓冲纹理中的片段法线向量(世界空间)
-    gNormal = worldNormal;
-    // 和漫反射对每个逐片段颜色
-    gAlbedo.rgb = texture(texture_diffuse0, shiftTexCoord).rgb;
-    // 存储金属度、粗糙度和环境光遮蔽到gMetallicRoughnessAO的分量
-    gMetallicRoughnessAO.r = texture(texture_metallic0, shiftTexCoord).r; // 金属度
-    gMetallicRoughnessAO.g = texture(texture_roughness0, shiftTexCoord).r; // 粗糙度
-    gMetallicRoughnessAO.b = texture(texture_ao0, shiftTexCoord).r; // 环境光遮蔽
+    // 漫反射颜色
+    vec3 albedo = texture(texture_diffuse0, shiftTexCoord).rgb;
+    // 金属度、粗糙度和环境光遮蔽
+    vec3 metallicRoughnessAO;
+    metallicRoughnessAO.r = texture(texture_metallic0, shiftTexCoord).r; // 金属度
+    metallicRoughnessAO.g = texture(texture_roughness0, shiftTexCoord).r; // 粗糙度
+    metallicRoughnessAO.b = texture(texture_ao0, shiftTexCoord).r; // 环境光遮蔽
+    if (instanced) {
+        InstanceMaterial material = materials[materialIndex];
+        albedo *= material.albedo.rgb;
+        metallicRoughnessAO *= material.metallicRoughnessAO.xyz;
+    }
+
+    if (compactGBuffer) {
+        gBuffer0 = vec4(EncodeNormal(worldNormal), 0.0, 0.0);
+        gBuffer1 = vec4(albedo, 1.0);
+        gBuffer2 = vec4(metallicRoughnessAO, 1.0);
+        gBuffer3 = vec4(0.0);   // 紧凑布局没有第 4 个附件，写入被丢弃
+    } else {
+        // 实际片段深度
+        float linearDepth = length(fs_in.viewPos - fs_in.FragPos);
+        // 片段位置，深度信息存储在 a 分量中
+        gBuffer0 = vec4(fs_in.FragPos, linearDepth);
+        // 片段法线向量(世界空间)
+        gBuffer1 = vec4(worldNormal, 0.0);
+        gBuffer2 = vec4(albedo, 0.0);
+        gBuffer3 = vec4(metallicRoughnessAO, 0.0);
+    }
+}
+
+vec2 EncodeNormal(vec3 n)
+{
+    // 投影到八面体 |x|+|y|+|z|=1 上，下半球沿对角线翻折到外侧四个三角形
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.xy;
+    if (n.z < 0.0) {
+        e = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return e * 0.5 + 0.5;
 }
 
 vec2 ParallaxMapping(vec2 texCoord, vec3 viewDir)
@@ -38,29 +38,89 @@ uniform sampler2D gNormal;
 uniform sampler2D gAlbedo;
 uniform sampler2D gMetallicRoughnessAO;
 uniform sampler2D ssao;
+// 紧凑 G-Buffer：没有 gPosition，位置由深度和逆视图投影矩阵重建，gNormal 为八面体编码
+uniform bool compactGBuffer;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+// 动态分辨率：G-Buffer 和 SSAO 只有左下角的渲染区域有效，采样坐标乘以该比例（屏幕位置和分簇仍用 TexCoord）
+uniform vec2 uvScale;
 
 uniform samplerCube texture_prefilterMap;
 uniform sampler2D   texture_brdfLUT;  
 
+// 与 ClusteredLighting.h 一致
+#define GRID_X 16
+#define GRID_Y 9
+#define GRID_Z 24
+#define MAX_LIGHTS_PER_CLUSTER 256
+
+// 与 Light.h 中的 LightUnit 一致
+struct Light {
+    vec3 position;
+    vec3 direction;
+    vec3 color;
+    vec3 intensity;
+
+    float constant;
+    float linear;
+    float quadratic;
+
+    int visibility;
+    int isDirectional;
+
+    float radius;
+    float padding2;
+    float padding3;
+};
+layout(std430, binding = 1) readonly buffer LightBuffer {
+    Light lights[];
+};
+// 分簇光照剔除的结果
+layout(std430, binding = 9) readonly buffer ClusterLightCountSSBO {
+    uint clusterLightCounts[];
+};
+layout(std430, binding = 10) readonly buffer ClusterLightIndexSSBO {
+    uint clusterLightIndices[];
+};
+uniform int numLights;      // 为 0 时只有环境光
+uniform bool clustered;     // 为真时只计算像素所在簇的灯光，否则遍历全部灯光
+uniform mat4 viewMatrix;
+uniform float zNear;
+uniform float zFar;
+
 // 设置调试模式
 uniform int debugMode;
 
 out vec4 FragColor;
 
 vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness);
+vec3 DecodeNormal(vec2 e);
+// 单个灯光的直接光照（Cook-Torrance）
+vec3 ComputeLight(Light light, vec3 FragPos, vec3 N, vec3 V, vec3 F0, vec3 Albedo, float Metallic, float Roughness);
 
 void main()
 {
     const float MAX_REFLECTION_LOD = 4.0;
 
     // 获取输入
-    vec3 FragPos = texture(gPosition, fs_in.TexCoord).rgb;
-    vec3 Normal = texture(gNormal, fs_in.TexCoord).rgb;
-    vec3 Albedo = texture(gAlbedo, fs_in.TexCoord).rgb;
-    float Metallic = texture(gMetallicRoughnessAO, fs_in.TexCoord).r;
-    float Roughness = texture(gMetallicRoughnessAO, fs_in.TexCoord).g;
-    float AO = texture(gMetallicRoughnessAO, fs_in.TexCoord).b;
-    float AmbientOcclusion = texture(ssao, fs_in.TexCoord).r;   // 这个是SSAO
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 uv = fs_in.TexCoord * uvScale;
+    if (compactGBuffer) {
+        float depth = texture(gDepth, uv).r;
+        vec4 world = inverseViewProjection * vec4(vec3(fs_in.TexCoord, depth) * 2.0 - 1.0, 1.0);
+        FragPos = world.xyz / world.w;
+        // 背景像素（深度为 1）与完整布局一样以零法线表示
+        Normal = depth < 1.0 ? DecodeNormal(texture(gNormal, uv).rg) : vec3(0.0);
+    } else {
+        FragPos = texture(gPosition, uv).rgb;
+        Normal = texture(gNormal, uv).rgb;
+    }
+    vec3 Albedo = texture(gAlbedo, uv).rgb;
+    float Metallic = texture(gMetallicRoughnessAO, uv).r;
+    float Roughness = texture(gMetallicRoughnessAO, uv).g;
+    float AO = texture(gMetallicRoughnessAO, uv).b;
+    float AmbientOcclusion = texture(ssao, uv).r;   // 这个是SSAO
 
     vec3 V = normalize(fs_in.viewPos - FragPos);
     vec3 N = normalize(Normal);
@@ -85,13 +145,94 @@ void main()
     vec3 ambient = (kD * diffuse + specular) * AO; 
     ambient = ambient * AmbientOcclusion; // 乘以环境光遮蔽因子
 
-    vec3 color = ambient;
-    color = color / (color + vec3(1.0)); // tone mapping
-    color = pow(color, vec3(1.0/2.2));   // gamma correction
+    // 直接光照：背景像素（法线为 0）没有几何，跳过
+    vec3 Lo = vec3(0.0);
+    if (numLights > 0 && dot(Normal, Normal) > 0.0) {
+        if (clustered) {
+            // 屏幕位置决定瓦片，观察空间深度按指数分层决定层
+            float viewDepth = -(viewMatrix * vec4(FragPos, 1.0)).z;
+            int slice = int(floor(log(max(viewDepth, zNear) / zNear) / log(zFar / zNear) * float(GRID_Z)));
+            ivec3 cell = clamp(ivec3(ivec2(fs_in.TexCoord * vec2(GRID_X, GRID_Y)), slice), ivec3(0), ivec3(GRID_X - 1, GRID_Y - 1, GRID_Z - 1));
+            uint cluster = uint(cell.x + cell.y * GRID_X + cell.z * GRID_X * GRID_Y);
+            uint count = clusterLightCounts[cluster];
+            uint base = cluster * uint(MAX_LIGHTS_PER_CLUSTER);
+            for (uint i = 0u; i < count; ++i) {
+                Lo += ComputeLight(lights[clusterLightIndices[base + i]], FragPos, N, V, F0, Albedo, Metallic, Roughness);
+            }
+        } else {
+            for (int i = 0; i < numLights; ++i) {
+                if (lights[i].visibility == 0) continue;
+                Lo += ComputeLight(lights[i], FragPos, N, V, F0, Albedo, Metallic, Roughness);
+            }
+        }
+    }
+
+    // 输出线性 HDR 颜色，色调映射和 gamma 校正在最后的 Composite 通道统一进行
+    vec3 color = ambient + Lo;
     FragColor = vec4(color, 1.0);
 }
 
 vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
 {
     return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(1.0 - cosTheta, 5.0);
-}   
\ No newline at end of file
+}
+
+// 与 PBR_G.shader 中的 EncodeNormal 互逆
+vec3 DecodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+float DistributionGGX(vec3 N, vec3 H, float roughness)
+{
+    float a = roughness * roughness;
+    float a2 = a * a;
+    float NdotH = max(dot(N, H), 0.0);
+    float denom = NdotH * NdotH * (a2 - 1.0) + 1.0;
+    return a2 / (3.14159265 * denom * denom);
+}
+
+float GeometrySmith(float NdotV, float NdotL, float roughness)
+{
+    float r = roughness + 1.0;
+    float k = r * r / 8.0;
+    float ggxV = NdotV / (NdotV * (1.0 - k) + k);
+    float ggxL = NdotL / (NdotL * (1.0 - k) + k);
+    return ggxV * ggxL;
+}
+
+vec3 ComputeLight(Light light, vec3 FragPos, vec3 N, vec3 V, vec3 F0, vec3 Albedo, float Metallic, float Roughness)
+{
+    vec3 L;
+    float attenuation = 1.0;
+    if (light.isDirectional == 1) {
+        L = normalize(-light.direction);
+    } else {
+        vec3 toLight = light.position - FragPos;
+        float dist = length(toLight);
+        if (dist >= light.radius) return vec3(0.0);
+        L = toLight / dist;
+        attenuation = 1.0 / (light.constant + light.linear * dist + light.quadratic * dist * dist);
+        // 在影响半径处平滑衰减到 0，避免簇边界出现硬边
+        float falloff = clamp(1.0 - pow(dist / light.radius, 4.0), 0.0, 1.0);
+        attenuation *= falloff * falloff;
+    }
+    float NdotL = max(dot(N, L), 0.0);
+    if (NdotL <= 0.0) return vec3(0.0);
+    float NdotV = max(dot(N, V), 1e-4);
+    vec3 H = normalize(V + L);
+
+    float NDF = DistributionGGX(N, H, Roughness);
+    float G = GeometrySmith(NdotV, NdotL, Roughness);
+    vec3 F = F0 + (1.0 - F0) * pow(clamp(1.0 - max(dot(H, V), 0.0), 0.0, 1.0), 5.0);
+    vec3 specular = NDF * G * F / (4.0 * NdotV * NdotL + 1e-4);
+    vec3 kD = (vec3(1.0) - F) * (1.0 - Metallic);
+
+    vec3 radiance = light.color * light.intensity.y * attenuation;
+    return (kD * Albedo / 3.14159265 + specular) * radiance * NdotL;
+}
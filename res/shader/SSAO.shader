@@ -35,38 +35,95 @@ in VS_OUT {
     mat4 projection;
 } fs_in;
 
-out float FragColor;
+// r 为遮蔽因子，g 为该像素到摄像机的距离（供模糊和上采样比较深度）
+out vec2 FragColor;
 
 uniform sampler2D gPosition;
 uniform sampler2D gNormal;
+// 紧凑 G-Buffer：没有 gPosition，位置由深度和逆视图投影矩阵重建，gNormal 为八面体编码
+uniform bool compactGBuffer;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+uniform ivec2 gBufferSize;      // G-Buffer 中有效的渲染区域（动态分辨率下只占纹理的左下角）
 
 uniform sampler2D texture_noise; // 噪声纹理
 
-uniform vec3 samples[64];
+// 与 AmbientOcclusion.h 一致，内核只在大小改变时上传
+#define MAX_KERNEL_SIZE 64
+layout(std140, binding = 1) uniform SSAOKernelUBO {
+    vec4 samples[MAX_KERNEL_SIZE];
+};
+uniform int kernelSize;
+// 第 i 个采样取 samples[kernelOffset + i * kernelStride]：时域模式每帧取完整内核中交错的一组，否则为 0 和 1
+uniform int kernelOffset;
+uniform int kernelStride;
+uniform float noiseRotation;    // 时域模式每帧旋转噪声的角度（弧度）
 
 // 屏幕的平铺噪声纹理会根据屏幕分辨率除以噪声大小的值来决定
 uniform vec2 noiseScale;
 uniform float ssaoStrengh; // 亮度调整指数
 
+// 低分辨率下一个像素覆盖多个 G-Buffer 纹素，按最近纹素读取，避免线性过滤混合边缘两侧的位置
+ivec2 GBufferTexel(vec2 uv)
+{
+    return clamp(ivec2(uv * vec2(gBufferSize)), ivec2(0), gBufferSize - 1);
+}
+
+// 屏幕坐标 uv 处的世界空间位置
+vec3 ReconstructPosition(vec2 uv)
+{
+    float depth = texelFetch(gDepth, GBufferTexel(uv), 0).r;
+    vec4 world = inverseViewProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    return world.xyz / world.w;
+}
+
+// 屏幕坐标 uv 处片段到摄像机的距离（完整布局存放在 gPosition.a 中）
+float SampleDistance(vec2 uv)
+{
+    if (compactGBuffer) return length(ReconstructPosition(uv) - fs_in.viewPos);
+    return texelFetch(gPosition, GBufferTexel(uv), 0).a;
+}
+
+// 与 PBR_G.shader 中的 EncodeNormal 互逆
+vec3 DecodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 void main()
 {
-    vec3 fragPos = texture(gPosition, fs_in.TexCoord).xyz;
-    float fragDepth = texture(gPosition, fs_in.TexCoord).a;
-    vec3 normal = texture(gNormal, fs_in.TexCoord).rgb;
+    ivec2 texel = GBufferTexel(fs_in.TexCoord);
+    vec3 fragPos;
+    vec3 normal;
+    if (compactGBuffer) {
+        fragPos = ReconstructPosition(fs_in.TexCoord);
+        normal = DecodeNormal(texelFetch(gNormal, texel, 0).rg);
+    } else {
+        fragPos = texelFetch(gPosition, texel, 0).xyz;
+        normal = texelFetch(gNormal, texel, 0).rgb;
+    }
+    float fragDepth = SampleDistance(fs_in.TexCoord);
     vec3 randomVec = texture(texture_noise, fs_in.TexCoord * noiseScale).xyz;
+    float c = cos(noiseRotation);
+    float s = sin(noiseRotation);
+    randomVec.xy = mat2(c, s, -s, c) * randomVec.xy;
 
     vec3 tangent = normalize(randomVec - normal * dot(randomVec, normal));
     vec3 bitangent = cross(normal, tangent);
     mat3 TBN = mat3(tangent, bitangent, normal);
 
     float radius = 1.0; // 采样半径
-    int kernelSize = 64; // 采样数量
     float bias = 0.025; // 深度偏移量
     float occlusion = 0.0;
     for(int i = 0; i < kernelSize; ++i)
     {
         // 获取样本位置
-        vec3 sample_unit = TBN * samples[i]; // 切线->世界空间
+        vec3 sample_unit = TBN * samples[kernelOffset + i * kernelStride].xyz; // 切线->世界空间
         sample_unit = fragPos + normal * bias + sample_unit * radius;
         float sample_depth = length(sample_unit - fs_in.viewPos); // 计算实际采样点深度
 
@@ -74,13 +131,13 @@ void main()
         vec4 sampleClip = fs_in.projection * vec4(sample_unit, 1.0); // 世界->裁剪空间
         sampleClip.xyz /= sampleClip.w; // 透视除法
         sampleClip.xyz = sampleClip.xyz * 0.5 + 0.5; // 归一化到[0,1]
-        float sampleDepth = texture(gPosition, sampleClip.xy).a;
+        float sampleDepth = SampleDistance(sampleClip.xy);
 
         float rangeCheck = smoothstep(0.0, 1.0, radius / abs(fragDepth - sampleDepth));
         occlusion += (sampleDepth <= sample_depth ? 1.0 : 0.0) * rangeCheck;   
     }
-    occlusion = 1.0 - (occlusion / kernelSize); // 归一化
+    occlusion = 1.0 - (occlusion / float(max(kernelSize, 1))); // 归一化
 
 
-    FragColor = pow(occlusion, ssaoStrengh);
-}
+    FragColor = vec2(pow(occlusion, ssaoStrengh), fragDepth);
+}
\ No newline at end of file
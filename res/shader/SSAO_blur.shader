@@ -0,0 +1,77 @@
+#shader vertex
+#version 460 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec3 tangent;
+layout (location = 4) in float tangentW;
+
+void main()
+{
+    gl_Position = vec4(aPos.xy, 0.0, 1.0);
+}
+
+
+#shader fragment
+#version 460 core
+
+// 一维双边模糊，水平和竖直各做一次
+// 权重 = 高斯 × 距离相近程度 × 法线相近程度，几何边缘两侧的遮蔽不会互相渗透
+out vec2 FragColor;
+
+uniform sampler2D aoTexture;    // r 遮蔽，g 到摄像机的距离（与 SSAO.shader 的输出一致）
+uniform ivec2 direction;        // (1, 0) 水平，(0, 1) 竖直
+
+uniform sampler2D gNormal;
+// 紧凑 G-Buffer：gNormal 为八面体编码
+uniform bool compactGBuffer;
+// 有效区域：动态分辨率下低分辨率缓冲和 G-Buffer 都只用到左下角
+uniform ivec2 aoSize;
+uniform ivec2 gBufferSize;
+
+#define RADIUS 4
+const float weights[RADIUS + 1] = float[](0.2270, 0.1945, 0.1216, 0.0541, 0.0162);
+const float DEPTH_SHARPNESS = 0.05;     // 距离差超过自身距离的这一比例后权重迅速衰减
+const float NORMAL_POWER = 8.0;
+
+// 与 PBR_G.shader 中的 EncodeNormal 互逆
+vec3 DecodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+// 低分辨率纹素中心对应的 G-Buffer 法线
+vec3 FetchNormal(ivec2 aoTexel)
+{
+    ivec2 texel = clamp(ivec2((vec2(aoTexel) + 0.5) / vec2(aoSize) * vec2(gBufferSize)), ivec2(0), gBufferSize - 1);
+    if (compactGBuffer) return DecodeNormal(texelFetch(gNormal, texel, 0).rg);
+    return texelFetch(gNormal, texel, 0).rgb;
+}
+
+void main()
+{
+    ivec2 size = aoSize;
+    ivec2 center = ivec2(gl_FragCoord.xy);
+    vec2 centerAO = texelFetch(aoTexture, center, 0).rg;
+    vec3 centerNormal = FetchNormal(center);
+
+    float sum = centerAO.r * weights[0];
+    float totalWeight = weights[0];
+    for (int i = 1; i <= RADIUS; ++i) {
+        for (int side = -1; side <= 1; side += 2) {
+            ivec2 texel = clamp(center + direction * i * side, ivec2(0), size - 1);
+            vec2 ao = texelFetch(aoTexture, texel, 0).rg;
+            float depthWeight = exp(-abs(ao.g - centerAO.g) / (DEPTH_SHARPNESS * max(centerAO.g, 1e-3)));
+            float normalWeight = pow(max(dot(FetchNormal(texel), centerNormal), 0.0), NORMAL_POWER);
+            float weight = weights[i] * depthWeight * normalWeight;
+            sum += ao.r * weight;
+            totalWeight += weight;
+        }
+    }
+    FragColor = vec2(sum / totalWeight, centerAO.g);
+}
@@ -0,0 +1,79 @@
+#shader vertex
+#version 460 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec3 tangent;
+layout (location = 4) in float tangentW;
+
+void main()
+{
+    gl_Position = vec4(aPos.xy, 0.0, 1.0);
+}
+
+
+#shader fragment
+#version 460 core
+
+// 时域累积：按上一帧的视图投影矩阵找到本像素在历史中的位置，距离相符时与本帧结果混合
+// 输出 r 遮蔽，g 本帧距离，b 已累积的帧数（混合权重为 1 / 帧数，达到 maxHistory 后按固定比例滑动平均）
+out vec4 FragColor;
+
+uniform sampler2D aoTexture;        // 本帧：r 遮蔽，g 到摄像机的距离（与 SSAO.shader 的输出一致）
+uniform sampler2D historyTexture;   // 上一帧的输出
+uniform bool historyValid;
+uniform mat4 previousViewProjection;
+uniform vec3 previousViewPos;
+uniform float maxHistory;
+
+uniform sampler2D gPosition;
+// 紧凑 G-Buffer：没有 gPosition，位置由深度和逆视图投影矩阵重建
+uniform bool compactGBuffer;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+// 有效区域：动态分辨率下低分辨率缓冲和 G-Buffer 都只用到左下角（区域改变时历史被丢弃，历史与本帧的区域相同）
+uniform ivec2 aoSize;
+uniform ivec2 gBufferSize;
+
+// 重投影点到上一帧摄像机的距离与历史记录相差超过该比例时视为遮挡关系改变
+const float DISOCCLUSION_THRESHOLD = 0.05;
+
+// 与 SSAO.shader 相同：按最近的 G-Buffer 纹素取世界空间位置
+vec3 FetchPosition(vec2 uv)
+{
+    ivec2 texel = clamp(ivec2(uv * vec2(gBufferSize)), ivec2(0), gBufferSize - 1);
+    if (compactGBuffer) {
+        float depth = texelFetch(gDepth, texel, 0).r;
+        vec4 world = inverseViewProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+        return world.xyz / world.w;
+    }
+    return texelFetch(gPosition, texel, 0).xyz;
+}
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec2 current = texelFetch(aoTexture, texel, 0).rg;
+    vec2 uv = (vec2(texel) + 0.5) / vec2(aoSize);
+
+    float history = 0.0;
+    float count = 0.0;
+    // 距离为 0 是完整布局的背景像素，没有几何可以重投影
+    if (historyValid && current.g > 0.0) {
+        vec3 worldPos = FetchPosition(uv);
+        vec4 previousClip = previousViewProjection * vec4(worldPos, 1.0);
+        if (previousClip.w > 0.0) {
+            vec2 previousUV = previousClip.xy / previousClip.w * 0.5 + 0.5;
+            if (all(greaterThanEqual(previousUV, vec2(0.0))) && all(lessThanEqual(previousUV, vec2(1.0)))) {
+                vec3 previous = texture(historyTexture, previousUV * vec2(aoSize) / vec2(textureSize(historyTexture, 0))).rgb;
+                float expected = length(worldPos - previousViewPos);
+                if (abs(previous.g - expected) <= DISOCCLUSION_THRESHOLD * expected) {
+                    history = previous.r;
+                    count = previous.b;
+                }
+            }
+        }
+    }
+    count = min(count + 1.0, maxHistory);
+    FragColor = vec4(mix(history, current.r, 1.0 / count), current.g, count, 1.0);
+}
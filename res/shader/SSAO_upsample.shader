@@ -0,0 +1,81 @@
+#shader vertex
+#version 460 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec3 tangent;
+layout (location = 4) in float tangentW;
+
+out VS_OUT {
+    vec3 viewPos;
+    vec2 TexCoord;
+} vs_out;
+
+layout(std140, binding = 0) uniform CameraUBO {
+    mat4 viewProjectionMatrix;
+    vec3 uViewPos;
+};
+
+void main()
+{
+    vs_out.viewPos = uViewPos;
+    vs_out.TexCoord = aTexCoord;
+    gl_Position = vec4(aPos.xy, 0.0, 1.0);
+}
+
+
+#shader fragment
+#version 460 core
+
+in VS_OUT {
+    vec3 viewPos;
+    vec2 TexCoord;
+} fs_in;
+
+// 双边上采样：取低分辨率中包围该像素的 2x2 个纹素，双线性权重再乘以与本像素距离的相近程度
+out float FragColor;
+
+uniform sampler2D aoTexture;    // r 遮蔽，g 到摄像机的距离（与 SSAO.shader 的输出一致）
+uniform int resolutionDivisor;
+uniform ivec2 aoSize;           // 低分辨率缓冲中有效的区域（动态分辨率下只占左下角）
+
+uniform sampler2D gPosition;
+// 紧凑 G-Buffer：没有 gPosition，位置由深度和逆视图投影矩阵重建
+uniform bool compactGBuffer;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+
+// 本像素到摄像机的距离，与 SSAO.shader 中的 SampleDistance 一致
+float PixelDistance()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    if (compactGBuffer) {
+        float depth = texelFetch(gDepth, texel, 0).r;
+        vec4 world = inverseViewProjection * vec4(vec3(fs_in.TexCoord, depth) * 2.0 - 1.0, 1.0);
+        return length(world.xyz / world.w - fs_in.viewPos);
+    }
+    return texelFetch(gPosition, texel, 0).a;
+}
+
+void main()
+{
+    float pixelDistance = PixelDistance();
+    ivec2 size = aoSize;
+    // 低分辨率纹素中心位于 (i + 0.5) * resolutionDivisor
+    vec2 lowCoord = gl_FragCoord.xy / float(resolutionDivisor) - 0.5;
+    ivec2 base = ivec2(floor(lowCoord));
+    vec2 f = lowCoord - vec2(base);
+
+    float sum = 0.0;
+    float totalWeight = 0.0;
+    for (int i = 0; i < 4; ++i) {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 texel = clamp(base + offset, ivec2(0), size - 1);
+        vec2 ao = texelFetch(aoTexture, texel, 0).rg;
+        vec2 bilinear = mix(1.0 - f, f, vec2(offset));
+        float weight = bilinear.x * bilinear.y / (abs(ao.g - pixelDistance) + 1e-3);
+        sum += ao.r * weight;
+        totalWeight += weight;
+    }
+    FragColor = totalWeight > 0.0 ? sum / totalWeight : texelFetch(aoTexture, clamp(ivec2(gl_FragCoord.xy) / resolutionDivisor, ivec2(0), size - 1), 0).r;
+}
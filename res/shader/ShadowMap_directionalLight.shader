@@ -7,11 +7,12 @@ layout (location = 3) in vec3 tangent;
 layout (location = 4) in float tangentW;
 
 uniform mat4 lightSpaceMatrix;
-uniform mat4 modelMatrix;
+#include "include/Instancing.glsl"
 
 void main()
 {
-    gl_Position = lightSpaceMatrix * modelMatrix * vec4(aPos, 1.0f);
+    mat4 model = fetchInstance().modelMatrix;
+    gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0f);
 }
 
 
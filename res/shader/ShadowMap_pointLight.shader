@@ -6,11 +6,12 @@ layout (location = 2) in vec2 aTexCoord;
 layout (location = 3) in vec3 tangent;
 layout (location = 4) in float tangentW;
 
-uniform mat4 modelMatrix;
+#include "include/Instancing.glsl"
 
 void main()
 {
-    gl_Position = modelMatrix * vec4(aPos, 1.0f);
+    mat4 model = fetchInstance().modelMatrix;
+    gl_Position = model * vec4(aPos, 1.0f);
 }
 
 #shader geometry
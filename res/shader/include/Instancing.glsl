@@ -0,0 +1,25 @@
+// 逐物体数据：普通绘制取 modelMatrix；实例化绘制（instanced）与多重间接绘制（multiDraw）取自绑定点 2 的 SSBO
+uniform mat4 modelMatrix;
+// 实例化绘制：instanced 为真时模型矩阵取自实例 SSBO，gl_InstanceID 先经过剔除后的可见实例列表
+uniform bool instanced;
+// 多重间接绘制：multiDraw 为真时同一绑定点存放逐绘制数据，下标为 drawOffset + gl_DrawID
+uniform bool multiDraw;
+uniform int drawOffset;
+struct InstanceData {
+    mat4 modelMatrix;
+    uvec4 material;     // x 为材质索引
+};
+layout(std430, binding = 2) readonly buffer InstanceSSBO {
+    InstanceData instances[];
+};
+layout(std430, binding = 4) readonly buffer VisibleInstanceSSBO {
+    uint visibleInstances[];
+};
+
+// 本次绘制的模型矩阵与材质（普通绘制的材质索引为 0）
+InstanceData fetchInstance()
+{
+    if (instanced) return instances[visibleInstances[gl_InstanceID]];
+    if (multiDraw) return instances[drawOffset + gl_DrawID];
+    return InstanceData(modelMatrix, uvec4(0u));
+}
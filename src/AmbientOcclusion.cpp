@@ -0,0 +1,280 @@
+#include "AmbientOcclusion.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "Mesh.h"
+#include "Renderer.h"
+#include "GLStats.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <cstdlib>
+
+Shader* AmbientOcclusion::get_blur_shader()
+{
+    static Shader* blurShader = nullptr;
+    if (!blurShader)
+    {
+        blurShader = new Shader("res/shader/SSAO_blur.shader");
+    }
+    return blurShader;
+}
+
+Shader* AmbientOcclusion::get_upsample_shader()
+{
+    static Shader* upsampleShader = nullptr;
+    if (!upsampleShader)
+    {
+        upsampleShader = new Shader("res/shader/SSAO_upsample.shader");
+    }
+    return upsampleShader;
+}
+
+Shader* AmbientOcclusion::get_temporal_shader()
+{
+    static Shader* temporalShader = nullptr;
+    if (!temporalShader)
+    {
+        temporalShader = new Shader("res/shader/SSAO_temporal.shader");
+    }
+    return temporalShader;
+}
+
+AmbientOcclusion::~AmbientOcclusion() = default;
+
+std::vector<glm::vec3> AmbientOcclusion::generateKernel(int kernelSize)
+{
+    std::vector<glm::vec3> kernel;
+    kernel.reserve(kernelSize);
+
+    for (int i = 0; i < kernelSize; ++i) {
+        glm::vec3 sample(
+            (float)rand() / RAND_MAX * 2.0f - 1.0f, // x in [-1, 1]
+            (float)rand() / RAND_MAX * 2.0f - 1.0f, // y in [-1, 1]
+            (float)rand() / RAND_MAX                // z in [0, 1]
+        );
+        sample = glm::normalize(sample);
+        sample *= (float)rand() / RAND_MAX;
+
+        // 让靠近原点的点分布更密集（指数分布）
+        float scale = (float)i / kernelSize;
+        scale = glm::mix(0.1f, 1.0f, scale * scale);
+        sample *= scale;
+
+        kernel.push_back(sample);
+    }
+
+    return kernel;
+}
+
+void AmbientOcclusion::set_resolutionDivisor(int divisor)
+{
+    resolutionDivisor = divisor >= 4 ? 4 : (divisor >= 2 ? 2 : 1);
+}
+
+void AmbientOcclusion::set_kernelSize(int size)
+{
+    kernelSize = std::clamp(size, 1, MAX_KERNEL_SIZE);
+}
+
+void AmbientOcclusion::set_temporalEnabled(bool enabled)
+{
+    if (enabled == temporalEnabled) return;
+    temporalEnabled = enabled;
+    historyValid = false;
+}
+
+void AmbientOcclusion::set_temporalSampleCount(int count)
+{
+    temporalSampleCount = std::clamp(count, 1, MAX_KERNEL_SIZE);
+}
+
+void AmbientOcclusion::resize(int targetWidth, int targetHeight)
+{
+    int lowWidth = std::max(1, targetWidth / resolutionDivisor);
+    int lowHeight = std::max(1, targetHeight / resolutionDivisor);
+    if (historyFramebuffers[0] && lowWidth == width && lowHeight == height) return;
+    width = lowWidth;
+    height = lowHeight;
+
+    // 历史与低分辨率缓冲同尺寸，跨帧保留，不从帧缓冲池申请；重新分配后旧的历史作废
+    std::vector<Framebuffer::AttachmentConfig> attachments = {
+        {GL_RGBA16F, GL_RGBA, GL_FLOAT}
+    };
+    for (auto& framebuffer : historyFramebuffers) {
+        framebuffer = std::make_unique<Framebuffer>(width, height, attachments, false, false);
+    }
+    historyValid = false;
+}
+
+void AmbientOcclusion::uploadKernel()
+{
+    // 时域模式每帧从完整内核中取一组交错的采样
+    int size = temporalEnabled ? MAX_KERNEL_SIZE : kernelSize;
+    if (kernelUBO && size == uploadedKernelSize) return;
+    if (!kernelUBO) {
+        kernelUBO = std::make_unique<UBO>(sizeof(glm::vec4) * MAX_KERNEL_SIZE, KERNEL_UBO_BINDING);
+    }
+    // std140 下 vec3 数组的步长为 16 字节，按 vec4 上传
+    std::vector<glm::vec4> samples(MAX_KERNEL_SIZE, glm::vec4(0.0f));
+    std::vector<glm::vec3> kernel = generateKernel(size);
+    for (int i = 0; i < size; ++i) {
+        samples[i] = glm::vec4(kernel[i], 0.0f);
+    }
+    kernelUBO->UpdateData(samples.data(), samples.size() * sizeof(glm::vec4), 0);
+    uploadedKernelSize = size;
+}
+
+void AmbientOcclusion::bindGBuffer(Shader* shader, const GBufferInputs& gBuffer, bool position, bool normal)
+{
+    if (position) {
+        glActiveTexture(GL_TEXTURE0);
+        gl::bindTexture(GL_TEXTURE_2D, gBuffer.position);
+        shader->setUniform1i(gBuffer.compact ? "gDepth" : "gPosition", 0);
+        glm::mat4 inverseViewProjection = gBuffer.inverseViewProjection;
+        if (gBuffer.compact) shader->setUniform4fv("inverseViewProjection", inverseViewProjection);
+    }
+    if (normal) {
+        glActiveTexture(GL_TEXTURE1);
+        gl::bindTexture(GL_TEXTURE_2D, gBuffer.normal);
+        shader->setUniform1i("gNormal", 1);
+    }
+    shader->setUniform1i("compactGBuffer", gBuffer.compact ? 1 : 0);
+}
+
+void AmbientOcclusion::compute(Shader* ssaoShader, const GBufferInputs& gBuffer, Framebuffer& target, Mesh& screen, float strength)
+{
+    CPU_PROFILE_SCOPE("AmbientOcclusion::compute");
+    resize(target.get_width(), target.get_height());
+    int renderWidth = gBuffer.width > 0 ? std::min(gBuffer.width, target.get_width()) : target.get_width();
+    int renderHeight = gBuffer.height > 0 ? std::min(gBuffer.height, target.get_height()) : target.get_height();
+    int lowWidth = std::max(1, renderWidth / resolutionDivisor);
+    int lowHeight = std::max(1, renderHeight / resolutionDivisor);
+    if (lowWidth != viewportWidth || lowHeight != viewportHeight) {
+        // 历史按区域大小记录，渲染分辨率改变后无法直接重投影
+        viewportWidth = lowWidth;
+        viewportHeight = lowHeight;
+        historyValid = false;
+    }
+    if (!noiseTexture) {
+        noiseTexture = std::make_unique<Texture>();
+        noiseTexture->add_noise_texture(); // 添加噪声纹理
+    }
+    uploadKernel();
+    kernelUBO->SetBindingPoint(KERNEL_UBO_BINDING);
+    FramebufferPool& pool = Renderer::getInstance().get_framebufferPool();
+    FramebufferPool::Desc aoDesc;
+    aoDesc.width = width;
+    aoDesc.height = height;
+    aoDesc.attachments = { {GL_RG16F, GL_RG, GL_FLOAT} };
+    Framebuffer* aoFramebuffers[2] = { pool.acquire(aoDesc), pool.acquire(aoDesc) };
+    frameIndex++;
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    // 低分辨率缓冲只画 lowWidth x lowHeight，target 只画渲染区域
+    auto bindTarget = [&](Framebuffer& framebuffer) {
+        framebuffer.bind();
+        if (&framebuffer == &target) {
+            glViewport(0, 0, renderWidth, renderHeight);
+        } else {
+            glViewport(0, 0, lowWidth, lowHeight);
+        }
+    };
+    auto bindAO = [](Shader* shader, const Framebuffer& framebuffer) {
+        glActiveTexture(GL_TEXTURE3);
+        gl::bindTexture(GL_TEXTURE_2D, framebuffer.get_texture(0));
+        shader->setUniform1i("aoTexture", 3);
+    };
+    bool upsample = resolutionDivisor > 1;
+    bool temporal = temporalEnabled;
+    // 时域模式不模糊时仍需把历史复制到 target，由上采样（因子为 1 时逐纹素对应）完成
+    bool resolve = upsample || (temporal && !blurEnabled);
+
+    // 遮蔽：全分辨率、不模糊也不做时域累积时就是原来的单次绘制
+    bindTarget(resolve || blurEnabled ? *aoFramebuffers[0] : target);
+    glClear(GL_COLOR_BUFFER_BIT);
+    ssaoShader->bind();
+    bindGBuffer(ssaoShader, gBuffer, true, true);
+    noiseTexture->bind(ssaoShader, TextureType::Noise, 2); // 绑定噪声纹理
+    ssaoShader->setUniform2f("noiseScale", lowWidth / 4.0f, lowHeight / 4.0f);   // 噪声按低分辨率像素平铺
+    ssaoShader->setUniform2i("gBufferSize", renderWidth, renderHeight);
+    if (temporal) {
+        // 第 i 个采样取内核中的 offset + i * stride，stride 帧后遍历完整内核；噪声每帧再按黄金角旋转
+        int stride = get_temporalFrameCount();
+        ssaoShader->setUniform1i("kernelSize", temporalSampleCount);
+        ssaoShader->setUniform1i("kernelOffset", static_cast<int>(frameIndex % static_cast<unsigned int>(stride)));
+        ssaoShader->setUniform1i("kernelStride", stride);
+        ssaoShader->setUniform1f("noiseRotation", static_cast<float>(frameIndex % 1024u) * 2.39996323f);
+    } else {
+        ssaoShader->setUniform1i("kernelSize", kernelSize);
+        ssaoShader->setUniform1i("kernelOffset", 0);
+        ssaoShader->setUniform1i("kernelStride", 1);
+        ssaoShader->setUniform1f("noiseRotation", 0.0f);
+    }
+    ssaoShader->setUniform1f("ssaoStrengh", strength); // 设置 SSAO 强度
+    screen.draw();
+    const Framebuffer* source = aoFramebuffers[0];
+
+    // 时域累积：本帧结果与重投影的历史混合，写入另一份历史
+    if (temporal) {
+        Framebuffer& history = *historyFramebuffers[historyIndex];
+        Framebuffer& previous = *historyFramebuffers[1 - historyIndex];
+        Shader* temporalShader = get_temporal_shader();
+        temporalShader->bind();
+        bindGBuffer(temporalShader, gBuffer, true, false);
+        bindAO(temporalShader, *source);
+        glActiveTexture(GL_TEXTURE4);
+        gl::bindTexture(GL_TEXTURE_2D, previous.get_texture(0));
+        temporalShader->setUniform1i("historyTexture", 4);
+        temporalShader->setUniform1i("historyValid", historyValid ? 1 : 0);
+        glm::mat4 previousViewProjection = gBuffer.previousViewProjection;
+        temporalShader->setUniform4fv("previousViewProjection", previousViewProjection);
+        temporalShader->setUniform3f("previousViewPos", gBuffer.previousViewPosition.x, gBuffer.previousViewPosition.y, gBuffer.previousViewPosition.z);
+        temporalShader->setUniform1f("maxHistory", static_cast<float>(std::max(get_temporalFrameCount(), 4)));
+        temporalShader->setUniform2i("aoSize", lowWidth, lowHeight);
+        temporalShader->setUniform2i("gBufferSize", renderWidth, renderHeight);
+        bindTarget(history);
+        screen.draw();
+        source = &history;
+        historyIndex = 1 - historyIndex;
+        historyValid = true;
+    } else {
+        historyValid = false;
+    }
+
+    // 可分离模糊：先水平（source -> 1），再竖直（1 -> 0 或 target）
+    if (blurEnabled) {
+        Shader* blurShader = get_blur_shader();
+        blurShader->bind();
+        bindGBuffer(blurShader, gBuffer, false, true);
+        blurShader->setUniform2i("aoSize", lowWidth, lowHeight);
+        blurShader->setUniform2i("gBufferSize", renderWidth, renderHeight);
+
+        bindTarget(*aoFramebuffers[1]);
+        bindAO(blurShader, *source);
+        blurShader->setUniform2i("direction", 1, 0);
+        screen.draw();
+
+        bindTarget(resolve ? *aoFramebuffers[0] : target);
+        bindAO(blurShader, *aoFramebuffers[1]);
+        blurShader->setUniform2i("direction", 0, 1);
+        screen.draw();
+        source = aoFramebuffers[0];
+    }
+
+    // 双边上采样到全分辨率
+    if (resolve) {
+        Shader* upsampleShader = get_upsample_shader();
+        upsampleShader->bind();
+        bindGBuffer(upsampleShader, gBuffer, true, false);
+        bindAO(upsampleShader, *source);
+        upsampleShader->setUniform1i("resolutionDivisor", resolutionDivisor);
+        upsampleShader->setUniform2i("aoSize", lowWidth, lowHeight);
+        bindTarget(target);
+        screen.draw();
+    }
+
+    pool.release(aoFramebuffers[0]);
+    pool.release(aoFramebuffers[1]);
+    target.unbind();
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
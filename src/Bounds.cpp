@@ -0,0 +1,114 @@
+#include "Bounds.h"
+#include <cmath>
+#include <utility>
+
+AABB AABB::transformed(const glm::mat4& matrix) const
+{
+    if (!is_valid()) return AABB();
+
+    // Arvo 方法：按矩阵每个元素的正负分别累加到新的最小/最大值，避免变换 8 个角点
+    glm::vec3 translation = glm::vec3(matrix[3]);
+    AABB result;
+    result.min = translation;
+    result.max = translation;
+    for (int col = 0; col < 3; ++col) {
+        for (int row = 0; row < 3; ++row) {
+            float a = matrix[col][row] * min[col];
+            float b = matrix[col][row] * max[col];
+            result.min[row] += std::fmin(a, b);
+            result.max[row] += std::fmax(a, b);
+        }
+    }
+    return result;
+}
+
+bool intersectRayAABB(const glm::vec3& origin, const glm::vec3& invDirection, const AABB& box, float maxDistance, float& tEnter)
+{
+    if (!box.is_valid()) return false;
+    float tMin = 0.0f;
+    float tMax = maxDistance;
+    for (int axis = 0; axis < 3; ++axis) {
+        float t0 = (box.min[axis] - origin[axis]) * invDirection[axis];
+        float t1 = (box.max[axis] - origin[axis]) * invDirection[axis];
+        if (t0 > t1) std::swap(t0, t1);
+        tMin = t0 > tMin ? t0 : tMin;
+        tMax = t1 < tMax ? t1 : tMax;
+        if (tMin > tMax) return false;
+    }
+    tEnter = tMin;
+    return true;
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+    // Gribb-Hartmann：平面由矩阵的行组合得到（glm 为列主序，m[col][row]）
+    glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+    glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+    glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+    glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+    planes[Left] = row3 + row0;
+    planes[Right] = row3 - row0;
+    planes[Bottom] = row3 + row1;
+    planes[Top] = row3 - row1;
+    planes[Near] = row3 + row2;
+    planes[Far] = row3 - row2;
+
+    for (auto& plane : planes) {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f) plane /= length;
+    }
+}
+
+Frustum Frustum::from_box(const glm::vec3& center, const glm::vec3& halfExtent)
+{
+    Frustum frustum;
+    glm::vec3 lo = center - halfExtent;
+    glm::vec3 hi = center + halfExtent;
+    frustum.planes[Left] = glm::vec4(1.0f, 0.0f, 0.0f, -lo.x);
+    frustum.planes[Right] = glm::vec4(-1.0f, 0.0f, 0.0f, hi.x);
+    frustum.planes[Bottom] = glm::vec4(0.0f, 1.0f, 0.0f, -lo.y);
+    frustum.planes[Top] = glm::vec4(0.0f, -1.0f, 0.0f, hi.y);
+    frustum.planes[Near] = glm::vec4(0.0f, 0.0f, 1.0f, -lo.z);
+    frustum.planes[Far] = glm::vec4(0.0f, 0.0f, -1.0f, hi.z);
+    return frustum;
+}
+
+bool Frustum::intersects(const BoundingSphere& sphere) const
+{
+    if (!sphere.is_valid()) return true;
+    for (const auto& plane : planes) {
+        if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) return false;
+    }
+    return true;
+}
+
+bool Frustum::intersects(const AABB& box) const
+{
+    if (!box.is_valid()) return true;
+    glm::vec3 center = box.center();
+    glm::vec3 extent = box.extent();
+    for (const auto& plane : planes) {
+        glm::vec3 normal(plane);
+        // 盒子在平面法线方向上的投影半径
+        float radius = glm::dot(extent, glm::abs(normal));
+        if (glm::dot(normal, center) + plane.w < -radius) return false;
+    }
+    return true;
+}
+
+Frustum::Containment Frustum::classify(const AABB& box) const
+{
+    if (!box.is_valid()) return Containment::Intersects;
+    glm::vec3 center = box.center();
+    glm::vec3 extent = box.extent();
+    Containment result = Containment::Inside;
+    for (const auto& plane : planes) {
+        glm::vec3 normal(plane);
+        float radius = glm::dot(extent, glm::abs(normal));
+        float distance = glm::dot(normal, center) + plane.w;
+        if (distance < -radius) return Containment::Outside;
+        if (distance < radius) result = Containment::Intersects;
+    }
+    return result;
+}
@@ -1,4 +1,5 @@
 #include "BufferObject.h"
+#include "GLStats.h"
 
 //----------------------------
 VertexBuffer::~VertexBuffer()
@@ -19,12 +20,12 @@ void VertexBuffer::unbind()
 IndexBuffer::IndexBuffer(const std::vector<unsigned int>& data)
 {
     // 创建索引缓冲对象(Index Buffer Object，IBO)
-    _ASSERT(sizeof(unsigned int) == sizeof(GLuint));
+    static_assert(sizeof(unsigned int) == sizeof(GLuint), "GLuint must be unsigned int");
     size_t size = data.size() * sizeof(unsigned int);
     m_Count = data.size();
     glGenBuffers(1, &m_RendererID);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data.data(), GL_STATIC_DRAW);
+    gl::bufferData(GL_ELEMENT_ARRAY_BUFFER, size, data.data(), GL_STATIC_DRAW);
 }
 
 IndexBuffer::~IndexBuffer()
@@ -91,10 +92,44 @@ void VertexArrayObject::bindAll()
 
 void VertexArrayObject::bind()
 {
-    glBindVertexArray(m_RendererID);
+    gl::bindVertexArray(m_RendererID);
 }
 
 void VertexArrayObject::unbind()
 {
-    glBindVertexArray(0);
+    gl::bindVertexArray(0);
+}
+
+//-------------------------------------------------
+
+IndirectBuffer::IndirectBuffer()
+{
+    glGenBuffers(1, &buffer);
+}
+
+IndirectBuffer::~IndirectBuffer()
+{
+    glDeleteBuffers(1, &buffer);
+}
+
+void IndirectBuffer::updateData(const std::vector<DrawElementsIndirectCommand>& commands)
+{
+    size_t size = commands.size() * sizeof(DrawElementsIndirectCommand);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+    if (commands.size() > capacity) {
+        capacity = std::max(commands.size(), capacity * 2);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, capacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+    }
+    gl::bufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, commands.data());
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void IndirectBuffer::bind() const
+{
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+}
+
+void IndirectBuffer::unbind() const
+{
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
 }
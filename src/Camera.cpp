@@ -26,6 +26,13 @@ Camera::Camera() :
     cameraRight = glm::cross(direction, cameraRight);
     updateViewMatrix();
     updateProjectionMatrix();
+    endFrame();
+}
+
+void Camera::endFrame()
+{
+    previousViewProjectionMatrix = viewProjectionMatrix;
+    previousPos = pos;
 }
 
 Camera::~Camera()
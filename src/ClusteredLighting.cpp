@@ -0,0 +1,60 @@
+#include "ClusteredLighting.h"
+#include "Camera.h"
+#include "Light.h"
+#include "Shader.h"
+#include "GLStats.h"
+#include "CpuProfiler.h"
+
+Shader* ClusteredLighting::get_cull_shader()
+{
+    static Shader* cullShader = nullptr;
+    if (!cullShader)
+    {
+        cullShader = new Shader("res/shader/Light_cluster.shader");
+    }
+    return cullShader;
+}
+
+void ClusteredLighting::cull(const Camera& camera, Light& light)
+{
+    CPU_PROFILE_SCOPE("ClusteredLighting::cull");
+    viewMatrix = camera.getViewMatrix();
+    nearPlane = camera.getNearPlane();
+    farPlane = camera.getFarPlane();
+    lightCount = light.get_lightCount();
+
+    if (!countSSBO) {
+        countSSBO = std::make_unique<SSBO<GLuint>>(CLUSTER_COUNT_BINDING, get_clusterCount());
+        indexSSBO = std::make_unique<SSBO<GLuint>>(CLUSTER_INDEX_BINDING, get_clusterCount() * MAX_LIGHTS_PER_CLUSTER);
+    }
+    // 场景中可能有多个 Light 共用绑定点 1，以本次分簇的灯光为准
+    light.lightsSSBO->bindBase();
+    countSSBO->bindBase();
+    indexSSBO->bindBase();
+
+    Shader* shader = get_cull_shader();
+    shader->bind();
+    glm::mat4 inverseProjection = glm::inverse(camera.getProjectionMatrix());
+    shader->setUniform4fv("inverseProjection", inverseProjection);
+    shader->setUniform4fv("viewMatrix", viewMatrix);
+    shader->setUniform1f("zNear", nearPlane);
+    shader->setUniform1f("zFar", farPlane);
+    shader->setUniform1i("orthographic", camera.isOrthographic() ? 1 : 0);
+    shader->setUniform1i("lightCount", lightCount);
+
+    GLuint groups = (static_cast<GLuint>(get_clusterCount()) + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+    gl::dispatchCompute(groups, 1, 1);
+    // 光照阶段的片段着色器读取簇数据
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void ClusteredLighting::bind(Shader* shader) const
+{
+    if (!countSSBO) return;
+    countSSBO->bindBase();
+    indexSSBO->bindBase();
+    glm::mat4 view = viewMatrix;
+    shader->setUniform4fv("viewMatrix", view);
+    shader->setUniform1f("zNear", nearPlane);
+    shader->setUniform1f("zFar", farPlane);
+}
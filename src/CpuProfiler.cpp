@@ -0,0 +1,77 @@
+#include "CpuProfiler.h"
+
+#ifdef ENABLE_CPU_PROFILER
+
+#include <fstream>
+#include <iostream>
+
+void CpuProfiler::record(const char* name, uint64_t startNs, uint64_t endNs)
+{
+    ThreadBuffer& buffer = threadBuffer();
+    uint64_t index = buffer.count.load(std::memory_order_relaxed);
+    buffer.events[index % EVENTS_PER_THREAD] = {name, startNs, endNs - startNs};
+    buffer.count.store(index + 1, std::memory_order_release);
+}
+
+void CpuProfiler::set_threadName(const std::string& name)
+{
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer.name = name;
+}
+
+bool CpuProfiler::exportChromeTrace(const std::string& filename) const
+{
+    std::ofstream outFile(filename);
+    if (!outFile.is_open()) {
+        std::cerr << "Failed to write CPU trace: " << filename << std::endl;
+        return false;
+    }
+
+    // 事件数量可能上百万，这里直接流式写出，不经过 nlohmann::json 构建整棵树
+    std::lock_guard<std::mutex> lock(registryMutex);
+    outFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto& buffer : buffers) {
+        if (!first) outFile << ",\n";
+        first = false;
+        outFile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+
+        uint64_t count = buffer->count.load(std::memory_order_acquire);
+        uint64_t begin = count > EVENTS_PER_THREAD ? count - EVENTS_PER_THREAD : 0;
+        for (uint64_t i = begin; i < count; ++i) {
+            const Event& event = buffer->events[i % EVENTS_PER_THREAD];
+            outFile << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                    << ",\"ts\":" << event.startNs / 1000.0 << ",\"dur\":" << event.durationNs / 1000.0 << "}";
+        }
+    }
+    outFile << "\n]}\n";
+    return true;
+}
+
+void CpuProfiler::clear()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (auto& buffer : buffers) {
+        buffer->count.store(0, std::memory_order_release);
+    }
+}
+
+CpuProfiler::ThreadBuffer& CpuProfiler::threadBuffer()
+{
+    thread_local ThreadBuffer* cached = nullptr;
+    if (cached) return *cached;
+
+    // 每个线程只在第一次记录时加锁注册一次
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->events = std::make_unique<Event[]>(EVENTS_PER_THREAD);
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer->threadId = static_cast<uint32_t>(buffers.size() + 1);
+    buffer->name = "Thread " + std::to_string(buffer->threadId);
+    cached = buffer.get();
+    buffers.push_back(std::move(buffer));
+    return *cached;
+}
+
+#endif
@@ -0,0 +1,50 @@
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cmath>
+
+void DynamicResolution::set_minScale(float minScale)
+{
+    this->minScale = std::clamp(minScale, SCALE_STEP, 1.0f);
+    maxScale = std::max(maxScale, this->minScale);
+    scale = std::clamp(scale, this->minScale, maxScale);
+}
+
+void DynamicResolution::set_maxScale(float maxScale)
+{
+    this->maxScale = std::clamp(maxScale, SCALE_STEP, 1.0f);
+    minScale = std::min(minScale, this->maxScale);
+    scale = std::clamp(scale, minScale, this->maxScale);
+}
+
+void DynamicResolution::reset()
+{
+    scale = maxScale;
+    samples.clear();
+    settleFrame = 0;
+    averageFrameMs = 0.0;
+}
+
+bool DynamicResolution::addSample(unsigned long long frame, double gpuMs, unsigned long long nextFrame)
+{
+    if (frame < settleFrame) return false;
+    samples.push_back(gpuMs);
+    while (samples.size() > static_cast<size_t>(historyLength)) samples.pop_front();
+    if (samples.size() < static_cast<size_t>(historyLength)) return false;
+
+    double sum = 0.0;
+    for (double sample : samples) sum += sample;
+    averageFrameMs = sum / samples.size();
+    if (averageFrameMs <= targetFrameMs && averageFrameMs >= targetFrameMs * headroom) return false;
+
+    // 耗时与像素数（比例的平方）成正比，目标取预算与放大阈值的中间
+    double goal = targetFrameMs * (1.0 + headroom) * 0.5;
+    float desired = scale * static_cast<float>(std::sqrt(goal / std::max(averageFrameMs, 1e-3)));
+    desired = std::round(desired / SCALE_STEP) * SCALE_STEP;
+    desired = std::clamp(desired, minScale, maxScale);
+    if (std::abs(desired - scale) < SCALE_STEP * 0.5f) return false;
+
+    scale = desired;
+    samples.clear();
+    settleFrame = nextFrame;
+    return true;
+}
@@ -0,0 +1,186 @@
+#include "FramebufferPool.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    // 每像素字节数，未列出的格式按 4 字节估算
+    size_t bytesPerPixel(GLenum internalFormat)
+    {
+        switch (internalFormat) {
+        case GL_RGBA32F: return 16;
+        case GL_RGBA16F: return 8;
+        case GL_RGB16F: return 6;
+        case GL_RG16F:
+        case GL_RG16:
+        case GL_R32F:
+        case GL_RGBA8:
+        case GL_SRGB8_ALPHA8:
+        case GL_DEPTH24_STENCIL8:
+        case GL_DEPTH_COMPONENT24: return 4;
+        case GL_R16F: return 2;
+        case GL_RED:
+        case GL_R8: return 1;
+        default: return 4;
+        }
+    }
+
+    bool isDepthFormat(GLenum format)
+    {
+        return format == GL_DEPTH_COMPONENT || format == GL_DEPTH_STENCIL;
+    }
+}
+
+bool FramebufferPool::TextureKey::operator==(const TextureKey& other) const
+{
+    return width == other.width && height == other.height &&
+           config.internalFormat == other.config.internalFormat &&
+           config.format == other.config.format &&
+           config.type == other.config.type;
+}
+
+FramebufferPool::~FramebufferPool()
+{
+    framebuffers.clear();
+    for (const auto& entry : textures) glDeleteTextures(1, &entry.texture);
+}
+
+FramebufferPool::TextureKey FramebufferPool::depthKey(const Desc& desc)
+{
+    // 与 Framebuffer 自己分配的深度格式相同
+    TextureKey key;
+    key.width = desc.width;
+    key.height = desc.height;
+    if (desc.useStencil) {
+        key.config = {GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8};
+    } else {
+        key.config = {GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT};
+    }
+    return key;
+}
+
+GLuint FramebufferPool::acquireTexture(const TextureKey& key)
+{
+    for (auto& entry : textures) {
+        if (!entry.inUse && entry.key == key) {
+            entry.inUse = true;
+            entry.lastUsedFrame = frame;
+            return entry.texture;
+        }
+    }
+    CPU_PROFILE_SCOPE("FramebufferPool::allocate");
+    TextureEntry entry;
+    entry.key = key;
+    glGenTextures(1, &entry.texture);
+    glBindTexture(GL_TEXTURE_2D, entry.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, key.config.internalFormat, key.width, key.height, 0, key.config.format, key.config.type, nullptr);
+    if (isDepthFormat(key.config.format)) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    } else {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    entry.inUse = true;
+    entry.lastUsedFrame = frame;
+    allocationCount++;
+    textures.push_back(entry);
+    return entry.texture;
+}
+
+void FramebufferPool::releaseTexture(GLuint texture)
+{
+    for (auto& entry : textures) {
+        if (entry.texture == texture) {
+            entry.inUse = false;
+            return;
+        }
+    }
+}
+
+Framebuffer* FramebufferPool::acquire(const Desc& desc)
+{
+    // 先按附件逐张取纹理，同一描述中格式相同的附件各取一张
+    std::vector<GLuint> attachments;
+    for (const auto& config : desc.attachments) {
+        attachments.push_back(acquireTexture({config, desc.width, desc.height}));
+    }
+    GLuint depth = desc.useDepth ? acquireTexture(depthKey(desc)) : 0;
+    attachments.push_back(depth);
+
+    for (auto& entry : framebuffers) {
+        if (!entry.inUse && entry.attachments == attachments) {
+            entry.inUse = true;
+            return entry.framebuffer.get();
+        }
+    }
+    FramebufferEntry entry;
+    entry.attachments = attachments;
+    entry.framebuffer = std::make_unique<Framebuffer>(desc.width, desc.height,
+                                                      std::vector<GLuint>(attachments.begin(), attachments.end() - 1), depth, desc.useStencil);
+    entry.inUse = true;
+    framebuffers.push_back(std::move(entry));
+    return framebuffers.back().framebuffer.get();
+}
+
+void FramebufferPool::release(Framebuffer* framebuffer)
+{
+    for (auto& entry : framebuffers) {
+        if (entry.framebuffer.get() == framebuffer) {
+            entry.inUse = false;
+            for (GLuint texture : entry.attachments) {
+                if (texture) releaseTexture(texture);
+            }
+            return;
+        }
+    }
+    std::cerr << "FramebufferPool: released a framebuffer not owned by the pool" << std::endl;
+}
+
+template <typename Predicate>
+void FramebufferPool::eraseTextures(Predicate predicate)
+{
+    std::vector<GLuint> erased;
+    for (const auto& entry : textures) {
+        if (!entry.inUse && predicate(entry)) erased.push_back(entry.texture);
+    }
+    if (erased.empty()) return;
+    // 引用被删除纹理的帧缓冲一定没有被持有
+    framebuffers.erase(std::remove_if(framebuffers.begin(), framebuffers.end(), [&erased](const FramebufferEntry& entry) {
+        return std::any_of(entry.attachments.begin(), entry.attachments.end(), [&erased](GLuint texture) {
+            return texture && std::find(erased.begin(), erased.end(), texture) != erased.end();
+        });
+    }), framebuffers.end());
+    textures.erase(std::remove_if(textures.begin(), textures.end(), [&erased](const TextureEntry& entry) {
+        return std::find(erased.begin(), erased.end(), entry.texture) != erased.end();
+    }), textures.end());
+    glDeleteTextures(erased.size(), erased.data());
+}
+
+void FramebufferPool::endFrame()
+{
+    frame++;
+    eraseTextures([this](const TextureEntry& entry) { return frame - entry.lastUsedFrame > MAX_IDLE_FRAMES; });
+}
+
+void FramebufferPool::trim()
+{
+    eraseTextures([](const TextureEntry&) { return true; });
+    framebuffers.erase(std::remove_if(framebuffers.begin(), framebuffers.end(), [](const FramebufferEntry& entry) { return !entry.inUse; }), framebuffers.end());
+}
+
+int FramebufferPool::get_inUseCount() const
+{
+    return static_cast<int>(std::count_if(framebuffers.begin(), framebuffers.end(), [](const FramebufferEntry& entry) { return entry.inUse; }));
+}
+
+size_t FramebufferPool::get_allocatedBytes() const
+{
+    size_t bytes = 0;
+    for (const auto& entry : textures) {
+        bytes += bytesPerPixel(entry.key.config.internalFormat) * static_cast<size_t>(entry.key.width) * static_cast<size_t>(entry.key.height);
+    }
+    return bytes;
+}
@@ -0,0 +1,65 @@
+#include "GLStats.h"
+#include <glad/glad.h>
+#include <iostream>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+void checkGLError(const char* file, int line) {
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        std::cerr << "OpenGL error at " << file << ":" << line << " - " << error << std::endl;
+    }
+}
+
+const char* GLStats::get_counterName(Counter counter)
+{
+    switch (counter) {
+        case DrawCalls:         return "draw_calls";
+        case Triangles:         return "triangles";
+        case ProgramBinds:      return "program_binds";
+        case VertexArrayBinds:  return "vao_binds";
+        case TextureBinds:      return "texture_binds";
+        case UniformUploads:    return "uniform_uploads";
+        case BufferUploads:     return "buffer_uploads";
+        case BufferUploadBytes: return "buffer_upload_bytes";
+        case FramebufferBinds:  return "fbo_binds";
+        case Blits:             return "blits";
+        case Copies:            return "copies";
+        case ComputeDispatches: return "compute_dispatches";
+        default:                return "unknown";
+    }
+}
+
+void GLStats::beginFrame()
+{
+    current = FrameCounters();
+    current.frame = frameCounter;
+}
+
+void GLStats::endFrame()
+{
+    lastFrame = current;
+    if (recording) {
+        recordedFrames.push_back(current);
+    }
+    frameCounter++;
+}
+
+bool GLStats::exportJson(const std::string& filename) const
+{
+    nlohmann::json j;
+    j["frames"] = nlohmann::json::array();
+    for (const auto& frame : recordedFrames) {
+        nlohmann::json frameJson;
+        frameJson["frame"] = frame.frame;
+        for (int i = 0; i < COUNTER_COUNT; ++i) {
+            frameJson[get_counterName(static_cast<Counter>(i))] = frame.values[i];
+        }
+        j["frames"].push_back(frameJson);
+    }
+
+    std::ofstream outFile(filename);
+    if (!outFile.is_open()) return false;
+    outFile << j.dump(4);
+    return true;
+}
@@ -0,0 +1,97 @@
+#include "GeometryPool.h"
+#include "Mesh.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+
+GeometryPool::~GeometryPool()
+{
+    // 池先于网格销毁时（程序退出），让网格析构时不再回调
+    for (Mesh* mesh : meshes) {
+        mesh->set_geometryPool(nullptr);
+    }
+}
+
+void GeometryPool::acquire(Mesh* mesh)
+{
+    if (ranges.find(mesh) != ranges.end()) return;
+    ranges.emplace(mesh, Range());
+    meshes.push_back(mesh);
+    mesh->set_geometryPool(this);
+    dirty = true;
+}
+
+void GeometryPool::release(Mesh* mesh)
+{
+    auto it = ranges.find(mesh);
+    if (it == ranges.end()) return;
+    ranges.erase(it);
+    meshes.erase(std::find(meshes.begin(), meshes.end(), mesh));
+    dirty = true;
+}
+
+void GeometryPool::sync()
+{
+    if (!dirty) return;
+    CPU_PROFILE_SCOPE("GeometryPool::sync");
+    dirty = false;
+    rebuildCount++;
+
+    std::vector<Vertexdata> vertices;
+    std::vector<unsigned int> indices;
+    for (Mesh* mesh : meshes) {
+        Range& range = ranges[mesh];
+        range.firstIndex = static_cast<unsigned int>(indices.size());
+        range.indexCount = static_cast<unsigned int>(mesh->get_indices().size());
+        range.baseVertex = static_cast<int>(vertices.size());
+        vertices.insert(vertices.end(), mesh->get_vertices().begin(), mesh->get_vertices().end());
+        indices.insert(indices.end(), mesh->get_indices().begin(), mesh->get_indices().end());
+    }
+    vertexCount = vertices.size();
+    indexCount = indices.size();
+
+    VAO.reset();
+    positionVAO.reset();
+    if (meshes.empty()) return;
+    // 顶点布局与 Mesh::set_mesh 相同，着色器无需区分
+    VAO = std::make_unique<VertexArrayObject>();
+    VAO->addVertexBuffer(vertices);
+    VAO->addIndexBuffer(indices);
+    VAO->push<float>(3); // 位置
+    VAO->push<float>(3); // 法线
+    VAO->push<float>(2); // 纹理坐标
+    VAO->push<float>(3); // 切线
+    VAO->push<float>(1); // 切线方向标志位
+    VAO->bindAll();
+
+    // 位置流：顶点顺序与上面一致，网格的范围可以直接复用
+    std::vector<glm::vec3> positions;
+    positions.reserve(vertices.size());
+    for (const auto& vertex : vertices) {
+        positions.push_back(vertex.Position);
+    }
+    positionVAO = std::make_unique<VertexArrayObject>();
+    positionVAO->addVertexBuffer(positions);
+    positionVAO->addIndexBuffer(indices);
+    positionVAO->push<float>(3); // 位置
+    positionVAO->bindAll();
+}
+
+void GeometryPool::bind()
+{
+    if (VAO) VAO->bind();
+}
+
+void GeometryPool::unbind()
+{
+    if (VAO) VAO->unbind();
+}
+
+void GeometryPool::bindPositions()
+{
+    if (positionVAO) positionVAO->bind();
+}
+
+void GeometryPool::unbindPositions()
+{
+    if (positionVAO) positionVAO->unbind();
+}
@@ -0,0 +1,210 @@
+#include "GpuCulling.h"
+#include "Renderer.h"
+#include "Model.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "GeometryPool.h"
+#include "HiZBuffer.h"
+#include "GLStats.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+    // 首次使用时创建，之后容量不足按两倍扩容
+    template <typename T>
+    void ensureCapacity(std::unique_ptr<SSBO<T>>& ssbo, GLuint bindingPoint, size_t count)
+    {
+        if (!ssbo) {
+            ssbo = std::make_unique<SSBO<T>>(bindingPoint, static_cast<unsigned int>(std::max<size_t>(count, 64)));
+            return;
+        }
+        ssbo->reserve(count);
+    }
+}
+
+Shader* GpuCulling::get_cull_shader()
+{
+    static Shader* cullShader = nullptr;
+    if (!cullShader)
+    {
+        cullShader = new Shader("res/shader/Cull_frustum.shader");
+    }
+    return cullShader;
+}
+
+void GpuCulling::update(const std::vector<std::shared_ptr<Model>>& models, bool depthOnly)
+{
+    CPU_PROFILE_SCOPE("GpuCulling::update");
+    GeometryPool& pool = GeometryPool::getInstance();
+    // 网格重新设置几何时会在池中重新登记，先同步再比较重建次数
+    pool.sync();
+
+    unsigned int currentSceneVersion = Renderer::getInstance().get_sceneVersion();
+    if (&models != modelList || models.size() != modelCount || depthOnly != builtDepthOnly ||
+        currentSceneVersion != sceneVersion || pool.get_rebuildCount() != poolRebuildCount) {
+        rebuild(models, depthOnly);
+        modelList = &models;
+        modelCount = models.size();
+        builtDepthOnly = depthOnly;
+        sceneVersion = currentSceneVersion;
+        poolRebuildCount = pool.get_rebuildCount();
+        meshVersion = Mesh::get_changeVersion();
+        return;
+    }
+    if (Mesh::get_changeVersion() != meshVersion) {
+        refreshObjects();
+        meshVersion = Mesh::get_changeVersion();
+    }
+}
+
+void GpuCulling::rebuild(const std::vector<std::shared_ptr<Model>>& models, bool depthOnly)
+{
+    CPU_PROFILE_SCOPE("GpuCulling::rebuild");
+    rebuildCount++;
+    GeometryPool& pool = GeometryPool::getInstance();
+
+    // 按材质（图像组合）分组，同组网格的命令放在一段连续区域内，一次多重绘制提交
+    std::vector<std::vector<Mesh*>> groups;
+    std::vector<Texture*> groupTextures;
+    std::unordered_map<size_t, int> groupIndices;
+    for (const auto& model : models) {
+        for (Mesh* mesh : model->get_meshes()) {
+            pool.acquire(mesh);
+            Texture* texture = depthOnly ? nullptr : mesh->get_texture();
+            size_t key = texture ? texture->get_imageHash() + 1 : 0;
+            auto it = groupIndices.find(key);
+            if (it == groupIndices.end()) {
+                it = groupIndices.emplace(key, static_cast<int>(groups.size())).first;
+                groups.emplace_back();
+                groupTextures.push_back(texture);
+            }
+            groups[it->second].push_back(mesh);
+        }
+    }
+    pool.sync();
+
+    meshes.clear();
+    objects.clear();
+    batches.clear();
+    for (size_t g = 0; g < groups.size(); ++g) {
+        Batch batch = {groupTextures[g], static_cast<int>(meshes.size()), static_cast<int>(groups[g].size())};
+        // 材质槽与 RenderQueue 一致，0 表示不绑定材质
+        GLuint materialSlot = groupTextures[g] ? static_cast<GLuint>(g) + 1 : 0;
+        for (Mesh* mesh : groups[g]) {
+            const GeometryPool::Range& range = pool.get_range(mesh);
+            CullObject object;
+            object.draw = glm::uvec4(range.indexCount, range.firstIndex, static_cast<GLuint>(range.baseVertex), materialSlot);
+            object.batch = glm::uvec4(static_cast<GLuint>(batches.size()), static_cast<GLuint>(batch.first), 0, 0);
+            meshes.push_back(mesh);
+            objects.push_back(object);
+        }
+        batches.push_back(batch);
+    }
+    refreshObjects();
+
+    // 命令缓冲和逐绘制数据按最坏情况（全部可见）分配，两个遮挡阶段各占一段
+    ensureCapacity(commandSSBO, COMMAND_BINDING, objects.size() * 2);
+    ensureCapacity(drawDataSSBO, DRAW_DATA_BINDING, objects.size() * 2);
+    ensureCapacity(countSSBO, COUNT_BINDING, batches.size() * 2);
+    // 新建的对象视为上一帧可见，第一帧的第一阶段画出全部网格
+    if (!objects.empty()) {
+        ensureCapacity(visibilitySSBO, VISIBILITY_BINDING, objects.size());
+        visibilitySSBO->updateData(std::vector<GLuint>(objects.size(), 1u));
+    }
+}
+
+void GpuCulling::refreshObjects()
+{
+    for (size_t i = 0; i < objects.size(); ++i) {
+        Mesh* mesh = meshes[i];
+        const BoundingSphere& sphere = mesh->get_worldSphere();
+        objects[i].modelMatrix = mesh->getModelMatrix();
+        objects[i].sphere = glm::vec4(sphere.center, sphere.radius);
+        objects[i].batch.z = mesh->get_visibility() ? 1u : 0u;
+    }
+    if (objects.empty()) return;
+    ensureCapacity(objectSSBO, OBJECT_BINDING, objects.size());
+    objectSSBO->updateData(objects);
+}
+
+void GpuCulling::cull(const Frustum* frustum, Phase phase, const HiZBuffer* hiZ)
+{
+    CPU_PROFILE_SCOPE("GpuCulling::cull");
+    if (objects.empty()) return;
+    if (phase == Phase::Occlusion && !hiZ) phase = Phase::Single;
+    int region = regionOf(phase);
+
+    // 每帧从零开始计数，只清本阶段的区域
+    countSSBO->bind();
+    glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, region * batches.size() * sizeof(GLuint), batches.size() * sizeof(GLuint),
+                         GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    countSSBO->unbind();
+
+    objectSSBO->bindBase();
+    commandSSBO->bindBase();
+    countSSBO->bindBase();
+    drawDataSSBO->bindBase();
+    visibilitySSBO->bindBase();
+
+    Shader* shader = get_cull_shader();
+    shader->bind();
+    shader->setUniform1i("objectCount", static_cast<int>(objects.size()));
+    shader->setUniform1i("cullingEnabled", Renderer::getInstance().is_frustumCullingEnabled() ? 1 : 0);
+    shader->setUniform1i("useCameraFrustum", frustum ? 0 : 1);
+    if (frustum) {
+        shader->setUniform4fv("frustumPlanes", Frustum::PLANE_COUNT, &frustum->get_planes()[0].x);
+    }
+    shader->setUniform1i("phase", static_cast<int>(phase));
+    shader->setUniform1i("commandBase", region * static_cast<int>(objects.size()));
+    shader->setUniform1i("countBase", region * static_cast<int>(batches.size()));
+    if (phase == Phase::Occlusion) {
+        glActiveTexture(GL_TEXTURE0);
+        gl::bindTexture(GL_TEXTURE_2D, hiZ->get_texture());
+        shader->setUniform1i("hiZ", 0);
+        shader->setUniform2i("hiZSize", hiZ->get_width(), hiZ->get_height());
+        shader->setUniform1i("hiZLevelCount", hiZ->get_levelCount());
+        glm::vec2 hiZUVScale = Renderer::getInstance().get_renderUVScale();
+        shader->setUniform2f("hiZUVScale", hiZUVScale.x, hiZUVScale.y);
+    }
+
+    GLuint groups = (static_cast<GLuint>(objects.size()) + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+    gl::dispatchCompute(groups, 1, 1);
+    // 命令和计数作为间接绘制参数读取，逐绘制数据由顶点着色器读取
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void GpuCulling::draw(Shader* shader, bool depthOnly, Phase phase)
+{
+    CPU_PROFILE_SCOPE("GpuCulling::draw");
+    if (objects.empty()) return;
+    int region = regionOf(phase);
+    int commandBase = region * static_cast<int>(objects.size());
+    size_t countBase = region * batches.size();
+
+    GeometryPool& pool = GeometryPool::getInstance();
+    // 绑定点 2 与实例化绘制、渲染队列的多重绘制共用，绘制前重新绑定
+    drawDataSSBO->bindBase();
+    if (depthOnly) pool.bindPositions(); else pool.bind();
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandSSBO->get_id());
+    glBindBuffer(GL_PARAMETER_BUFFER, countSSBO->get_id());
+
+    shader->bind();
+    shader->setUniform1i("multiDraw", 1);
+    for (size_t i = 0; i < batches.size(); ++i) {
+        const Batch& batch = batches[i];
+        if (!depthOnly && batch.texture) batch.texture->bind(shader);
+        int first = commandBase + batch.first;
+        shader->setUniform1i("drawOffset", first);
+        // 实际绘制数量由计数缓冲中该批次的计数给出，batch.count 只是上限
+        gl::multiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                           (const void*)(first * sizeof(DrawElementsIndirectCommand)),
+                                           static_cast<GLintptr>((countBase + i) * sizeof(GLuint)), batch.count, 0);
+    }
+    shader->setUniform1i("multiDraw", 0);
+
+    glBindBuffer(GL_PARAMETER_BUFFER, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    if (depthOnly) pool.unbindPositions(); else pool.unbind();
+}
@@ -0,0 +1,208 @@
+#include "GpuProfiler.h"
+#include <iostream>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+double GpuProfiler::ZoneHistory::average() const
+{
+    if (samples.empty()) return 0.0;
+    double sum = 0.0;
+    for (float v : samples) sum += v;
+    return sum / samples.size();
+}
+
+void GpuProfiler::shutdown()
+{
+    for (auto& slot : slots) {
+        if (!slot.queryPool.empty()) {
+            glDeleteQueries(slot.queryPool.size(), slot.queryPool.data());
+        }
+        slot = FrameSlot();
+    }
+    zoneStack.clear();
+    openZoneIndex.clear();
+    inFrame = false;
+}
+
+void GpuProfiler::set_enabled(bool enabled)
+{
+    this->enabled = enabled;
+}
+
+void GpuProfiler::beginFrame()
+{
+    if (!enabled) return;
+
+    FrameSlot& slot = slots[frameCounter % FRAMES_IN_FLIGHT];
+    // 该槽位是 FRAMES_IN_FLIGHT 帧之前提交的，通常早已完成；若仍未完成则丢弃这一帧，绝不等待
+    if (slot.pending) {
+        collect(slot, false);
+    }
+
+    slot.usedQueries = 0;
+    slot.zones.clear();
+    slot.frame = frameCounter;
+    slot.frameBegin = acquireQuery(slot);
+    glQueryCounter(slot.frameBegin, GL_TIMESTAMP);
+
+    zoneStack.clear();
+    openZoneIndex.clear();
+    inFrame = true;
+}
+
+void GpuProfiler::endFrame()
+{
+    if (!inFrame) return;
+
+    while (!zoneStack.empty()) {
+        std::cerr << "Warning: GPU zone \"" << zoneStack.back() << "\" was not closed" << std::endl;
+        endZone();
+    }
+
+    FrameSlot& slot = slots[frameCounter % FRAMES_IN_FLIGHT];
+    slot.frameEnd = acquireQuery(slot);
+    glQueryCounter(slot.frameEnd, GL_TIMESTAMP);
+    slot.pending = true;
+
+    frameCounter++;
+    inFrame = false;
+}
+
+void GpuProfiler::beginZone(const char* name)
+{
+    if (!inFrame) return;
+
+    FrameSlot& slot = slots[frameCounter % FRAMES_IN_FLIGHT];
+    std::string path = zoneStack.empty() ? std::string(name) : zoneStack.back() + "/" + name;
+
+    PendingZone zone;
+    zone.path = path;
+    zone.depth = static_cast<int>(zoneStack.size());
+    zone.beginQuery = acquireQuery(slot);
+    zone.endQuery = 0;
+    glQueryCounter(zone.beginQuery, GL_TIMESTAMP);
+
+    openZoneIndex.push_back(slot.zones.size());
+    slot.zones.push_back(zone);
+    zoneStack.push_back(path);
+}
+
+void GpuProfiler::endZone()
+{
+    if (!inFrame || zoneStack.empty()) return;
+
+    FrameSlot& slot = slots[frameCounter % FRAMES_IN_FLIGHT];
+    PendingZone& zone = slot.zones[openZoneIndex.back()];
+    zone.endQuery = acquireQuery(slot);
+    glQueryCounter(zone.endQuery, GL_TIMESTAMP);
+
+    openZoneIndex.pop_back();
+    zoneStack.pop_back();
+}
+
+void GpuProfiler::flush()
+{
+    // 按提交顺序回读，保证历史数据有序
+    unsigned long long first = frameCounter > FRAMES_IN_FLIGHT ? frameCounter - FRAMES_IN_FLIGHT : 0;
+    for (unsigned long long frame = first; frame < frameCounter; ++frame) {
+        FrameSlot& slot = slots[frame % FRAMES_IN_FLIGHT];
+        if (slot.pending && slot.frame == frame) {
+            collect(slot, true);
+        }
+    }
+}
+
+bool GpuProfiler::exportTimeSeries(const std::string& filename) const
+{
+    nlohmann::json j;
+    j["frames"] = nlohmann::json::array();
+    for (const auto& frame : recordedFrames) {
+        nlohmann::json frameJson;
+        frameJson["frame"] = frame.frame;
+        frameJson["total_ms"] = frame.totalMs;
+        nlohmann::json zones = nlohmann::json::object();
+        for (const auto& zone : frame.zones) {
+            zones[zone.path] = zone.ms;
+        }
+        frameJson["zones"] = zones;
+        j["frames"].push_back(frameJson);
+    }
+
+    std::ofstream outFile(filename);
+    if (!outFile.is_open()) return false;
+    outFile << j.dump(4);
+    return true;
+}
+
+const GpuProfiler::ZoneHistory* GpuProfiler::get_zoneHistory(const std::string& path) const
+{
+    auto it = zoneHistories.find(path);
+    return it != zoneHistories.end() ? &it->second : nullptr;
+}
+
+GLuint GpuProfiler::acquireQuery(FrameSlot& slot)
+{
+    if (slot.usedQueries == slot.queryPool.size()) {
+        // 查询池按需增长，之后每帧复用
+        size_t oldSize = slot.queryPool.size();
+        size_t newSize = oldSize == 0 ? 32 : oldSize * 2;
+        slot.queryPool.resize(newSize);
+        glGenQueries(newSize - oldSize, slot.queryPool.data() + oldSize);
+    }
+    return slot.queryPool[slot.usedQueries++];
+}
+
+bool GpuProfiler::collect(FrameSlot& slot, bool wait)
+{
+    slot.pending = false;
+    if (!wait) {
+        GLint available = 0;
+        glGetQueryObjectiv(slot.frameEnd, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return false;
+    }
+
+    auto readTimestamp = [](GLuint query) {
+        GLuint64 value = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &value);
+        return value;
+    };
+
+    FrameResult result;
+    result.frame = slot.frame;
+    result.totalMs = (readTimestamp(slot.frameEnd) - readTimestamp(slot.frameBegin)) / 1.0e6;
+    result.zones.reserve(slot.zones.size());
+    for (const auto& zone : slot.zones) {
+        if (zone.endQuery == 0) continue;
+        GLuint64 begin = readTimestamp(zone.beginQuery);
+        GLuint64 end = readTimestamp(zone.endQuery);
+        result.zones.push_back({zone.path, zone.depth, (end - begin) / 1.0e6});
+    }
+
+    lastFrame = result.frame;
+    lastFrameMs = result.totalMs;
+    hasLastFrame = true;
+    pushHistory(result);
+    if (recording) {
+        recordedFrames.push_back(std::move(result));
+    }
+    return true;
+}
+
+void GpuProfiler::pushHistory(const FrameResult& result)
+{
+    frameHistory.push_back((float)result.totalMs);
+    if (frameHistory.size() > HISTORY_SIZE) frameHistory.pop_front();
+
+    for (const auto& zone : result.zones) {
+        auto it = zoneHistories.find(zone.path);
+        if (it == zoneHistories.end()) {
+            zoneOrder.push_back(zone.path);
+            it = zoneHistories.emplace(zone.path, ZoneHistory()).first;
+            it->second.depth = zone.depth;
+        }
+        ZoneHistory& history = it->second;
+        history.lastMs = zone.ms;
+        history.samples.push_back((float)zone.ms);
+        if (history.samples.size() > HISTORY_SIZE) history.samples.pop_front();
+    }
+}
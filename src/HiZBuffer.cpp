@@ -0,0 +1,81 @@
+#include "HiZBuffer.h"
+#include "Shader.h"
+#include "GLStats.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+
+namespace {
+    const GLuint WORKGROUP_SIZE = 8;
+}
+
+Shader* HiZBuffer::get_build_shader()
+{
+    static Shader* buildShader = nullptr;
+    if (!buildShader)
+    {
+        buildShader = new Shader("res/shader/HiZ_build.shader");
+    }
+    return buildShader;
+}
+
+HiZBuffer::~HiZBuffer()
+{
+    if (texture) glDeleteTextures(1, &texture);
+}
+
+void HiZBuffer::resize(int depthWidth, int depthHeight)
+{
+    if (texture && depthWidth == this->depthWidth && depthHeight == this->depthHeight) return;
+    this->depthWidth = depthWidth;
+    this->depthHeight = depthHeight;
+    width = std::max(1, depthWidth / 2);
+    height = std::max(1, depthHeight / 2);
+    levelCount = 1;
+    for (int size = std::max(width, height); size > 1; size /= 2) levelCount++;
+
+    if (texture) glDeleteTextures(1, &texture);
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, levelCount, GL_R32F, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void HiZBuffer::build(GLuint depthTexture)
+{
+    CPU_PROFILE_SCOPE("HiZBuffer::build");
+    if (!texture || !depthTexture) return;
+
+    Shader* shader = get_build_shader();
+    shader->bind();
+    glActiveTexture(GL_TEXTURE0);
+    gl::bindTexture(GL_TEXTURE_2D, depthTexture);
+    shader->setUniform1i("depthTexture", 0);
+
+    int srcWidth = depthWidth;
+    int srcHeight = depthHeight;
+    int dstWidth = width;
+    int dstHeight = height;
+    for (int level = 0; level < levelCount; ++level) {
+        shader->setUniform1i("fromDepth", level == 0 ? 1 : 0);
+        if (level > 0) {
+            glBindImageTexture(0, texture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+        }
+        glBindImageTexture(1, texture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        shader->setUniform2i("srcSize", srcWidth, srcHeight);
+        shader->setUniform2i("dstSize", dstWidth, dstHeight);
+        gl::dispatchCompute((dstWidth + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, (dstHeight + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1);
+        // 下一级读取本级的结果
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        srcWidth = dstWidth;
+        srcHeight = dstHeight;
+        dstWidth = std::max(1, dstWidth / 2);
+        dstHeight = std::max(1, dstHeight / 2);
+    }
+    // 之后由剔除着色器采样
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
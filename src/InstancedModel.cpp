@@ -0,0 +1,166 @@
+#include "InstancedModel.h"
+#include "Model.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+
+unsigned long long InstancedModel::s_ChangeVersion = 0;
+
+namespace {
+    // 首次使用时创建，之后容量不足按两倍扩容，避免逐个增加实例时反复重新分配
+    template <typename T>
+    void ensureCapacity(std::unique_ptr<SSBO<T>>& ssbo, GLuint bindingPoint, size_t count)
+    {
+        if (!ssbo) {
+            ssbo = std::make_unique<SSBO<T>>(bindingPoint, static_cast<unsigned int>(std::max<size_t>(count, 64)));
+            return;
+        }
+        ssbo->reserve(count);
+    }
+}
+
+InstancedModel::InstancedModel(std::shared_ptr<Model> prototype) : prototype(prototype)
+{
+    for (Mesh* mesh : prototype->get_meshes()) {
+        localBounds.expand(mesh->get_localBounds());
+    }
+    materials.push_back(InstanceMaterial());
+}
+
+int InstancedModel::add_instance(const glm::mat4& modelMatrix, unsigned int materialIndex)
+{
+    instances.push_back({modelMatrix, glm::uvec4(materialIndex, 0, 0, 0)});
+    instanceBounds.push_back(localBounds.transformed(modelMatrix));
+    instancesDirty = true;
+    boundsDirty = true;
+    version = ++s_ChangeVersion;
+    return static_cast<int>(instances.size()) - 1;
+}
+
+int InstancedModel::add_instance(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale, unsigned int materialIndex)
+{
+    // 与 Mesh::updateModelMatrix 相同的 TRS 顺序
+    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), position)
+                          * glm::toMat4(glm::quat(glm::radians(rotation)))
+                          * glm::scale(glm::mat4(1.0f), scale);
+    return add_instance(modelMatrix, materialIndex);
+}
+
+void InstancedModel::set_instanceTransform(int index, const glm::mat4& modelMatrix)
+{
+    instances[index].modelMatrix = modelMatrix;
+    instanceBounds[index] = localBounds.transformed(modelMatrix);
+    instancesDirty = true;
+    boundsDirty = true;
+    version = ++s_ChangeVersion;
+}
+
+void InstancedModel::set_instanceMaterial(int index, unsigned int materialIndex)
+{
+    instances[index].material.x = materialIndex;
+    instancesDirty = true;
+}
+
+void InstancedModel::remove_instance(int index)
+{
+    instances[index] = instances.back();
+    instances.pop_back();
+    instanceBounds[index] = instanceBounds.back();
+    instanceBounds.pop_back();
+    instancesDirty = true;
+    boundsDirty = true;
+    version = ++s_ChangeVersion;
+}
+
+void InstancedModel::clear_instances()
+{
+    instances.clear();
+    instanceBounds.clear();
+    instancesDirty = true;
+    boundsDirty = true;
+    version = ++s_ChangeVersion;
+}
+
+unsigned int InstancedModel::add_material(const InstanceMaterial& material)
+{
+    materials.push_back(material);
+    materialsDirty = true;
+    return static_cast<unsigned int>(materials.size()) - 1;
+}
+
+void InstancedModel::set_material(unsigned int index, const InstanceMaterial& material)
+{
+    materials[index] = material;
+    materialsDirty = true;
+}
+
+void InstancedModel::updateBounds()
+{
+    if (!boundsDirty) return;
+    worldBounds = AABB();
+    for (const auto& bounds : instanceBounds) {
+        worldBounds.expand(bounds);
+    }
+    boundsDirty = false;
+}
+
+void InstancedModel::upload()
+{
+    // 实例数据只在变化时整体上传，可见列表每次绘制都会重写
+    if (instancesDirty) {
+        ensureCapacity(instanceSSBO, INSTANCE_BINDING, instances.size());
+        instanceSSBO->updateData(instances);
+        instancesDirty = false;
+    }
+    if (materialsDirty) {
+        ensureCapacity(materialSSBO, MATERIAL_BINDING, materials.size());
+        materialSSBO->updateData(materials);
+        materialsDirty = false;
+    }
+}
+
+int InstancedModel::draw(Shader* shader, const Frustum* frustum, bool depthOnly, int& culled)
+{
+    CPU_PROFILE_SCOPE("InstancedModel::draw");
+    culled = 0;
+    if (instances.empty()) return 0;
+
+    // 先用所有实例的并集粗测，整体在外时不必逐个测试
+    visibleInstances.clear();
+    if (frustum && !frustum->intersects(get_worldBounds())) {
+        culled = static_cast<int>(instances.size());
+        return 0;
+    }
+    for (size_t i = 0; i < instances.size(); ++i) {
+        if (frustum && !frustum->intersects(instanceBounds[i])) {
+            culled++;
+            continue;
+        }
+        visibleInstances.push_back(static_cast<unsigned int>(i));
+    }
+    if (visibleInstances.empty()) return 0;
+
+    upload();
+    ensureCapacity(visibleSSBO, VISIBLE_BINDING, visibleInstances.size());
+    visibleSSBO->updateData(visibleInstances);
+
+    // 不同的实例化模型共用绑定点，绘制前重新绑定自己的缓冲
+    instanceSSBO->bindBase();
+    materialSSBO->bindBase();
+    visibleSSBO->bindBase();
+
+    int instanceCount = static_cast<int>(visibleInstances.size());
+    shader->bind();
+    shader->setUniform1i("instanced", 1);
+    for (Mesh* mesh : prototype->get_meshes()) {
+        if (!mesh->get_visibility()) continue;
+        if (!depthOnly && mesh->get_texture()) mesh->get_texture()->bind(shader);
+        mesh->get_vertexArray()->bind();
+        mesh->drawElementsInstanced(instanceCount);
+        mesh->get_vertexArray()->unbind();
+    }
+    shader->setUniform1i("instanced", 0);
+    return instanceCount;
+}
@@ -1,6 +1,11 @@
 #include "Light.h"
 
 #include "Renderer.h"
+#include "Camera.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 
 Light::Light()
 {
@@ -19,6 +24,10 @@ Light::~Light()
     for(auto &shadow : shadowMaps) {
         glDeleteFramebuffers(1, &shadow.fbo);
         glDeleteTextures(1, &shadow.texture);
+        if (shadow.staticTexture) {
+            glDeleteFramebuffers(1, &shadow.staticFbo);
+            glDeleteTextures(1, &shadow.staticTexture);
+        }
     }
 }
 
@@ -42,20 +51,124 @@ void Light::add_light(LightUnit lightUnit)
         }
     }
 
+    if (lightUnit.radius <= 0.0f) lightUnit.radius = computeRadius(lightUnit);
     lights.push_back(lightUnit);
-    lightsSSBO->updateData(lights);
+    uploadLights();
 
     // 根据灯光类型初始化对应的阴影贴图
     ShadowMapInfo shadowInfo;
     shadowInfo.isDirectional = (lightUnit.isDirectional == 1);
     if(shadowInfo.isDirectional){
-        initDirectionalShadowMap(shadowInfo);
+        shadowInfo.width = shadowInfo.height = cascadeResolution;
+        shadowInfo.layers = cascadeCount;
+        initDirectionalShadowMap(shadowInfo.fbo, shadowInfo.texture, cascadeResolution, cascadeCount);
     } else {
-        initPointShadowMap(shadowInfo);
+        shadowInfo.width = shadowInfo.height = CUBE_SHADOW_SIZE;
+        shadowInfo.layers = 6;
+        initPointShadowMap(shadowInfo.fbo, shadowInfo.texture, CUBE_SHADOW_SIZE);
     }
     shadowMaps.push_back(shadowInfo);
 }
 
+void Light::set_light(int index, const LightUnit& lightUnit)
+{
+    LightUnit unit = lightUnit;
+    // 类型不能改变（阴影贴图已按类型创建）
+    unit.isDirectional = lights[index].isDirectional;
+    if (unit.isDirectional == 1) unit.position = -10.0f * unit.direction;
+    if (unit.radius <= 0.0f) unit.radius = computeRadius(unit);
+    lights[index] = unit;
+    uploadLights();
+}
+
+void Light::set_cascadeCount(int count)
+{
+    count = std::clamp(count, 1, MAX_CASCADES);
+    if (count == cascadeCount) return;
+    cascadeCount = count;
+    recreateDirectionalShadowMaps();
+}
+
+void Light::set_cascadeResolution(int resolution)
+{
+    resolution = std::max(resolution, 16);
+    if (resolution == cascadeResolution) return;
+    cascadeResolution = resolution;
+    recreateDirectionalShadowMaps();
+}
+
+void Light::recreateDirectionalShadowMaps()
+{
+    for (auto& shadow : shadowMaps) {
+        if (!shadow.isDirectional) continue;
+        glDeleteFramebuffers(1, &shadow.fbo);
+        glDeleteTextures(1, &shadow.texture);
+        if (shadow.staticTexture) {
+            glDeleteFramebuffers(1, &shadow.staticFbo);
+            glDeleteTextures(1, &shadow.staticTexture);
+            shadow.staticFbo = 0;
+            shadow.staticTexture = 0;
+        }
+        shadow.width = shadow.height = cascadeResolution;
+        shadow.layers = cascadeCount;
+        initDirectionalShadowMap(shadow.fbo, shadow.texture, cascadeResolution, cascadeCount);
+        shadow.cascadeMatrices.clear();
+        shadow.valid = false;
+        shadow.staticValid = false;
+    }
+}
+
+void Light::set_shadowCacheEnabled(bool enabled)
+{
+    shadowCacheEnabled = enabled;
+    for (auto& shadow : shadowMaps) {
+        shadow.valid = false;
+        shadow.staticValid = false;
+    }
+}
+
+void Light::add_dynamicLight(LightUnit lightUnit)
+{
+    if (lightUnit.radius <= 0.0f) lightUnit.radius = computeRadius(lightUnit);
+    dynamicLights.push_back(lightUnit);
+    uploadLights();
+}
+
+void Light::set_dynamicLights(const std::vector<LightUnit>& units)
+{
+    dynamicLights = units;
+    for (auto& unit : dynamicLights) {
+        if (unit.radius <= 0.0f) unit.radius = computeRadius(unit);
+    }
+    uploadLights();
+}
+
+void Light::uploadLights()
+{
+    std::vector<LightUnit> allLights;
+    allLights.reserve(lights.size() + dynamicLights.size());
+    allLights.insert(allLights.end(), lights.begin(), lights.end());
+    allLights.insert(allLights.end(), dynamicLights.begin(), dynamicLights.end());
+    if (allLights.empty()) return;
+    lightsSSBO->reserve(allLights.size());
+    lightsSSBO->updateData(allLights);
+}
+
+float Light::computeRadius(const LightUnit& lightUnit)
+{
+    // 解 constant + linear*d + quadratic*d^2 = 最大亮度 / 阈值
+    const float threshold = 5.0f / 256.0f;
+    float brightness = std::max(std::max(lightUnit.color.x, lightUnit.color.y), lightUnit.color.z) *
+                       std::max(lightUnit.intensity.y, lightUnit.intensity.z);
+    float c = lightUnit.constant - brightness / threshold;
+    if (c >= 0.0f) return 0.0f;   // 在灯光位置上已经低于阈值
+    if (lightUnit.quadratic > 0.0f) {
+        return (-lightUnit.linear + std::sqrt(lightUnit.linear * lightUnit.linear - 4.0f * lightUnit.quadratic * c)) / (2.0f * lightUnit.quadratic);
+    }
+    if (lightUnit.linear > 0.0f) return -c / lightUnit.linear;
+    return FLT_MAX;   // 不衰减，影响整个场景
+}
+
 void Light::set_sUniform_light(Shader *shader)
 {
     shader->setUniform1i("numLights", static_cast<int>(lights.size()));
@@ -73,26 +186,56 @@ void Light::draw(Shader* shader)
 }
 
 
-void Light::bakeShadows(Shader* shadowMapShader_directionalLight, Shader* shadowMapShader_pointLight, std::vector<std::shared_ptr<Model>>& models)
+void Light::bakeShadows(Shader* shadowMapShader_directionalLight, Shader* shadowMapShader_pointLight, std::vector<std::shared_ptr<Model>>& models,
+                        std::vector<std::shared_ptr<InstancedModel>>& instancedModels)
 {
+    CPU_PROFILE_SCOPE("Light::bakeShadows");
+    partitionCasters(models);
+    shadowRenderCount = 0;
+    shadowSkipCount = 0;
+    // 平行光的级联按摄像机划分，所有平行光共用同一组分割
+    glm::vec3 nearCorners[4], farCorners[4];
+    float cameraNear = 0.0f, cameraFar = 0.0f;
+    bool hasCascades = updateCascadeSplits(nearCorners, farCorners, cameraNear, cameraFar);
     for (size_t i = 0; i < lights.size(); i++) {
         LightUnit &light = lights[i];
         ShadowMapInfo &shadow = shadowMaps[i];
 
         if(shadow.isDirectional) {
-            // 平行光使用正交投影
-            glm::mat4 lightView = glm::lookAt(light.position, light.position + light.direction, glm::vec3(0.0f, 1.0f, 0.0f));
-            glm::mat4 lightSpaceMatrix = lightProjection * lightView;
+            // 没有摄像机时无法划分级联，保留上次的结果
+            if (!hasCascades) {
+                shadowSkipCount++;
+                continue;
+            }
+            std::vector<glm::mat4> cascadeMatrices;
+            std::vector<Frustum> cascadeFrustums;
+            Frustum lightFrustum;
+            computeCascades(light, nearCorners, farCorners, cameraNear, cameraFar, cascadeMatrices, cascadeFrustums, lightFrustum);
+            // 级联随摄像机移动（纹素对齐之后才会变化），矩阵变化时静态层也要重新渲染
+            if (cascadeMatrices != shadow.cascadeMatrices) {
+                shadow.cascadeMatrices = cascadeMatrices;
+                shadow.valid = false;
+            }
+            bool staticDirty = true;
+            if (shadowCacheEnabled && !isShadowDirty(shadow, light, lightFrustum, models, instancedModels, staticDirty)) {
+                shadowSkipCount++;
+                continue;
+            }
             shadowMapShader_directionalLight->bind();
-            shadowMapShader_directionalLight->setUniform4fv("lightSpaceMatrix", lightSpaceMatrix);
-
-            // 渲染阴影贴图
-            glViewport(0, 0, GlobalSettings::getInstance().GetInt("SCREEN_WIDTH")* SHADOW_RATE,GlobalSettings::getInstance().GetInt("SCREEN_HEIGHT")* SHADOW_RATE);
-            glBindFramebuffer(GL_FRAMEBUFFER, shadow.fbo);
-            glClear(GL_DEPTH_BUFFER_BIT);
-            for(auto model : models) model->draw(shadowMapShader_directionalLight);
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            // 逐级渲染，每级只绘制与该级视锥相交的投射物
+            for (int cascade = 0; cascade < shadow.layers; ++cascade) {
+                shadowMapShader_directionalLight->setUniform4fv("lightSpaceMatrix", cascadeMatrices[cascade]);
+                renderShadowMap(shadow, shadowMapShader_directionalLight, cascadeFrustums[cascade], staticDirty, models, instancedModels, cascade);
+            }
+            recordShadowCasters(shadow, light, lightFrustum, models, instancedModels);
         } else {
+            // 立方体阴影覆盖以灯光为中心、半径 far_plane 的范围
+            Frustum lightFrustum = Frustum::from_box(light.position, glm::vec3(far_plane));
+            bool staticDirty = true;
+            if (shadowCacheEnabled && !isShadowDirty(shadow, light, lightFrustum, models, instancedModels, staticDirty)) {
+                shadowSkipCount++;
+                continue;
+            }
             // 点光使用立方体贴图：构造6个视角
             float near_plane = 1.0f;
             glm::mat4 shadowProj = glm::perspective(glm::radians(90.0f), 1.0f, near_plane, far_plane);
@@ -111,22 +254,233 @@ void Light::bakeShadows(Shader* shadowMapShader_directionalLight, Shader* shadow
             shadowMapShader_pointLight->setUniform1f("far_plane", far_plane);
             shadowMapShader_pointLight->setUniform3f("lightPos", light.position.x, light.position.y, light.position.z);
 
-            glViewport(0, 0, CUBE_SHADOW_SIZE, CUBE_SHADOW_SIZE);
-            glBindFramebuffer(GL_FRAMEBUFFER, shadow.fbo);
+            renderShadowMap(shadow, shadowMapShader_pointLight, lightFrustum, staticDirty, models, instancedModels);
+            recordShadowCasters(shadow, light, lightFrustum, models, instancedModels);
+        }
+        shadow.staticValid = shadowCacheEnabled && !staticCasters.empty();
+        shadowRenderCount++;
+    }
+    if (shadowRenderCount > 0) {
+        glViewport(0, 0, GlobalSettings::getInstance().GetInt("SCREEN_WIDTH"),GlobalSettings::getInstance().GetInt("SCREEN_HEIGHT"));
+    }
+}
+
+bool Light::updateCascadeSplits(glm::vec3 nearCorners[4], glm::vec3 farCorners[4], float& cameraNear, float& cameraFar)
+{
+    Camera* camera = Renderer::getInstance().get_camera();
+    if (!camera) return false;
+    cameraNear = camera->getNearPlane();
+    cameraFar = camera->getFarPlane();
+    float farthest = std::min(shadowDistance, cameraFar);
+    // 实用分割：对数分割让近处的级更小，均匀分割避免远处的级过大
+    cascadeSplits = glm::vec4(0.0f);
+    for (int i = 1; i <= cascadeCount; ++i) {
+        float p = static_cast<float>(i) / cascadeCount;
+        float logSplit = cameraNear * std::pow(farthest / cameraNear, p);
+        float uniformSplit = cameraNear + (farthest - cameraNear) * p;
+        cascadeSplits[i - 1] = cascadeSplitLambda * logSplit + (1.0f - cascadeSplitLambda) * uniformSplit;
+    }
+    cascadeViewMatrix = camera->getViewMatrix();
+
+    // 视锥角点：NDC 的近、远平面四角逆变换回世界空间
+    glm::mat4 inverseViewProjection = glm::inverse(camera->getViewProjectionMatrix());
+    const glm::vec2 ndcCorners[4] = { {-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f} };
+    for (int i = 0; i < 4; ++i) {
+        glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcCorners[i].x, ndcCorners[i].y, -1.0f, 1.0f);
+        glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcCorners[i].x, ndcCorners[i].y, 1.0f, 1.0f);
+        nearCorners[i] = glm::vec3(nearPoint) / nearPoint.w;
+        farCorners[i] = glm::vec3(farPoint) / farPoint.w;
+    }
+    return true;
+}
+
+void Light::computeCascades(const LightUnit& light, const glm::vec3 nearCorners[4], const glm::vec3 farCorners[4], float cameraNear, float cameraFar,
+                            std::vector<glm::mat4>& matrices, std::vector<Frustum>& frustums, Frustum& influence) const
+{
+    // 只含旋转的光源观察矩阵，各级只在光空间内平移，纹素网格在世界空间中固定
+    glm::vec3 direction = glm::normalize(light.direction);
+    glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), direction, up);
+
+    glm::vec3 unionMin(FLT_MAX), unionMax(-FLT_MAX);
+    float sliceStart = cameraNear;
+    for (int cascade = 0; cascade < cascadeCount; ++cascade) {
+        float sliceEnd = cascadeSplits[cascade];
+        // 角点在近、远平面对应角点的连线上随观察深度线性变化
+        float t0 = (sliceStart - cameraNear) / (cameraFar - cameraNear);
+        float t1 = (sliceEnd - cameraNear) / (cameraFar - cameraNear);
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+        for (int i = 0; i < 4; ++i) {
+            corners[i] = glm::mix(nearCorners[i], farCorners[i], t0);
+            corners[i + 4] = glm::mix(nearCorners[i], farCorners[i], t1);
+            center += corners[i] + corners[i + 4];
+        }
+        center /= 8.0f;
+        float radius = 0.0f;
+        for (const auto& corner : corners) radius = std::max(radius, glm::length(corner - center));
+        // 半径取整，避免浮点误差让投影大小逐帧抖动
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        // 中心对齐到纹素
+        float texelSize = 2.0f * radius / cascadeResolution;
+        glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+        lightCenter.x = std::floor(lightCenter.x / texelSize) * texelSize;
+        lightCenter.y = std::floor(lightCenter.y / texelSize) * texelSize;
+
+        // 光空间中看向 -z：近平面向光源方向多延伸 cascadeCasterDistance
+        glm::vec3 boxMin(lightCenter.x - radius, lightCenter.y - radius, -(lightCenter.z + radius) - cascadeCasterDistance);
+        glm::vec3 boxMax(lightCenter.x + radius, lightCenter.y + radius, -(lightCenter.z - radius));
+        glm::mat4 projection = glm::ortho(boxMin.x, boxMax.x, boxMin.y, boxMax.y, boxMin.z, boxMax.z);
+        matrices.push_back(projection * lightView);
+        frustums.emplace_back(matrices.back());
+        unionMin = glm::min(unionMin, boxMin);
+        unionMax = glm::max(unionMax, boxMax);
+        sliceStart = sliceEnd;
+    }
+    influence = Frustum(glm::ortho(unionMin.x, unionMax.x, unionMin.y, unionMax.y, unionMin.z, unionMax.z) * lightView);
+}
+
+void Light::partitionCasters(const std::vector<std::shared_ptr<Model>>& models)
+{
+    unsigned int sceneVersion = Renderer::getInstance().get_sceneVersion();
+    if (&models == partitionSource && models.size() == partitionSize && sceneVersion == partitionSceneVersion) return;
+    partitionSource = &models;
+    partitionSize = models.size();
+    partitionSceneVersion = sceneVersion;
+    staticCasters.clear();
+    dynamicCasters.clear();
+    for (const auto& model : models) {
+        (model->is_static() ? staticCasters : dynamicCasters).push_back(model);
+    }
+    // 拆分变化后静态层的内容也随之变化
+    for (auto& shadow : shadowMaps) shadow.staticValid = false;
+}
+
+bool Light::isShadowDirty(const ShadowMapInfo& shadow, const LightUnit& light, const Frustum& lightFrustum,
+                          const std::vector<std::shared_ptr<Model>>& models,
+                          std::vector<std::shared_ptr<InstancedModel>>& instancedModels, bool& staticDirty) const
+{
+    staticDirty = true;
+    if (!shadow.valid || shadow.sceneVersion != Renderer::getInstance().get_sceneVersion() ||
+        shadow.bakedPosition != light.position || shadow.bakedDirection != light.direction) {
+        return true;
+    }
+    staticDirty = false;
+    bool meshesChanged = Mesh::get_changeVersion() != shadow.meshVersion;
+    bool instancesChanged = InstancedModel::get_changeVersion() != shadow.instanceVersion;
+    if (!meshesChanged && !instancesChanged) return false;
+
+    // 只有之后变化过、并且现在或上次在影响范围内的投射物才需要重新渲染
+    bool dirty = false;
+    if (meshesChanged) {
+        for (const auto& model : models) {
+            for (const Mesh* mesh : model->get_meshes()) {
+                if (mesh->get_version() <= shadow.meshVersion) continue;
+                if (!lightFrustum.intersects(mesh->get_worldBounds()) &&
+                    !std::binary_search(shadow.casters.begin(), shadow.casters.end(), mesh)) continue;
+                dirty = true;
+                if (mesh->is_static()) {
+                    staticDirty = true;
+                    return true;
+                }
+            }
+        }
+    }
+    if (!dirty && instancesChanged) {
+        for (const auto& instancedModel : instancedModels) {
+            if (instancedModel->get_version() <= shadow.instanceVersion) continue;
+            if (lightFrustum.intersects(instancedModel->get_worldBounds()) ||
+                std::binary_search(shadow.instancedCasters.begin(), shadow.instancedCasters.end(), instancedModel.get())) {
+                return true;
+            }
+        }
+    }
+    return dirty;
+}
+
+void Light::renderShadowMap(ShadowMapInfo& shadow, Shader* shader, const Frustum& lightFrustum, bool staticDirty,
+                            std::vector<std::shared_ptr<Model>>& models, std::vector<std::shared_ptr<InstancedModel>>& instancedModels, int layer)
+{
+    glViewport(0, 0, shadow.width, shadow.height);
+    // 级联逐层渲染：把纹理数组的这一层挂到帧缓冲上
+    auto bindTarget = [&](unsigned int fbo, unsigned int texture) {
+        gl::bindFramebuffer(GL_FRAMEBUFFER, fbo);
+        if (layer >= 0) glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, layer);
+    };
+    bool useStaticLayer = shadowCacheEnabled && !staticCasters.empty();
+    if (useStaticLayer) {
+        GLenum target = shadow.isDirectional ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_CUBE_MAP;
+        if (!shadow.staticTexture) {
+            if (shadow.isDirectional) {
+                initDirectionalShadowMap(shadow.staticFbo, shadow.staticTexture, shadow.width, shadow.layers);
+            } else {
+                initPointShadowMap(shadow.staticFbo, shadow.staticTexture, shadow.width);
+            }
+        }
+        if (staticDirty || !shadow.staticValid) {
+            bindTarget(shadow.staticFbo, shadow.staticTexture);
             glClear(GL_DEPTH_BUFFER_BIT);
-            for(auto model : models) model->draw(shadowMapShader_pointLight);
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            drawShadowCasters(staticCasters, shader, lightFrustum, staticShadowCulling);
         }
+        // 以静态层为底，之后只叠加动态投射物
+        gl::copyImageSubData(shadow.staticTexture, target, 0, 0, 0, std::max(layer, 0), shadow.texture, target, 0, 0, 0, std::max(layer, 0),
+                             shadow.width, shadow.height, layer >= 0 ? 1 : shadow.layers);
+        bindTarget(shadow.fbo, shadow.texture);
+    } else {
+        bindTarget(shadow.fbo, shadow.texture);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+    drawShadowCasters(useStaticLayer ? dynamicCasters : models, shader, lightFrustum, shadowCulling);
+    drawInstancedModels(instancedModels, shader, "Shadow", &lightFrustum, true);
+    gl::bindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Light::recordShadowCasters(ShadowMapInfo& shadow, const LightUnit& light, const Frustum& lightFrustum,
+                                const std::vector<std::shared_ptr<Model>>& models,
+                                std::vector<std::shared_ptr<InstancedModel>>& instancedModels) const
+{
+    shadow.valid = true;
+    shadow.bakedPosition = light.position;
+    shadow.bakedDirection = light.direction;
+    shadow.meshVersion = Mesh::get_changeVersion();
+    shadow.instanceVersion = InstancedModel::get_changeVersion();
+    shadow.sceneVersion = Renderer::getInstance().get_sceneVersion();
+    shadow.casters.clear();
+    for (const auto& model : models) {
+        for (const Mesh* mesh : model->get_meshes()) {
+            if (lightFrustum.intersects(mesh->get_worldBounds())) shadow.casters.push_back(mesh);
+        }
+    }
+    std::sort(shadow.casters.begin(), shadow.casters.end());
+    shadow.instancedCasters.clear();
+    for (const auto& instancedModel : instancedModels) {
+        if (lightFrustum.intersects(instancedModel->get_worldBounds())) shadow.instancedCasters.push_back(instancedModel.get());
+    }
+    std::sort(shadow.instancedCasters.begin(), shadow.instancedCasters.end());
+}
+
+void Light::drawShadowCasters(std::vector<std::shared_ptr<Model>>& models, Shader* shader, const Frustum& lightFrustum, GpuCulling& culling)
+{
+    if (!Renderer::getInstance().is_gpuCullingEnabled()) {
+        drawModels(shadowQueue, models, shader, "Shadow", &lightFrustum, true);
+        return;
     }
-    glViewport(0, 0, GlobalSettings::getInstance().GetInt("SCREEN_WIDTH"),GlobalSettings::getInstance().GetInt("SCREEN_HEIGHT"));
+    culling.update(models, true);
+    culling.cull(&lightFrustum);
+    culling.draw(shader, true);
 }
 
 // 绑定阴影贴图
 void Light::bind_shadow(Shader *shader)
 {
+    CPU_PROFILE_SCOPE("Light::bind_shadow");
     shader->bind();
-    shader->setUniform4fv("lightProjection", lightProjection);
     shader->setUniform1f("farPlane", far_plane);
+    // 级联：分割与摄像机观察矩阵为最近一次烘焙时的值，矩阵按 平行光序号 * MAX_CASCADES + 级 排列
+    shader->setUniform1i("cascadeCount", cascadeCount);
+    shader->setUniform4f("cascadeSplits", cascadeSplits.x, cascadeSplits.y, cascadeSplits.z, cascadeSplits.w);
+    shader->setUniform4fv("cascadeViewMatrix", cascadeViewMatrix);
 
     int start_slot_shaderMap = GlobalSettings::getInstance().GetInt("MAX_OBJECT_TEXTURE_SLOTS");
 
@@ -148,14 +502,18 @@ void Light::bind_shadow(Shader *shader)
         int k = start_slot_shaderMap + i;  // 阴影贴图排在普通贴图后面
         if(shadowMaps[i].isDirectional){
             glActiveTexture(GL_TEXTURE0 + k);   
-            glBindTexture(GL_TEXTURE_2D, shadowMaps[i].texture);
+            gl::bindTexture(GL_TEXTURE_2D_ARRAY, shadowMaps[i].texture);
+            for (size_t cascade = 0; cascade < shadowMaps[i].cascadeMatrices.size(); ++cascade) {
+                glm::mat4 matrix = shadowMaps[i].cascadeMatrices[cascade];
+                shader->setUniform4fv("cascadeMatrices[" + std::to_string(directionalLightIndex * MAX_CASCADES + cascade) + "]", matrix);
+            }
             // 生成着色器采样器变量名，如 "shadowMap[0]", "shadowMap[1]"
             std::string texUniformName = "shadowMaps[" + std::to_string(directionalLightIndex) + "]"; 
             directionalLightIndex ++;
             shader->setUniform1i(texUniformName, k);
         } else{
             glActiveTexture(GL_TEXTURE0 + k + MAX_SHADOW_MAP_SLOTS);   
-            glBindTexture(GL_TEXTURE_CUBE_MAP, shadowMaps[i].texture);
+            gl::bindTexture(GL_TEXTURE_CUBE_MAP, shadowMaps[i].texture);
             // 生成着色器采样器变量名，如 "shadowMapCube[0]", "shadowMapCube[1]"
             std::string texUniformName = "shadowCubeMaps[" + std::to_string(pointLightIndex) + "]"; 
             pointLightIndex ++;
@@ -164,24 +522,25 @@ void Light::bind_shadow(Shader *shader)
     }
 }
 
-// 初始化平行光的阴影贴图（2D纹理）
+// 初始化平行光的阴影贴图（2D 纹理数组，每级一层，大小与屏幕无关）
 //
-void Light::initDirectionalShadowMap(ShadowMapInfo &shadowInfo)
+void Light::initDirectionalShadowMap(unsigned int& fbo, unsigned int& texture, int size, int layers)
 {
-    glGenFramebuffers(1, &shadowInfo.fbo);
-    glGenTextures(1, &shadowInfo.texture);
-    glBindTexture(GL_TEXTURE_2D, shadowInfo.texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, GlobalSettings::getInstance().GetInt("SCREEN_WIDTH")* SHADOW_RATE,GlobalSettings::getInstance().GetInt("SCREEN_HEIGHT")* SHADOW_RATE, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glGenFramebuffers(1, &fbo);
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, size, size, layers, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
     // 对视野外的颜色做填充
     float borderColor[] = {1.0f, 1.0f, 1.0f, 1.0f};
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, shadowInfo.fbo);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowInfo.texture, 0);
+    // 渲染时逐级切换挂载的层，这里先挂第 0 层检查完整性
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, 0);
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
     if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
@@ -192,13 +551,13 @@ void Light::initDirectionalShadowMap(ShadowMapInfo &shadowInfo)
 //
 // 初始化点光的阴影贴图（立方体纹理）
 //
-void Light::initPointShadowMap(ShadowMapInfo &shadowInfo)
+void Light::initPointShadowMap(unsigned int& fbo, unsigned int& texture, int size)
 {
-    glGenFramebuffers(1, &shadowInfo.fbo);
-    glGenTextures(1, &shadowInfo.texture);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, shadowInfo.texture);
+    glGenFramebuffers(1, &fbo);
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
     for (unsigned int i = 0; i < 6; ++i) {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, CUBE_SHADOW_SIZE, CUBE_SHADOW_SIZE, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
     }
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -206,8 +565,8 @@ void Light::initPointShadowMap(ShadowMapInfo &shadowInfo)
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, shadowInfo.fbo);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowInfo.texture, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0);
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
     if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
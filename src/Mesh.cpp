@@ -1,5 +1,11 @@
 #include "Mesh.h"
 #include "Shader.h"
+#include "SceneBVH.h"
+#include "GeometryPool.h"
+#include <algorithm>
+#include <cmath>
+
+unsigned long long Mesh::s_ChangeVersion = 0;
 
 Mesh::Mesh(): model(glm::mat4(1.0f)), position(0.0f), eulerAngles(0.0f), scale(1.0f), visibility(true), texture(nullptr)
 { 
@@ -8,14 +14,35 @@ Mesh::Mesh(): model(glm::mat4(1.0f)), position(0.0f), eulerAngles(0.0f), scale(1
 
 Mesh::~Mesh()
 {
+    if (geometryPool) geometryPool->release(this);
+    if (bvh) bvh->remove_primitive(bvhPrimitive, this);
     delete texture;
     delete VAO;
 }
 
 void Mesh::set_mesh(std::vector<Vertexdata> vertices, std::vector<unsigned int> indices, bool if_Cal_Tangents)
 {
-    this->vertices = vertices;
     this->indices = indices;
+    // 几何变化后共享缓冲中的副本失效，下次多重绘制时重新登记
+    if (geometryPool) {
+        geometryPool->release(this);
+        geometryPool = nullptr;
+    }
+
+    // 局部包围盒，包围球以盒中心为球心
+    localBounds = AABB();
+    for (const auto& vertex : vertices) {
+        localBounds.expand(vertex.Position);
+    }
+    localSphere = BoundingSphere();
+    if (localBounds.is_valid()) {
+        localSphere.center = localBounds.center();
+        localSphere.radius = 0.0f;
+        for (const auto& vertex : vertices) {
+            localSphere.radius = std::max(localSphere.radius, glm::length(vertex.Position - localSphere.center));
+        }
+    }
+    updateWorldBounds();
 
     if (if_Cal_Tangents) {
         // 计算切线和副切线
@@ -28,6 +55,8 @@ void Mesh::set_mesh(std::vector<Vertexdata> vertices, std::vector<unsigned int>
             vertices[i].tangentW = 1.0f; // 默认方向为 +1
         }
     }
+    // 保存含切线的顶点，共享几何缓冲会用它重新上传
+    this->vertices = vertices;
 
     // 使用自定义的类，管理一个VAO，并绑定VBO和IBO
     VAO = new VertexArrayObject();
@@ -200,6 +229,7 @@ void Mesh::set_scale(const glm::vec3& scl)
 void Mesh::set_visibility(const bool visiable)
 {
     visibility = visiable;
+    version = ++s_ChangeVersion;
 }
 
 
@@ -215,11 +245,21 @@ void Mesh::draw(Shader* shader)
             texture->bind(shader);
 
         bind();
-        glDrawElements(GL_TRIANGLES, getNumElements(), GL_UNSIGNED_INT, 0);
+        drawElements();
         unbind();
     }
 }
 
+void Mesh::drawElements()
+{
+    gl::drawElements(GL_TRIANGLES, getNumElements(), GL_UNSIGNED_INT, 0);
+}
+
+void Mesh::drawElementsInstanced(int instanceCount)
+{
+    gl::drawElementsInstanced(GL_TRIANGLES, getNumElements(), GL_UNSIGNED_INT, 0, instanceCount);
+}
+
 void Mesh::updateModelMatrix()
 {
     glm::mat4 scaleMatrix = glm::scale(glm::mat4(1.0f), scale);
@@ -227,6 +267,57 @@ void Mesh::updateModelMatrix()
     glm::mat4 translationMatrix = glm::translate(glm::mat4(1.0f), position);
 
     model = translationMatrix * rotationMatrix * scaleMatrix;
+    version = ++s_ChangeVersion;
+    updateWorldBounds();
+}
+
+void Mesh::updateWorldBounds()
+{
+    worldBounds = localBounds.transformed(model);
+    worldSphere = BoundingSphere();
+    if (localSphere.is_valid()) {
+        float maxScale = std::max(std::abs(scale.x), std::max(std::abs(scale.y), std::abs(scale.z)));
+        worldSphere.center = glm::vec3(model * glm::vec4(localSphere.center, 1.0f));
+        worldSphere.radius = localSphere.radius * maxScale;
+    }
+    if (bvh) bvh->mark_dirty(bvhPrimitive, this);
+}
+
+bool Mesh::intersect_ray(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const
+{
+    // 变换到局部空间求交，仿射变换下射线参数 t 保持不变
+    glm::mat4 invModel = glm::inverse(model);
+    glm::vec3 localOrigin = glm::vec3(invModel * glm::vec4(origin, 1.0f));
+    glm::vec3 localDirection = glm::vec3(invModel * glm::vec4(direction, 0.0f));
+
+    bool found = false;
+    float closest = maxDistance;
+    const float EPSILON = 1e-7f;
+    // Möller–Trumbore
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const glm::vec3& v0 = vertices[indices[i]].Position;
+        const glm::vec3& v1 = vertices[indices[i + 1]].Position;
+        const glm::vec3& v2 = vertices[indices[i + 2]].Position;
+        glm::vec3 edge1 = v1 - v0;
+        glm::vec3 edge2 = v2 - v0;
+        glm::vec3 p = glm::cross(localDirection, edge2);
+        float det = glm::dot(edge1, p);
+        if (std::abs(det) < EPSILON) continue;
+        float invDet = 1.0f / det;
+        glm::vec3 s = localOrigin - v0;
+        float u = glm::dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f) continue;
+        glm::vec3 q = glm::cross(s, edge1);
+        float v = glm::dot(localDirection, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f) continue;
+        float t = glm::dot(edge2, q) * invDet;
+        if (t > 0.0f && t < closest) {
+            closest = t;
+            found = true;
+        }
+    }
+    if (found) distance = closest;
+    return found;
 }
 
 void Mesh::calculateTangents(const std::vector<Vertexdata> &vertices, const std::vector<unsigned int> &indices, std::vector<glm::vec3> &tangents)
@@ -1,6 +1,7 @@
 #include "Model.h"
 #include "Mesh.h"
 #include "Renderer.h"
+#include "CpuProfiler.h"
 
 Shader* Model::get_singleColor_shader()
 {
@@ -53,13 +54,45 @@ void Model::add_basic_geom(BasicGeom geomType, Texture *texture)
 // 依次绘制所有网格
 void Model::draw(Shader* shader)
 {
-    
+    CPU_PROFILE_SCOPE("Model::draw");
     for(unsigned int i = 0; i < meshes.size(); i++)
         meshes[i]->draw(shader);
 
     draw_outline();
 }
 
+AABB Model::get_worldBounds() const
+{
+    AABB bounds;
+    for (auto mesh : meshes)
+        bounds.expand(mesh->get_worldBounds());
+    return bounds;
+}
+
+bool Model::is_static() const
+{
+    if (meshes.empty()) return false;
+    for (auto mesh : meshes)
+        if (!mesh->is_static()) return false;
+    return true;
+}
+
+BoundingSphere Model::get_worldSphere() const
+{
+    BoundingSphere sphere;
+    AABB bounds = get_worldBounds();
+    if (!bounds.is_valid()) return sphere;
+
+    sphere.center = bounds.center();
+    sphere.radius = 0.0f;
+    for (auto mesh : meshes) {
+        const BoundingSphere& meshSphere = mesh->get_worldSphere();
+        if (meshSphere.is_valid())
+            sphere.radius = std::max(sphere.radius, glm::length(meshSphere.center - sphere.center) + meshSphere.radius);
+    }
+    return sphere;
+}
+
 void Model::draw_outline(Shader* outlineShader)
 {
     if (!ifDrawOutline) return;
@@ -103,6 +136,7 @@ void Model::draw_outline(Shader* outlineShader)
 
 void Model::loadModel(std::string path)
 {
+    CPU_PROFILE_SCOPE("Model::loadModel");
     Assimp::Importer import;
     const aiScene *scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs| aiProcess_CalcTangentSpace);    
 
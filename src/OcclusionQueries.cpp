@@ -0,0 +1,142 @@
+#include "OcclusionQueries.h"
+#include "Renderer.h"
+#include "Camera.h"
+#include "Model.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "GLStats.h"
+#include "CpuProfiler.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdint>
+
+Shader* OcclusionQueries::get_box_shader()
+{
+    static Shader* boxShader = nullptr;
+    if (!boxShader)
+    {
+        boxShader = new Shader("res/shader/Occlusion_box.shader");
+    }
+    return boxShader;
+}
+
+OcclusionQueries::~OcclusionQueries()
+{
+    reset();
+}
+
+void OcclusionQueries::reset()
+{
+    for (auto& [model, state] : states) {
+        if (state.query) glDeleteQueries(1, &state.query);
+    }
+    states.clear();
+}
+
+void OcclusionQueries::classify(const std::vector<std::shared_ptr<Model>>& models, const Frustum* frustum)
+{
+    CPU_PROFILE_SCOPE("OcclusionQueries::classify");
+    Renderer& renderer = Renderer::getInstance();
+    // 模型增删后指针可能被复用，直接丢掉全部历史
+    if (renderer.get_sceneVersion() != sceneVersion) {
+        reset();
+        sceneVersion = renderer.get_sceneVersion();
+    }
+    if (renderer.get_camera()) viewPosition = renderer.get_camera()->getCameraPosition();
+    frame++;
+
+    visibleModels.clear();
+    hiddenModels.clear();
+    hiddenMeshCount = 0;
+    frustumCulledMeshCount = 0;
+    for (const auto& model : models) {
+        if (frustum && !frustum->intersects(model->get_worldBounds())) {
+            frustumCulledMeshCount += static_cast<int>(model->get_meshes().size());
+            continue;
+        }
+        State& state = states[model.get()];
+        // 只读取已经返回的结果，不等待
+        if (state.pending) {
+            GLuint available = 0;
+            glGetQueryObjectuiv(state.query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint samples = 0;
+                glGetQueryObjectuiv(state.query, GL_QUERY_RESULT, &samples);
+                state.visible = samples != 0;
+                state.pending = false;
+            }
+        }
+        if (state.visible) {
+            visibleModels.push_back(model);
+        } else {
+            hiddenModels.push_back(model);
+            hiddenMeshCount += static_cast<int>(model->get_meshes().size());
+        }
+    }
+}
+
+void OcclusionQueries::issue(Shader* shader)
+{
+    CPU_PROFILE_SCOPE("OcclusionQueries::issue");
+    if (!boxMesh) {
+        boxMesh = std::make_unique<Mesh>();
+        boxMesh->set_mesh_cube();
+    }
+    queryCount = 0;
+
+    // 包围盒查询：只做深度测试，不写颜色和深度
+    Shader* boxShader = get_box_shader();
+    boxShader->bind();
+    // 深度预渲染之后几何通道以 GL_EQUAL 绘制，包围盒查询仍按 GL_LESS 测试
+    GLint depthFunc = GL_LESS;
+    glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+    glDepthFunc(GL_LESS);
+    GLboolean depthMask = GL_TRUE;
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    boxMesh->get_vertexArray()->bind();
+    auto query = [&](const std::shared_ptr<Model>& model, State& state) {
+        AABB bounds = model->get_worldBounds();
+        // 摄像机在包围盒内时包围盒的正面都在身后，查询结果不可靠，直接视为可见
+        glm::vec3 nearest = glm::clamp(viewPosition, bounds.min, bounds.max);
+        if (nearest == viewPosition) {
+            state.visible = true;
+            return;
+        }
+        if (!state.query) glGenQueries(1, &state.query);
+        glm::mat4 boxMatrix = glm::translate(glm::mat4(1.0f), bounds.center()) * glm::scale(glm::mat4(1.0f), bounds.extent());
+        boxShader->setUniform4fv("modelMatrix", boxMatrix);
+        glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, state.query);
+        boxMesh->drawElements();
+        glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+        state.pending = true;
+        queryCount++;
+    };
+    for (const auto& model : hiddenModels) {
+        State& state = states[model.get()];
+        if (!state.pending) query(model, state);
+    }
+    for (const auto& model : visibleModels) {
+        State& state = states[model.get()];
+        // 按模型地址错开查询的帧，避免所有可见模型挤在同一帧
+        unsigned int phase = static_cast<unsigned int>(reinterpret_cast<uintptr_t>(model.get()) >> 4);
+        if (!state.pending && (frame + phase) % visibleQueryInterval == 0) query(model, state);
+    }
+    boxMesh->get_vertexArray()->unbind();
+    glDepthFunc(depthFunc);
+    glDepthMask(depthMask);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    // 不可见组：由 GPU 按最近一次包围盒查询的结果决定是否光栅化
+    shader->bind();
+    for (const auto& model : hiddenModels) {
+        const State& state = states[model.get()];
+        // 摄像机进入包围盒后改为直接绘制
+        bool conditional = !state.visible && state.query;
+        if (conditional) glBeginConditionalRender(state.query, GL_QUERY_WAIT);
+        for (Mesh* mesh : model->get_meshes()) {
+            mesh->draw(shader);
+        }
+        if (conditional) glEndConditionalRender();
+    }
+}
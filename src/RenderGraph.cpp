@@ -0,0 +1,181 @@
+#include "RenderGraph.h"
+#include "Renderer.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <iostream>
+
+void RenderGraph::PassBuilder::read(const char* resource)
+{
+    int index = graph.findOrAddResource(resource);
+    auto& reads = graph.nodes[node].reads;
+    if (std::find(reads.begin(), reads.end(), index) == reads.end()) reads.push_back(index);
+}
+
+void RenderGraph::PassBuilder::write(const char* resource)
+{
+    int index = graph.findOrAddResource(resource);
+    auto& writes = graph.nodes[node].writes;
+    if (std::find(writes.begin(), writes.end(), index) == writes.end()) writes.push_back(index);
+}
+
+void RenderGraph::PassBuilder::create(const char* resource, const FramebufferPool::Desc& desc)
+{
+    write(resource);
+    ResourceNode& node = graph.resources[graph.findOrAddResource(resource)];
+    // 多个通道创建同一资源时以第一个为准
+    if (node.framebufferResource) return;
+    node.framebufferResource = true;
+    node.desc = desc;
+}
+
+int RenderGraph::findOrAddResource(const char* name)
+{
+    auto it = resourceIndex.find(name);
+    if (it != resourceIndex.end()) return it->second;
+    int index = static_cast<int>(resources.size());
+    resources.push_back({name});
+    resourceIndex[name] = index;
+    return index;
+}
+
+void RenderGraph::compile(const std::vector<std::unique_ptr<RenderPass>>& passes, const char* output)
+{
+    CPU_PROFILE_SCOPE("RenderGraph::compile");
+    nodes.clear();
+    resources.clear();
+    resourceIndex.clear();
+    steps.clear();
+    culledPasses.clear();
+    disabledPasses.clear();
+
+    // 收集声明
+    for (const auto& pass : passes) {
+        if (!pass->is_enabled()) {
+            disabledPasses.push_back(pass->get_name());
+            continue;
+        }
+        nodes.push_back({pass.get()});
+        PassBuilder builder(*this, static_cast<int>(nodes.size()) - 1);
+        pass->declare(builder);
+    }
+    int outputIndex = findOrAddResource(output);
+    auto writesTo = [](const PassNode& node, int resource) {
+        return std::find(node.writes.begin(), node.writes.end(), resource) != node.writes.end();
+    };
+
+    // 剔除：从写入输出的通道出发，读取的资源的全部写入者都存活
+    std::vector<int> worklist;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (writesTo(nodes[i], outputIndex)) {
+            nodes[i].live = true;
+            worklist.push_back(static_cast<int>(i));
+        }
+    }
+    while (!worklist.empty()) {
+        int current = worklist.back();
+        worklist.pop_back();
+        for (int resource : nodes[current].reads) {
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                if (!nodes[i].live && writesTo(nodes[i], resource)) {
+                    nodes[i].live = true;
+                    worklist.push_back(static_cast<int>(i));
+                }
+            }
+        }
+    }
+
+    // 依赖：同一资源的写入者按注册顺序串成一条链，最后一个写入者先于所有只读它的通道
+    size_t count = nodes.size();
+    std::vector<std::vector<int>> successors(count);
+    std::vector<int> predecessorCount(count, 0);
+    auto addEdge = [&](int from, int to) {
+        auto& list = successors[from];
+        if (std::find(list.begin(), list.end(), to) != list.end()) return;
+        list.push_back(to);
+        predecessorCount[to]++;
+    };
+    for (size_t resource = 0; resource < resources.size(); ++resource) {
+        int lastWriter = -1;
+        for (size_t i = 0; i < count; ++i) {
+            if (!nodes[i].live || !writesTo(nodes[i], static_cast<int>(resource))) continue;
+            if (lastWriter >= 0) addEdge(lastWriter, static_cast<int>(i));
+            lastWriter = static_cast<int>(i);
+        }
+        if (lastWriter < 0) continue;
+        for (size_t i = 0; i < count; ++i) {
+            if (!nodes[i].live || static_cast<int>(i) == lastWriter || writesTo(nodes[i], static_cast<int>(resource))) continue;
+            const auto& reads = nodes[i].reads;
+            if (std::find(reads.begin(), reads.end(), static_cast<int>(resource)) != reads.end()) addEdge(lastWriter, static_cast<int>(i));
+        }
+    }
+
+    // 拓扑排序，可选的通道中总是取注册最早的
+    std::vector<int> order;
+    std::vector<bool> scheduled(count, false);
+    for (size_t i = 0; i < count; ++i) {
+        if (!nodes[i].live) {
+            culledPasses.push_back(nodes[i].pass->get_name());
+            scheduled[i] = true;
+        }
+    }
+    while (true) {
+        int next = -1;
+        for (size_t i = 0; i < count; ++i) {
+            if (!scheduled[i] && predecessorCount[i] == 0) {
+                next = static_cast<int>(i);
+                break;
+            }
+        }
+        if (next < 0) break;
+        scheduled[next] = true;
+        order.push_back(next);
+        for (int successor : successors[next]) predecessorCount[successor]--;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (scheduled[i]) continue;
+        // 声明出现环（同一资源互相读写），剩下的按注册顺序执行
+        std::cerr << "RenderGraph: dependency cycle at pass " << nodes[i].pass->get_name() << std::endl;
+        order.push_back(static_cast<int>(i));
+    }
+
+    // 帧缓冲资源的生命周期：第一个到最后一个使用它的步骤
+    steps.resize(order.size());
+    std::vector<int> firstStep(resources.size(), -1);
+    std::vector<int> lastStep(resources.size(), -1);
+    for (size_t step = 0; step < order.size(); ++step) {
+        const PassNode& node = nodes[order[step]];
+        steps[step].pass = node.pass;
+        for (const auto* list : { &node.reads, &node.writes }) {
+            for (int resource : *list) {
+                if (firstStep[resource] < 0) firstStep[resource] = static_cast<int>(step);
+                lastStep[resource] = static_cast<int>(step);
+            }
+        }
+    }
+    for (size_t resource = 0; resource < resources.size(); ++resource) {
+        if (!resources[resource].framebufferResource || firstStep[resource] < 0) continue;
+        steps[firstStep[resource]].acquire.push_back(static_cast<int>(resource));
+        steps[lastStep[resource]].release.push_back(static_cast<int>(resource));
+    }
+}
+
+void RenderGraph::beginStep(size_t i, FramebufferPool& pool)
+{
+    for (int resource : steps[i].acquire) {
+        resources[resource].framebuffer = pool.acquire(resources[resource].desc);
+    }
+}
+
+void RenderGraph::endStep(size_t i, FramebufferPool& pool)
+{
+    for (int resource : steps[i].release) {
+        pool.release(resources[resource].framebuffer);
+        resources[resource].framebuffer = nullptr;
+    }
+}
+
+Framebuffer* RenderGraph::get_framebuffer(const char* resource) const
+{
+    auto it = resourceIndex.find(resource);
+    return it != resourceIndex.end() ? resources[it->second].framebuffer : nullptr;
+}
@@ -0,0 +1,281 @@
+#include "RenderQueue.h"
+#include "Model.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "GeometryPool.h"
+#include "SoftwareOcclusion.h"
+#include "SceneBVH.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+
+namespace {
+    const int PASS_BITS = 4;
+    const int SHADER_BITS = 12;
+    const int MATERIAL_BITS = 16;
+    const int VAO_BITS = 16;
+    const int DEPTH_BITS = 16;
+
+    const int DEPTH_SHIFT = 0;
+    const int VAO_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+    const int MATERIAL_SHIFT = VAO_SHIFT + VAO_BITS;
+    const int SHADER_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+    const int PASS_SHIFT = SHADER_SHIFT + SHADER_BITS;
+
+    inline uint64_t field(uint64_t value, int bits, int shift) {
+        return (value & ((1ull << bits) - 1)) << shift;
+    }
+}
+
+void RenderQueue::clear()
+{
+    items.clear();
+    shaderSlots.clear();
+    materialSlots.clear();
+    culledCount = 0;
+}
+
+void RenderQueue::set_frustum(const Frustum* frustum)
+{
+    cullingEnabled = frustum != nullptr;
+    if (frustum) this->frustum = *frustum;
+}
+
+void RenderQueue::set_view(const glm::vec3& viewPosition, float maxDistance)
+{
+    this->viewPosition = viewPosition;
+    this->maxDistance = maxDistance > 0.0f ? maxDistance : 1.0f;
+}
+
+void RenderQueue::collect(const std::vector<std::shared_ptr<Model>>& models, Shader* shader, unsigned int passIndex,
+                          DepthOrder depthOrder, bool bindTextures)
+{
+    CPU_PROFILE_SCOPE("RenderQueue::collect");
+    uint32_t shaderSlot = get_slot(shaderSlots, shader->get_programID());
+
+    for (const auto& model : models) {
+        const auto& meshes = model->get_meshes();
+        // 先用整个模型的包围体粗测，整体在外时跳过所有网格
+        if (cullingEnabled && meshes.size() > 1 &&
+            (!frustum.intersects(model->get_worldSphere()) || !frustum.intersects(model->get_worldBounds()))) {
+            for (Mesh* mesh : meshes) {
+                if (mesh->get_visibility()) culledCount++;
+            }
+            continue;
+        }
+
+        for (Mesh* mesh : meshes) {
+            if (!mesh->get_visibility()) continue;
+            // 包围球测试更快，通过后再用包围盒确认
+            if (cullingEnabled &&
+                (!frustum.intersects(mesh->get_worldSphere()) || !frustum.intersects(mesh->get_worldBounds()))) {
+                culledCount++;
+                continue;
+            }
+            if (is_occluded(mesh)) {
+                culledCount++;
+                continue;
+            }
+            push(mesh, shader, shaderSlot, passIndex, depthOrder, bindTextures);
+        }
+    }
+}
+
+void RenderQueue::collect(const std::vector<Mesh*>& meshes, Shader* shader, unsigned int passIndex,
+                          DepthOrder depthOrder, bool bindTextures)
+{
+    CPU_PROFILE_SCOPE("RenderQueue::collect");
+    uint32_t shaderSlot = get_slot(shaderSlots, shader->get_programID());
+    for (Mesh* mesh : meshes) {
+        if (is_occluded(mesh)) {
+            culledCount++;
+            continue;
+        }
+        push(mesh, shader, shaderSlot, passIndex, depthOrder, bindTextures);
+    }
+}
+
+void RenderQueue::collect(const SceneBVH& bvh, const Frustum& frustum, Shader* shader, unsigned int passIndex,
+                          DepthOrder depthOrder, bool bindTextures)
+{
+    // 层次遍历代替逐网格测试
+    bvhMeshes.clear();
+    bvh.query(frustum, bvhMeshes);
+    collect(bvhMeshes, shader, passIndex, depthOrder, bindTextures);
+    // 与逐网格路径一致，只统计被视锥拒绝的可见网格
+    culledCount += bvh.get_visiblePrimitiveCount() - static_cast<int>(bvhMeshes.size());
+}
+
+bool RenderQueue::is_occluded(Mesh* mesh) const
+{
+    return occlusion && !mesh->is_occluder() && !occlusion->is_visible(mesh->get_worldBounds());
+}
+
+void RenderQueue::push(Mesh* mesh, Shader* shader, uint32_t shaderSlot, unsigned int passIndex, DepthOrder depthOrder, bool bindTextures)
+{
+    const uint64_t depthMax = (1ull << DEPTH_BITS) - 1;
+
+    DrawItem item;
+    item.mesh = mesh;
+    item.shader = shader;
+    item.texture = bindTextures ? mesh->get_texture() : nullptr;
+    item.vertexArray = mesh->get_vertexArray()->get_id();
+
+    uint64_t depth = 0;
+    if (depthOrder != DepthOrder::None) {
+        float distance = glm::length(mesh->get_position() - viewPosition) / maxDistance;
+        depth = (uint64_t)(std::min(std::max(distance, 0.0f), 1.0f) * depthMax);
+        if (depthOrder == DepthOrder::BackToFront) depth = depthMax - depth;
+    }
+    // 材质槽 0 表示不绑定材质
+    uint32_t materialSlot = item.texture ? get_slot(materialSlots, item.texture->get_imageHash()) + 1 : 0;
+
+    item.key = field(passIndex, PASS_BITS, PASS_SHIFT)
+             | field(shaderSlot, SHADER_BITS, SHADER_SHIFT)
+             | field(materialSlot, MATERIAL_BITS, MATERIAL_SHIFT)
+             | field(item.vertexArray, VAO_BITS, VAO_SHIFT)
+             | field(depth, DEPTH_BITS, DEPTH_SHIFT);
+    items.push_back(item);
+}
+
+void RenderQueue::sort()
+{
+    CPU_PROFILE_SCOPE("RenderQueue::sort");
+    radixSort();
+}
+
+void RenderQueue::submit()
+{
+    CPU_PROFILE_SCOPE("RenderQueue::submit");
+    Shader* currentShader = nullptr;
+    Texture* currentTexture = nullptr;
+    unsigned int currentVertexArray = 0;
+
+    for (auto& item : items) {
+        if (item.shader != currentShader) {
+            item.shader->bind();
+            currentShader = item.shader;
+            currentTexture = nullptr;   // 采样器 uniform 属于程序对象，换程序后需要重新设置
+        }
+        if (item.texture && !(currentTexture && item.texture->has_same_images(*currentTexture))) {
+            item.texture->bind(item.shader);
+            currentTexture = item.texture;
+        }
+        if (item.vertexArray != currentVertexArray) {
+            item.mesh->get_vertexArray()->bind();
+            currentVertexArray = item.vertexArray;
+        }
+
+        glm::mat4 modelMatrix = item.mesh->getModelMatrix();
+        item.shader->setUniform4fv("modelMatrix", modelMatrix);
+        item.mesh->drawElements();
+    }
+
+    if (currentVertexArray != 0) {
+        items.back().mesh->get_vertexArray()->unbind();
+    }
+}
+
+void RenderQueue::submitMultiDraw(bool positionOnly)
+{
+    CPU_PROFILE_SCOPE("RenderQueue::submitMultiDraw");
+    if (items.empty()) return;
+
+    // 先登记所有网格再同步，保证下面取到的范围有效
+    GeometryPool& pool = GeometryPool::getInstance();
+    for (const auto& item : items) {
+        pool.acquire(item.mesh);
+    }
+    pool.sync();
+
+    commands.clear();
+    drawData.clear();
+    batches.clear();
+    uint64_t triangles = 0;
+    for (const auto& item : items) {
+        // 所有网格共用一个 VAO，只在着色器或材质变化时分批
+        bool sameMaterial = batches.empty() ? false :
+            (item.texture == batches.back().texture ||
+             (item.texture && batches.back().texture && item.texture->has_same_images(*batches.back().texture)));
+        if (batches.empty() || item.shader != batches.back().shader || !sameMaterial) {
+            batches.push_back({item.shader, item.texture, static_cast<int>(commands.size()), 0});
+        }
+        const GeometryPool::Range& range = pool.get_range(item.mesh);
+        GLuint drawIndex = static_cast<GLuint>(drawData.size());
+        commands.push_back({range.indexCount, 1, range.firstIndex, range.baseVertex, drawIndex});
+        uint32_t materialSlot = static_cast<uint32_t>((item.key >> MATERIAL_SHIFT) & ((1ull << MATERIAL_BITS) - 1));
+        drawData.push_back({item.mesh->getModelMatrix(), glm::uvec4(materialSlot, 0, 0, 0)});
+        batches.back().count++;
+        triangles += range.indexCount / 3;
+    }
+
+    if (!indirectBuffer) indirectBuffer = std::make_unique<IndirectBuffer>();
+    indirectBuffer->updateData(commands);
+    if (!drawDataSSBO) {
+        drawDataSSBO = std::make_unique<SSBO<InstanceData>>(InstancedModel::INSTANCE_BINDING, static_cast<unsigned int>(std::max<size_t>(drawData.size(), 64)));
+    }
+    drawDataSSBO->reserve(drawData.size());
+    drawDataSSBO->updateData(drawData);
+    drawDataSSBO->bindBase();
+
+    if (positionOnly) pool.bindPositions(); else pool.bind();
+    indirectBuffer->bind();
+    Shader* currentShader = nullptr;
+    for (const auto& batch : batches) {
+        if (batch.shader != currentShader) {
+            if (currentShader) currentShader->setUniform1i("multiDraw", 0);
+            batch.shader->bind();
+            batch.shader->setUniform1i("multiDraw", 1);
+            currentShader = batch.shader;
+        }
+        if (batch.texture) batch.texture->bind(batch.shader);
+        // gl_DrawID 在每次多重绘制调用内从 0 开始，加上批次偏移才是逐绘制数据的下标
+        batch.shader->setUniform1i("drawOffset", batch.first);
+        gl::multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                      (const void*)(batch.first * sizeof(DrawElementsIndirectCommand)), batch.count, 0);
+    }
+    GL_COUNT(Triangles, triangles);
+    currentShader->setUniform1i("multiDraw", 0);
+    indirectBuffer->unbind();
+    if (positionOnly) pool.unbindPositions(); else pool.unbind();
+}
+
+uint32_t RenderQueue::get_slot(std::unordered_map<size_t, uint32_t>& slots, size_t id)
+{
+    auto it = slots.find(id);
+    if (it != slots.end()) return it->second;
+    uint32_t slot = static_cast<uint32_t>(slots.size());
+    slots.emplace(id, slot);
+    return slot;
+}
+
+// LSD 基数排序，每轮 8 位；某一字节所有键都相同时跳过该轮
+void RenderQueue::radixSort()
+{
+    const size_t count = items.size();
+    if (count < 2) return;
+
+    size_t histograms[8][256] = {};
+    for (const auto& item : items) {
+        for (int byte = 0; byte < 8; ++byte) {
+            histograms[byte][(item.key >> (byte * 8)) & 0xFF]++;
+        }
+    }
+
+    scratch.resize(count);
+    for (int byte = 0; byte < 8; ++byte) {
+        size_t* histogram = histograms[byte];
+        if (histogram[(items[0].key >> (byte * 8)) & 0xFF] == count) continue;
+
+        size_t offset = 0;
+        for (int bucket = 0; bucket < 256; ++bucket) {
+            size_t n = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += n;
+        }
+        for (const auto& item : items) {
+            scratch[histogram[(item.key >> (byte * 8)) & 0xFF]++] = item;
+        }
+        items.swap(scratch);
+    }
+}
@@ -4,21 +4,268 @@
 #include "Camera.h"
 #include "Light.h"
 #include "Model.h"
+#include "InstancedModel.h"
 #include "GlobalSettings.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include <chrono>
+#include <cfloat>
+#include <cstring>
 
-void checkGLError(const char* file, int line) {
-    GLenum error = glGetError();
-    if (error != GL_NO_ERROR) {
-        std::cerr << "OpenGL error at " << file << ":" << line << " - " << error << std::endl;
+void drawModels(RenderQueue& queue, std::vector<std::shared_ptr<Model>>& models, Shader* shader,
+                const char* passName, const Frustum* frustum, bool depthOnly, bool occlusionQueries)
+{
+    Renderer& renderer = Renderer::getInstance();
+    if (!renderer.is_frustumCullingEnabled()) frustum = nullptr;
+    // 软件遮挡缓冲是从摄像机视角光栅化的，只用于摄像机通道
+    bool cameraPass = frustum && frustum == renderer.get_cameraFrustum();
+    const SoftwareOcclusion* occlusion = cameraPass ? renderer.get_activeSoftwareOcclusion() : nullptr;
+    // 硬件遮挡查询同样只用于摄像机的几何通道：上一帧可见的模型照常走下面的流程，其余的最后条件渲染
+    OcclusionQueries* queries = cameraPass && !depthOnly && occlusionQueries ? renderer.get_activeOcclusionQueries() : nullptr;
+    std::vector<std::shared_ptr<Model>>* drawList = &models;
+    int queryCulled = 0;
+    if (queries) {
+        queries->classify(models, frustum);
+        drawList = &queries->get_visibleModels();
+        // 条件渲染的模型是否被光栅化只有 GPU 知道，统计中按上一帧的结果计为剔除
+        queryCulled = queries->get_frustumCulledMeshCount() + queries->get_hiddenMeshCount();
+    }
+
+    if (!renderer.is_renderQueueEnabled()) {
+        // 不经过队列时只按模型整体剔除
+        int drawn = 0;
+        int culled = queryCulled;
+        for (auto& model : *drawList) {
+            int meshCount = static_cast<int>(model->get_meshes().size());
+            bool hasOccluder = std::any_of(model->get_meshes().begin(), model->get_meshes().end(), [](Mesh* mesh) { return mesh->is_occluder(); });
+            if ((frustum && !frustum->intersects(model->get_worldBounds())) ||
+                (occlusion && !hasOccluder && !occlusion->is_visible(model->get_worldBounds()))) {
+                culled += meshCount;
+                continue;
+            }
+            model->draw(shader);
+            drawn += meshCount;
+        }
+        if (queries) queries->issue(shader);
+        renderer.add_cullingStats(passName, drawn, culled);
+        return;
+    }
+
+    queue.clear();
+    Camera* camera = renderer.get_camera();
+    if (camera) {
+        queue.set_view(camera->getCameraPosition(), camera->getFarPlane());
+    }
+    RenderQueue::DepthOrder depthOrder = depthOnly ? RenderQueue::DepthOrder::None : RenderQueue::DepthOrder::FrontToBack;
+    queue.set_occlusion(occlusion);
+    // 遮挡查询只留下部分模型时 drawList 不是场景列表，没有对应的 BVH，退回逐网格测试
+    SceneBVH* bvh = frustum ? renderer.get_sceneBVH(*drawList) : nullptr;
+    if (bvh) {
+        queue.set_frustum(nullptr);
+        queue.collect(*bvh, *frustum, shader, 0, depthOrder, !depthOnly);
+    } else {
+        queue.set_frustum(frustum);
+        queue.collect(*drawList, shader, 0, depthOrder, !depthOnly);
+    }
+    queue.add_culledCount(queryCulled);
+    queue.sort();
+    if (renderer.is_multiDrawEnabled()) {
+        // 只写深度的通道只需要位置，从共享几何缓冲的位置流提交
+        queue.submitMultiDraw(depthOnly);
+    } else {
+        queue.submit();
+    }
+    if (queries) queries->issue(shader);
+    renderer.add_cullingStats(passName, static_cast<int>(queue.size()), queue.get_culledCount());
+    if (depthOnly) return;
+
+    // 轮廓需要模板测试，不参与排序，放在最后单独绘制
+    for (auto& model : models) {
+        if (frustum && !frustum->intersects(model->get_worldBounds())) continue;
+        model->draw_outline();
     }
 }
 
+void drawInstancedModels(std::vector<std::shared_ptr<InstancedModel>>& instancedModels, Shader* shader,
+                         const char* passName, const Frustum* frustum, bool depthOnly)
+{
+    if (instancedModels.empty()) return;
+    Renderer& renderer = Renderer::getInstance();
+    if (!renderer.is_frustumCullingEnabled()) frustum = nullptr;
 
-void SkyboxPass::execute()
+    int drawn = 0;
+    int culled = 0;
+    for (auto& instancedModel : instancedModels) {
+        int modelCulled = 0;
+        drawn += instancedModel->draw(shader, frustum, depthOnly, modelCulled);
+        culled += modelCulled;
+    }
+    renderer.add_cullingStats(passName, drawn, culled);
+}
+
+SceneBVH* Renderer::get_sceneBVH(const std::vector<std::shared_ptr<Model>>& models)
 {
-    if(ifDeferred){
-        Renderer::getInstance().get_DeferedFramebufferForPass()->switch_depth_component_to_default(); // 将深度缓冲切换到默认帧缓冲
+    if (!sceneBVHEnabled) return nullptr;
+    for (auto& [rt, modelList] : renderType_model_map) {
+        if (&modelList != &models) continue;
+        SceneBVH& bvh = renderType_bvh_map[rt];
+        bvh.update(modelList);
+        return &bvh;
     }
+    return nullptr;
+}
+
+bool Renderer::pick(float ndcX, float ndcY, SceneBVH::RayHit& hit)
+{
+    if (!camera) return false;
+
+    // 把近、远平面上的点反投影回世界空间得到射线
+    glm::mat4 invViewProjection = glm::inverse(camera->getViewProjectionMatrix());
+    glm::vec4 nearPoint = invViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+    glm::vec4 farPoint = invViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+    glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+    glm::vec3 direction = glm::vec3(farPoint) / farPoint.w - origin;
+
+    bool found = false;
+    float maxDistance = 1.0f;   // direction 为近平面到远平面的长度，t 在 [0, 1] 内
+    for (auto& [rt, modelList] : renderType_model_map) {
+        SceneBVH& bvh = renderType_bvh_map[rt];
+        bvh.update(modelList);
+        SceneBVH::RayHit candidate;
+        if (bvh.raycast(origin, direction, maxDistance, candidate)) {
+            hit = candidate;
+            maxDistance = candidate.distance;
+            found = true;
+        }
+    }
+    return found;
+}
+
+void Renderer::add_cullingStats(const char* name, int drawn, int culled)
+{
+    for (auto& stats : cullingStats) {
+        if (std::strcmp(stats.name, name) == 0) {
+            stats.drawn += drawn;
+            stats.culled += culled;
+            return;
+        }
+    }
+    cullingStats.push_back({name, drawn, culled});
+}
+
+bool SoftwareOcclusionPass::is_enabled() const
+{
+    return Renderer::getInstance().get_activeSoftwareOcclusion() != nullptr;
+}
+
+void SoftwareOcclusionPass::declare(RenderGraph::PassBuilder& builder)
+{
+    builder.write(RenderResource::OccluderDepth);
+}
+
+void SoftwareOcclusionPass::execute()
+{
+    Renderer& renderer = Renderer::getInstance();
+    occlusion.render(renderer.get_camera()->getViewProjectionMatrix(), models);
+}
+
+bool GpuCullingPass::is_enabled() const
+{
+    return Renderer::getInstance().is_gpuCullingEnabled();
+}
+
+void GpuCullingPass::declare(RenderGraph::PassBuilder& builder)
+{
+    builder.write(RenderResource::CullCommands);
+}
+
+void GpuCullingPass::execute()
+{
+    gpuCulling.update(models);
+    // 开启遮挡剔除时这里只选出上一帧可见的网格，其余的在几何通道中对照 Hi-Z 测试
+    gpuCulling.cull(nullptr, Renderer::getInstance().is_occlusionCullingEnabled() ? GpuCulling::Phase::Visible : GpuCulling::Phase::Single);
+}
+
+bool LightCullingPass::is_enabled() const
+{
+    Renderer& renderer = Renderer::getInstance();
+    return renderer.is_clusteredLightingEnabled() && renderer.get_camera() && light && light->get_lightCount() > 0;
+}
+
+void LightCullingPass::declare(RenderGraph::PassBuilder& builder)
+{
+    builder.write(RenderResource::Clusters);
+}
+
+void LightCullingPass::execute()
+{
+    Renderer& renderer = Renderer::getInstance();
+    clusteredLighting.cull(*renderer.get_camera(), *light);
+}
+
+// 几何通道的 GPU 剔除路径：视锥剔除已在 GpuCullingPass 中完成，这里只提交，轮廓仍在 CPU 端按模型剔除。
+// 开启遮挡剔除时先画上一帧可见的网格和实例化模型，用 sceneDepth 的深度纹理构建 Hi-Z 后再剔除、补画其余网格。
+// depthOnly 用于深度预渲染（不绑定材质、不画轮廓）
+static void drawModelsGpuCulled(std::vector<std::shared_ptr<Model>>& models, std::vector<std::shared_ptr<InstancedModel>>& instancedModels,
+                                Shader* shader, const char* passName, const Framebuffer& sceneDepth, bool depthOnly = false)
+{
+    Renderer& renderer = Renderer::getInstance();
+    GpuCulling& gpuCulling = renderer.get_gpuCulling();
+    if (!renderer.is_occlusionCullingEnabled()) {
+        gpuCulling.draw(shader, depthOnly);
+        drawInstancedModels(instancedModels, shader, passName, renderer.get_cameraFrustum(), depthOnly);
+    } else {
+        gpuCulling.draw(shader, depthOnly, GpuCulling::Phase::Visible);
+        drawInstancedModels(instancedModels, shader, passName, renderer.get_cameraFrustum(), depthOnly);
+        {
+            GpuProfileScope gpuZone("HiZ");
+            HiZBuffer& hiZ = renderer.get_hiZBuffer();
+            hiZ.resize(sceneDepth.get_width(), sceneDepth.get_height());
+            hiZ.build(sceneDepth.get_depthTexture());
+            gpuCulling.cull(nullptr, GpuCulling::Phase::Occlusion, &hiZ);
+        }
+        gpuCulling.draw(shader, depthOnly, GpuCulling::Phase::Occlusion);
+    }
+    if (depthOnly) return;
+    const Frustum* frustum = renderer.get_cameraFrustum();
+    for (auto& model : models) {
+        if (frustum && !frustum->intersects(model->get_worldBounds())) continue;
+        model->draw_outline();
+    }
+}
+
+// 深度预渲染之后的 GPU 剔除路径：剔除（包括遮挡剔除的两个阶段）已在预渲染中完成，直接重新提交两段命令
+static void redrawModelsGpuCulled(std::vector<std::shared_ptr<Model>>& models, std::vector<std::shared_ptr<InstancedModel>>& instancedModels,
+                                  Shader* shader, const char* passName)
+{
+    Renderer& renderer = Renderer::getInstance();
+    GpuCulling& gpuCulling = renderer.get_gpuCulling();
+    if (!renderer.is_occlusionCullingEnabled()) {
+        gpuCulling.draw(shader);
+    } else {
+        gpuCulling.draw(shader, false, GpuCulling::Phase::Visible);
+        gpuCulling.draw(shader, false, GpuCulling::Phase::Occlusion);
+    }
+    drawInstancedModels(instancedModels, shader, passName, renderer.get_cameraFrustum());
+    const Frustum* frustum = renderer.get_cameraFrustum();
+    for (auto& model : models) {
+        if (frustum && !frustum->intersects(model->get_worldBounds())) continue;
+        model->draw_outline();
+    }
+}
+
+void SkyboxPass::declare(RenderGraph::PassBuilder& builder)
+{
+    if (ifDeferred) builder.read(RenderResource::SceneDepth);   // 挂在场景缓冲上做深度测试
+    builder.read(RenderResource::SceneColor);
+    builder.write(RenderResource::SceneColor);
+}
+
+void SkyboxPass::execute()
+{
+    // 延迟路径下场景缓冲挂着 SceneDepth，直接深度测试
+    Renderer& renderer = Renderer::getInstance();
+    renderer.bind_sceneTarget();
     // glDepthMask(GL_FALSE);
     shader->bind();
     texture->bind(shader.get(), TextureType::Cubemap, 0);  // 传入 Shader 指针
@@ -26,8 +273,19 @@ void SkyboxPass::execute()
     // glDepthMask(GL_TRUE);
 }
 
+void OpaquePass::declare(RenderGraph::PassBuilder& builder)
+{
+    builder.read(RenderResource::ShadowMaps);
+    builder.write(RenderResource::SceneColor);
+}
+
 void OpaquePass::execute()
 {
+    // 前向路径：场景缓冲使用自己的深度
+    Renderer& renderer = Renderer::getInstance();
+    renderer.get_sceneFramebuffer()->share_depth(nullptr);
+    renderer.bind_sceneTarget();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     shader->bind();
     shader->setUniform1i("debugMode", Renderer::getInstance().get_debugMode()); // 使用全局调试模式
     // 绑定光照信息
@@ -36,125 +294,236 @@ void OpaquePass::execute()
         light->bind_shadow(shader.get()); // 绑定阴影贴图
     }
 
-    for (auto& model : models) {
-        model->draw(shader.get());
-    }
+    drawModels(queue, models, shader.get(), get_name(), Renderer::getInstance().get_cameraFrustum());
+}
+
+// 按窗口大小从帧缓冲池申请的缓冲描述（动态分辨率只使用其中的渲染区域）
+static FramebufferPool::Desc windowSizedDesc(const std::vector<Framebuffer::AttachmentConfig>& attachments, bool useDepth = false, bool depthTexture = false)
+{
+    FramebufferPool::Desc desc;
+    desc.width = Renderer::getInstance().get_windowWidth();
+    desc.height = Renderer::getInstance().get_windowHeight();
+    desc.attachments = attachments;
+    desc.useDepth = useDepth;
+    desc.depthTexture = depthTexture;
+    return desc;
+}
+
+// 延迟路径的场景深度：只有深度纹理，G-Buffer 阶段挂到 G-Buffer 上写入，之后挂到场景缓冲上
+static FramebufferPool::Desc sceneDepthDesc()
+{
+    return windowSizedDesc({}, true, true);
+}
+
+// SSAO 的输出（r 为遮蔽因子），G-Buffer 的 SSAO 阶段写入、光照阶段读取后归还
+static FramebufferPool::Desc ssaoTargetDesc()
+{
+    return windowSizedDesc({ {GL_RED, GL_RGB, GL_FLOAT} });
+}
+
+void OpaqueDeferredPass::declare(RenderGraph::PassBuilder& builder)
+{
+    builder.read(RenderResource::ShadowMaps);
+    builder.read(RenderResource::CullCommands);
+    // 深度单独作为 SceneDepth：遮挡剔除从中构建 Hi-Z，场景缓冲之后继续使用它，G-Buffer 的颜色附件光照之后即可归还
+    builder.create(RenderResource::GBuffer, windowSizedDesc({
+        {GL_RGBA16F, GL_RGBA, GL_FLOAT},
+        {GL_RGB16F, GL_RGB, GL_FLOAT},
+        {GL_RGBA16F, GL_RGBA, GL_FLOAT}
+    }));
+    builder.create(RenderResource::SceneDepth, sceneDepthDesc());
+    builder.write(RenderResource::SceneColor);
 }
 
 void OpaqueDeferredPass::execute()
 {
+    FramebufferPool& pool = Renderer::getInstance().get_framebufferPool();
+    deferredFramebuffer = Renderer::getInstance().get_renderGraph().get_framebuffer(RenderResource::GBuffer);
+    Framebuffer* sceneDepth = Renderer::getInstance().get_renderGraph().get_framebuffer(RenderResource::SceneDepth);
+    deferredFramebuffer->share_depth(sceneDepth);
+
     // G-Buffer 阶段
-    deferred_g_shader->bind();
-    deferredFramebuffer->bind(); // 绑定帧缓冲
-    glClearBufferfv(GL_COLOR, 0, glm::value_ptr(glm::vec4(0.0f))); // gPosition
-    glClearBufferfv(GL_COLOR, 1, glm::value_ptr(glm::vec3(0.0f))); // gNormal
-    glClearBufferfv(GL_COLOR, 2, glm::value_ptr(glm::vec4(0.0f))); // gAlbedoSpec
-    glClear(GL_DEPTH_BUFFER_BIT);
-    for(auto model : models){
-        model->draw(deferred_g_shader.get());
+    {
+        GpuProfileScope gpuZone("GBuffer");
+        deferred_g_shader->bind();
+        deferredFramebuffer->bind(); // 绑定帧缓冲
+        glViewport(0, 0, Renderer::getInstance().get_renderWidth(), Renderer::getInstance().get_renderHeight());
+        glClearBufferfv(GL_COLOR, 0, glm::value_ptr(glm::vec4(0.0f))); // gPosition
+        glClearBufferfv(GL_COLOR, 1, glm::value_ptr(glm::vec3(0.0f))); // gNormal
+        glClearBufferfv(GL_COLOR, 2, glm::value_ptr(glm::vec4(0.0f))); // gAlbedoSpec
+        glClear(GL_DEPTH_BUFFER_BIT);
+        if (Renderer::getInstance().is_gpuCullingEnabled()) {
+            drawModelsGpuCulled(models, instancedModels, deferred_g_shader.get(), get_name(), *sceneDepth);
+        } else {
+            drawModels(queue, models, deferred_g_shader.get(), get_name(), Renderer::getInstance().get_cameraFrustum());
+            drawInstancedModels(instancedModels, deferred_g_shader.get(), get_name(), Renderer::getInstance().get_cameraFrustum());
+        }
+        deferredFramebuffer->unbind(); // 解绑帧缓冲
     }
-    deferredFramebuffer->unbind(); // 解绑帧缓冲
 
     // SSAO 阶段
-    ssaoFrameBuffer->bind(); // 绑定 SSAO 帧缓冲
-    glClear(GL_COLOR_BUFFER_BIT); // 清除颜色缓存
-    ssao_shader->bind();
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, deferredFramebuffer->get_texture(0));
-    ssao_shader->setUniform1i("gPosition", 0);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, deferredFramebuffer->get_texture(1));
-    ssao_shader->setUniform1i("gNormal", 1);
-    noiseTexture->bind(ssao_shader.get(), TextureType::Noise, 2); // 绑定噪声纹理
-    ssao_shader->setUniform3fv("samples", ssaoKernel.size(), glm::value_ptr(ssaoKernel[0])); // 传入 SSAO 内核
-    ssao_shader->setUniform1f("ssaoStrengh", Renderer::getInstance().ssaoStrength); // 设置 SSAO 强度
-    dummy_screen->draw();   // 利用屏幕四边形绘制结果
-    ssaoFrameBuffer->unbind(); // 解绑 SSAO 帧缓冲
+    Framebuffer* ssaoFrameBuffer = pool.acquire(ssaoTargetDesc());
+    {
+        GpuProfileScope gpuZone("SSAO");
+        AmbientOcclusion::GBufferInputs gBuffer;
+        gBuffer.position = deferredFramebuffer->get_texture(0);
+        gBuffer.normal = deferredFramebuffer->get_texture(1);
+        gBuffer.width = Renderer::getInstance().get_renderWidth();
+        gBuffer.height = Renderer::getInstance().get_renderHeight();
+        if (Camera* camera = Renderer::getInstance().get_camera()) {
+            gBuffer.previousViewProjection = camera->getPreviousViewProjectionMatrix();
+            gBuffer.previousViewPosition = camera->getPreviousCameraPosition();
+        }
+        Renderer::getInstance().get_ambientOcclusion().compute(ssao_shader.get(), gBuffer, *ssaoFrameBuffer, *dummy_screen, Renderer::getInstance().ssaoStrength);
+    }
 
     // 光照阶段
+    GpuProfileScope gpuZone("Lighting");
     deferred_l_shader->bind();
     deferred_l_shader->setUniform1i("debugMode", Renderer::getInstance().get_debugMode()); // 使用全局调试模式
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, deferredFramebuffer->get_texture(0));
+    gl::bindTexture(GL_TEXTURE_2D, deferredFramebuffer->get_texture(0));
     deferred_l_shader->setUniform1i("gPosition", 0);
     glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, deferredFramebuffer->get_texture(1));
+    gl::bindTexture(GL_TEXTURE_2D, deferredFramebuffer->get_texture(1));
     deferred_l_shader->setUniform1i("gNormal", 1);
     glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, deferredFramebuffer->get_texture(2));
+    gl::bindTexture(GL_TEXTURE_2D, deferredFramebuffer->get_texture(2));
     deferred_l_shader->setUniform1i("gAlbedoSpec", 2);
     glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, ssaoFrameBuffer->get_texture(0)); // 绑定 SSAO 结果
+    gl::bindTexture(GL_TEXTURE_2D, ssaoFrameBuffer->get_texture(0)); // 绑定 SSAO 结果
     deferred_l_shader->setUniform1i("ssao", 3);
 
-    glClear(GL_DEPTH_BUFFER_BIT); // 清除深度缓存
     if(light){
         light->set_sUniform_light(deferred_l_shader.get());
         light->bind_shadow(deferred_l_shader.get()); // 绑定阴影贴图
     }
+    // 场景缓冲挂上场景深度，之后的通道直接深度测试；屏幕四边形不测试也不写深度
+    Renderer::getInstance().get_sceneFramebuffer()->share_depth(sceneDepth);
+    Renderer::getInstance().bind_sceneTarget();
+    glDisable(GL_DEPTH_TEST);
     dummy_screen->draw();   // 利用屏幕四边形绘制结果
+    glEnable(GL_DEPTH_TEST);
+    // G-Buffer 本通道结束后归还，先摘掉借来的深度
+    deferredFramebuffer->share_depth(nullptr);
+    pool.release(ssaoFrameBuffer);
+}
+
+void LightPass::declare(RenderGraph::PassBuilder& builder)
+{
+    if (ifDeferred) builder.read(RenderResource::SceneDepth);
+    builder.read(RenderResource::SceneColor);
+    builder.write(RenderResource::SceneColor);
 }
 
 void LightPass::execute()
 {
-    if(ifDeferred){
-        Renderer::getInstance().get_DeferedFramebufferForPass()->switch_depth_component_to_default(); // 将深度缓冲切换到默认帧缓冲
-    }
+    // 延迟路径下场景缓冲挂着 SceneDepth，灯光图标直接深度测试
+    Renderer::getInstance().bind_sceneTarget();
     for (auto light : lights) {
         shader->bind();
         light->draw(shader.get());
     }
 }
 
+bool TransparentPass::is_enabled() const
+{
+    return !models.empty() || !instancedModels.empty();
+}
+
+void TransparentPass::declare(RenderGraph::PassBuilder& builder)
+{
+    builder.read(RenderResource::Clusters);
+    builder.read(RenderResource::SceneDepth);  // 与不透明物体的深度比较
+    builder.read(RenderResource::SceneColor);
+    builder.write(RenderResource::SceneColor);
+}
+
 void TransparentPass::execute()
 {
+
+    // 累积缓冲只在本通道内使用
+    FramebufferPool& pool = Renderer::getInstance().get_framebufferPool();
+    Framebuffer* oitFramebuffer = pool.acquire(windowSizedDesc({
+        {GL_RGBA16F, GL_RGBA, GL_FLOAT},
+        {GL_R16F, GL_RED, GL_FLOAT}
+    }));
+
+    // 累积缓冲挂上场景深度：被不透明物体挡住的透明片段不参与累积（前向路径没有 SceneDepth，不做深度测试）
+    Renderer& renderer = Renderer::getInstance();
+    oitFramebuffer->share_depth(renderer.get_renderGraph().get_framebuffer(RenderResource::SceneDepth));
+
     // 计算透明物体的颜色和透明度累积值
     glEnable(GL_BLEND);  // 启用混合
     glBlendFunc(GL_ONE, GL_ONE);  // 计算累积值，所以混合改为简单的相加模式
     oitFramebuffer->bind(); 
     glClear(GL_COLOR_BUFFER_BIT);
-    glDepthMask(GL_FALSE);  // 禁用深度测试
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_FALSE);  // 只测试不写入深度
     accumShader->bind();
-    for(auto model : models){
-        model->draw(accumShader.get());
-    }
+    // 前向光照：分簇结果由 LightCullingPass 在本帧生成，条件与其一致
+    int lightCount = light ? light->get_lightCount() : 0;
+    bool clustered = lightCount > 0 && renderer.is_clusteredLightingEnabled() && renderer.get_camera();
+    if (lightCount > 0) light->lightsSSBO->bindBase();
+    if (clustered) renderer.get_clusteredLighting().bind(accumShader.get());
+    accumShader->setUniform1i("numLights", lightCount);
+    accumShader->setUniform1i("clustered", clustered ? 1 : 0);
+    accumShader->setUniform2f("screenSize", static_cast<float>(renderer.get_renderWidth()), static_cast<float>(renderer.get_renderHeight()));
+    drawModels(queue, models, accumShader.get(), get_name(), renderer.get_cameraFrustum(), false, false);
+    drawInstancedModels(instancedModels, accumShader.get(), get_name(), renderer.get_cameraFrustum());
     glDepthMask(GL_TRUE);
-    oitFramebuffer->unbind();
+    renderer.bind_sceneTarget();
 
     // 接着将上面的累积结果绘制到屏幕四边形当中
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);  // 改回正常 Alpha 混合
     drawShader->bind();
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, oitFramebuffer->get_texture(0));
+    gl::bindTexture(GL_TEXTURE_2D, oitFramebuffer->get_texture(0));
     drawShader->setUniform1i("accum_texture", 0);
     glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, oitFramebuffer->get_texture(1));
+    gl::bindTexture(GL_TEXTURE_2D, oitFramebuffer->get_texture(1));
     drawShader->setUniform1i("alpha_texture", 1);
+    glDisable(GL_DEPTH_TEST);   // 合成覆盖整个屏幕，不和场景深度比较
     dummy_screen->draw();   // 利用屏幕四边形绘制结果
+    glEnable(GL_DEPTH_TEST);
 
     glDisable(GL_BLEND);   // 关闭混合
+    // 摘掉借来的深度再归还，池中的缓冲不引用其他资源
+    oitFramebuffer->share_depth(nullptr);
+    pool.release(oitFramebuffer);
+}
 
+void BakePass::declare(RenderGraph::PassBuilder& builder)
+{
+    builder.write(RenderResource::ShadowMaps);
 }
 
 void BakePass::execute()
 {
     // 烘焙阴影贴图
     for(auto light : lights){
-        light->bakeShadows(shadowMapShader_directionalLight.get(), shadowMapShader_pointLight.get(), models);
+        light->bakeShadows(shadowMapShader_directionalLight.get(), shadowMapShader_pointLight.get(), models, instancedModels);
     }
 }
 
+void ViewPass::declare(RenderGraph::PassBuilder& builder)
+{
+    builder.write(RenderResource::Backbuffer);
+}
+
 void ViewPass::execute()
 {
     view_texture_shader->bind();
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    gl::bindTexture(GL_TEXTURE_2D, textureID);
     view_texture_shader->setUniform1i("texture0", 0);
     dummyScreen->draw();
 }
 
 void Renderer::initialize()
 {
+    CPU_PROFILE_SCOPE("Renderer::initialize");
     resizeFBOIfNeeded(GlobalSettings::getInstance().GetInt("SCREEN_WIDTH"), GlobalSettings::getInstance().GetInt("SCREEN_HEIGHT"));
     // 初始化全局资源
     basicShader = std::make_shared<Shader>("res/shader/Basic.shader");
@@ -162,10 +531,11 @@ void Renderer::initialize()
     deferred_l_shader = std::make_shared<Shader>("res/shader/Deferred_L.shader");
     pbr_g_shader = std::make_shared<Shader>("res/shader/PBR_G.shader");
     pbr_l_shader = std::make_shared<Shader>("res/shader/PBR_L.shader");
+    depthPrepassShader = std::make_shared<Shader>("res/shader/Depth_prepass.shader");
 
     lightShader = std::make_shared<Shader>("res/shader/Light.shader");
 
-    skyBoxShader = std::make_shared<Shader>("res/shader/Skybox.shader");
+    skyBoxShader = std::make_shared<Shader>("res/shader/SkyBox.shader");
     skyBoxCubemap = std::make_shared<Texture>();
     skyBoxCubemap->add_hdri_to_cubemap("res/HDRI.hdr", 1024, true);
     dummyCube = std::make_shared<Mesh>();
@@ -180,6 +550,7 @@ void Renderer::initialize()
     ssao_shader = std::make_shared<Shader>("res/shader/SSAO.shader");
 
     view_texture_shader = std::make_shared<Shader>("res/shader/View_texture.shader");
+    compositeShader = std::make_shared<Shader>("res/shader/Composite.shader");
 
     dummyScreen = std::make_shared<Mesh>();
     dummyScreen->set_mesh_screen();
@@ -193,48 +564,133 @@ void Renderer::setupRenderPasses()
 {
     renderPasses.clear();
     // 注册渲染通道
-    // renderPasses.push_back(std::make_unique<BakePass>(shadowMapShader_directionalLight,shadowMapShader_pointLight, lights, renderType_model_map[RenderType::Basic]));
+    // renderPasses.push_back(std::make_unique<BakePass>(shadowMapShader_directionalLight,shadowMapShader_pointLight, lights, renderType_model_map[RenderType::Basic], renderType_instanced_map[RenderType::Basic]));
     // renderPasses.push_back(std::make_unique<OpaquePass>(basicShader, renderType_model_map[RenderType::Basic], renderType_light_map[RenderType::Basic]));
-    // renderPasses.push_back(std::make_unique<OpaqueDeferredPass>(deferred_g_shader, deferred_l_shader, ssao_shader, deferredFramebuffer, ssaoFrameBuffer, renderType_model_map[RenderType::Basic], renderType_light_map[RenderType::Basic], dummyScreen));
-    renderPasses.push_back(std::make_unique<PBRPass>(pbr_g_shader, pbr_l_shader, ssao_shader, pbrDeferredFramebuffer, ssaoFrameBuffer, skyBoxCubemap, renderType_model_map[RenderType::Basic], dummyScreen));
+    // renderPasses.push_back(std::make_unique<OpaqueDeferredPass>(deferred_g_shader, deferred_l_shader, ssao_shader, renderType_model_map[RenderType::Basic], renderType_instanced_map[RenderType::Basic], renderType_light_map[RenderType::Basic], dummyScreen));
+    renderPasses.push_back(std::make_unique<SoftwareOcclusionPass>(softwareOcclusion, renderType_model_map[RenderType::Basic]));
+    renderPasses.push_back(std::make_unique<GpuCullingPass>(gpuCulling, renderType_model_map[RenderType::Basic]));
+    renderPasses.push_back(std::make_unique<LightCullingPass>(clusteredLighting, renderType_light_map[RenderType::Basic]));
+    renderPasses.push_back(std::make_unique<PBRPass>(pbr_g_shader, pbr_l_shader, ssao_shader, depthPrepassShader, skyBoxCubemap, renderType_model_map[RenderType::Basic], renderType_instanced_map[RenderType::Basic], renderType_light_map[RenderType::Basic], dummyScreen));
     renderPasses.push_back(std::make_unique<SkyboxPass>(skyBoxShader, skyBoxCubemap, dummyCube, true));
+    // 透明物体在不透明物体和天空盒之后合成，与 PBR 共用 RenderType::Basic 的灯光
+    renderPasses.push_back(std::make_unique<TransparentPass>(transparentAccumShader, transparentDrawShader, renderType_model_map[RenderType::Transparent], renderType_instanced_map[RenderType::Transparent], renderType_light_map[RenderType::Basic], dummyScreen));
     // renderPasses.push_back(std::make_unique<LightPass>(lightShader, lights, true));
-    renderPasses.push_back(std::make_unique<ImGuiPass>()); // 添加 ImGui 渲染通道
-
+    renderPasses.push_back(std::make_unique<CompositePass>(compositeShader, dummyScreen));
+    if (!headless) {
+        renderPasses.push_back(std::make_unique<ImGuiPass>()); // 添加 ImGui 渲染通道
+    }
 
-    //renderPasses.push_back(std::make_unique<TransparentPass>(transparentAccumShader, transparentDrawShader, oitFramebuffer, renderType_model_map[RenderType::Transparent], dummyScreen));
 
     // renderPasses.push_back(std::make_unique<ViewPass>(view_texture_shader, brdfLUT->get_textureID(0), dummyScreen));
 }
 
-void Renderer::resizeFBOIfNeeded(int screenWidth, int screenHeight)
+void Renderer::renderAll()
 {
-    if (screenWidth != currentWidth || screenHeight != currentHeight) {
-        std::vector<Framebuffer::AttachmentConfig> attachments = {
-            {GL_RGBA16F, GL_RGBA, GL_FLOAT},
-            {GL_RGB16F, GL_RGB, GL_FLOAT},
-            {GL_RGBA16F, GL_RGBA, GL_FLOAT}
-        };
-        deferredFramebuffer = std::make_shared<Framebuffer>(screenWidth, screenHeight, attachments, true, false);
+    CPU_PROFILE_SCOPE("Renderer::renderAll");
+    GpuProfiler& gpuProfiler = GpuProfiler::getInstance();
+    gpuProfiler.beginFrame();
+    GLStats::getInstance().beginFrame();
+    cullingStats.clear();
+    if (camera) {
+        cameraFrustum = Frustum(camera->getViewProjectionMatrix());
+    }
+    // 本帧的渲染区域，整帧不变
+    float scale = dynamicResolutionEnabled ? dynamicResolution.get_scale() : 1.0f;
+    renderWidth = std::max(1, static_cast<int>(currentWidth * scale));
+    renderHeight = std::max(1, static_cast<int>(currentHeight * scale));
+    glViewport(0, 0, renderWidth, renderHeight);
+    // HDR 场景缓冲按窗口大小分配（动态分辨率只使用其中的渲染区域）；自己的深度只在前向路径使用，格式与 G-Buffer 相同
+    if (!sceneFramebuffer || sceneFramebuffer->get_width() != currentWidth || sceneFramebuffer->get_height() != currentHeight) {
+        sceneFramebuffer = std::make_unique<Framebuffer>(currentWidth, currentHeight,
+                                                         std::vector<Framebuffer::AttachmentConfig>{ {GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT} }, true, false);
+    }
 
-        attachments = {
-            {GL_RGBA16F, GL_RGBA, GL_FLOAT},
-            {GL_RGB16F, GL_RGB, GL_FLOAT},
-            {GL_RGB16F, GL_RGB, GL_FLOAT},
-            {GL_RGB16F, GL_RGB, GL_FLOAT}
-        };
-        pbrDeferredFramebuffer = std::make_shared<Framebuffer>(screenWidth, screenHeight, attachments, true, false);
+    // 按各通道本帧声明的资源编译执行顺序，关闭和无用的通道不执行
+    renderGraph.compile(renderPasses, RenderResource::Backbuffer);
+    const std::vector<RenderGraph::Step>& steps = renderGraph.get_steps();
+    passTimings.resize(steps.size());
 
-        attachments = {
-            {GL_RGBA16F, GL_RGBA, GL_FLOAT},
-            {GL_R16F, GL_RED, GL_FLOAT}
-        };
-        oitFramebuffer = std::make_shared<Framebuffer>(screenWidth, screenHeight, attachments, false, false);
+    for (size_t i = 0; i < steps.size(); ++i) {
+        RenderPass* pass = steps[i].pass;
+        renderGraph.beginStep(i, framebufferPool);
+        {
+            GpuProfileScope gpuZone(pass->get_name());
+            CPU_PROFILE_SCOPE(pass->get_name());
+
+            if (!passTimingEnabled) {
+                pass->execute();
+            } else {
+                auto start = std::chrono::high_resolution_clock::now();
+                pass->execute();
+                auto end = std::chrono::high_resolution_clock::now();
+
+                passTimings[i].name = pass->get_name();
+                passTimings[i].cpuMs = std::chrono::duration<double, std::milli>(end - start).count();
+            }
+        }
+        renderGraph.endStep(i, framebufferPool);
+    }
 
-        attachments = {
-            {GL_RED, GL_RGB, GL_FLOAT}
-        };
-        ssaoFrameBuffer = std::make_shared<Framebuffer>(screenWidth, screenHeight, attachments, false, false);
+    // 归还本帧持有的缓冲
+    framebufferPool.endFrame();
+
+    GLStats::getInstance().endFrame();
+    gpuProfiler.endFrame();
+    if (camera) camera->endFrame();
+
+    // GPU 耗时有几帧的回读延迟，每帧最多拿到一个新结果
+    unsigned long long gpuFrame = 0;
+    double gpuMs = 0.0;
+    if (dynamicResolutionEnabled && gpuProfiler.get_lastFrame(gpuFrame, gpuMs) && gpuFrame + 1 > dynamicResolutionSamples) {
+        dynamicResolutionSamples = gpuFrame + 1;
+        dynamicResolution.addSample(gpuFrame, gpuMs, gpuProfiler.get_frameIndex());
+    }
+}
+
+void Renderer::set_dynamicResolutionEnabled(bool enabled)
+{
+    if (dynamicResolutionEnabled == enabled) return;
+    dynamicResolutionEnabled = enabled;
+    dynamicResolution.reset();
+    if (enabled) GpuProfiler::getInstance().set_enabled(true);
+}
+
+void Renderer::bind_sceneTarget() const
+{
+    sceneFramebuffer->bind();
+    glViewport(0, 0, renderWidth, renderHeight);
+}
+
+void CompositePass::declare(RenderGraph::PassBuilder& builder)
+{
+    // 场景缓冲挂着 SceneDepth，读完场景颜色之前不能归还它
+    builder.read(RenderResource::SceneDepth);
+    builder.read(RenderResource::SceneColor);
+    builder.write(RenderResource::Backbuffer);
+}
+
+void CompositePass::execute()
+{
+    Renderer& renderer = Renderer::getInstance();
+    // 色调映射并写到窗口，动态分辨率下同时双线性放大渲染区域；之后的通道（ImGui）按窗口分辨率绘制
+    gl::bindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, renderer.get_windowWidth(), renderer.get_windowHeight());
+    shader->bind();
+    glActiveTexture(GL_TEXTURE0);
+    gl::bindTexture(GL_TEXTURE_2D, renderer.get_sceneFramebuffer()->get_texture(0));
+    shader->setUniform1i("sceneColor", 0);
+    glm::vec2 uvScale = renderer.get_renderUVScale();
+    shader->setUniform2f("uvScale", uvScale.x, uvScale.y);
+    glDisable(GL_DEPTH_TEST);   // 覆盖整个窗口
+    dummyScreen->draw();
+    glEnable(GL_DEPTH_TEST);
+}
+
+void Renderer::resizeFBOIfNeeded(int screenWidth, int screenHeight)
+{
+    if (screenWidth != currentWidth || screenHeight != currentHeight) {
+        // 渲染目标都在使用时按当前大小从帧缓冲池申请，这里只释放池中闲置的旧尺寸缓冲
+        framebufferPool.trim();
 
         // 更新当前宽高
         currentWidth = screenWidth;
@@ -242,6 +698,12 @@ void Renderer::resizeFBOIfNeeded(int screenWidth, int screenHeight)
     }
 }
 
+void ImGuiPass::declare(RenderGraph::PassBuilder& builder)
+{
+    builder.read(RenderResource::Backbuffer);
+    builder.write(RenderResource::Backbuffer);
+}
+
 void ImGuiPass::execute()
 {
     // 开始新一帧 ImGui
@@ -251,6 +713,104 @@ void ImGuiPass::execute()
 
     ImGui::Begin("Debug Window");
     ImGui::SliderFloat("SSAO strengh", &Renderer::getInstance().ssaoStrength, 0.0f, 5.0f);
+    AmbientOcclusion& ambientOcclusion = Renderer::getInstance().get_ambientOcclusion();
+    int ssaoDivisorIndex = ambientOcclusion.get_resolutionDivisor() == 4 ? 2 : ambientOcclusion.get_resolutionDivisor() - 1;
+    const char* ssaoResolutions[] = { "Full", "Half", "Quarter" };
+    if (ImGui::Combo("SSAO resolution", &ssaoDivisorIndex, ssaoResolutions, 3)) ambientOcclusion.set_resolutionDivisor(1 << ssaoDivisorIndex);
+    int ssaoKernelSize = ambientOcclusion.get_kernelSize();
+    if (ImGui::SliderInt("SSAO samples", &ssaoKernelSize, 1, AmbientOcclusion::MAX_KERNEL_SIZE)) ambientOcclusion.set_kernelSize(ssaoKernelSize);
+    bool ssaoBlurEnabled = ambientOcclusion.is_blurEnabled();
+    if (ImGui::Checkbox("SSAO blur", &ssaoBlurEnabled)) ambientOcclusion.set_blurEnabled(ssaoBlurEnabled);
+    ImGui::SameLine();
+    bool ssaoTemporalEnabled = ambientOcclusion.is_temporalEnabled();
+    if (ImGui::Checkbox("SSAO temporal", &ssaoTemporalEnabled)) ambientOcclusion.set_temporalEnabled(ssaoTemporalEnabled);
+    if (ssaoTemporalEnabled) {
+        int ssaoTemporalSamples = ambientOcclusion.get_temporalSampleCount();
+        if (ImGui::SliderInt("SSAO samples per frame", &ssaoTemporalSamples, 1, 16)) ambientOcclusion.set_temporalSampleCount(ssaoTemporalSamples);
+    }
+    bool renderQueueEnabled = Renderer::getInstance().is_renderQueueEnabled();
+    if (ImGui::Checkbox("Render queue", &renderQueueEnabled)) Renderer::getInstance().set_renderQueueEnabled(renderQueueEnabled);
+    ImGui::SameLine();
+    bool multiDrawEnabled = Renderer::getInstance().is_multiDrawEnabled();
+    if (ImGui::Checkbox("Multi-draw indirect", &multiDrawEnabled)) Renderer::getInstance().set_multiDrawEnabled(multiDrawEnabled);
+    ImGui::SameLine();
+    bool gpuCullingEnabled = Renderer::getInstance().is_gpuCullingEnabled();
+    if (ImGui::Checkbox("GPU culling", &gpuCullingEnabled)) Renderer::getInstance().set_gpuCullingEnabled(gpuCullingEnabled);
+    ImGui::SameLine();
+    bool occlusionCullingEnabled = Renderer::getInstance().is_occlusionCullingEnabled();
+    if (ImGui::Checkbox("Hi-Z occlusion", &occlusionCullingEnabled)) Renderer::getInstance().set_occlusionCullingEnabled(occlusionCullingEnabled);
+    ImGui::SameLine();
+    bool softwareOcclusionEnabled = Renderer::getInstance().is_softwareOcclusionEnabled();
+    if (ImGui::Checkbox("SW occlusion", &softwareOcclusionEnabled)) Renderer::getInstance().set_softwareOcclusionEnabled(softwareOcclusionEnabled);
+    ImGui::SameLine();
+    bool occlusionQueriesEnabled = Renderer::getInstance().is_occlusionQueriesEnabled();
+    if (ImGui::Checkbox("Occlusion queries", &occlusionQueriesEnabled)) Renderer::getInstance().set_occlusionQueriesEnabled(occlusionQueriesEnabled);
+    ImGui::SameLine();
+    bool frustumCullingEnabled = Renderer::getInstance().is_frustumCullingEnabled();
+    if (ImGui::Checkbox("Frustum culling", &frustumCullingEnabled)) Renderer::getInstance().set_frustumCullingEnabled(frustumCullingEnabled);
+    ImGui::SameLine();
+    bool sceneBVHEnabled = Renderer::getInstance().is_sceneBVHEnabled();
+    if (ImGui::Checkbox("Scene BVH", &sceneBVHEnabled)) Renderer::getInstance().set_sceneBVHEnabled(sceneBVHEnabled);
+    if (const SceneBVH* bvh = Renderer::getInstance().get_sceneBVH(RenderType::Basic)) {
+        ImGui::Text("BVH nodes %d  primitives %d  rebuilds %d  refit %d",
+                    bvh->get_nodeCount(), bvh->get_primitiveCount(), bvh->get_rebuildCount(), bvh->get_lastRefitCount());
+    }
+    if (Renderer::getInstance().is_gpuCullingEnabled()) {
+        // GPU 剔除的结果留在显存中不回读，只显示参与剔除的规模
+        GpuCulling& gpuCulling = Renderer::getInstance().get_gpuCulling();
+        ImGui::Text("GPU culling objects %d  batches %d  rebuilds %d",
+                    gpuCulling.get_objectCount(), gpuCulling.get_batchCount(), gpuCulling.get_rebuildCount());
+    }
+    if (const SoftwareOcclusion* occlusion = Renderer::getInstance().get_activeSoftwareOcclusion()) {
+        ImGui::Text("SW occlusion %dx%d %s  occluders %d  triangles %d  tested %d  culled %d",
+                    occlusion->get_width(), occlusion->get_height(), occlusion->is_avx2() ? "AVX2" : "scalar",
+                    occlusion->get_occluderCount(), occlusion->get_triangleCount(), occlusion->get_testedCount(), occlusion->get_culledCount());
+    }
+    bool depthPrepassEnabled = Renderer::getInstance().is_depthPrepassEnabled();
+    if (ImGui::Checkbox("Depth prepass", &depthPrepassEnabled)) Renderer::getInstance().set_depthPrepassEnabled(depthPrepassEnabled);
+    ImGui::SameLine();
+    // G-Buffer 布局切换需要重建通道，这里只显示
+    ImGui::Text("G-buffer %s %d B/px", Renderer::getInstance().is_compactGBufferEnabled() ? "compact" : "full",
+                Renderer::getInstance().get_gBufferBytesPerPixel());
+    ImGui::SameLine();
+    FramebufferPool& framebufferPool = Renderer::getInstance().get_framebufferPool();
+    ImGui::Text("FBO pool %d FBOs (%d in use), %d textures %.1f MB, %d allocations", framebufferPool.get_framebufferCount(), framebufferPool.get_inUseCount(),
+                framebufferPool.get_textureCount(), framebufferPool.get_allocatedBytes() / (1024.0 * 1024.0), framebufferPool.get_allocationCount());
+    // 渲染图：本帧执行的步骤数，以及被剔除、关闭的通道
+    RenderGraph& renderGraph = Renderer::getInstance().get_renderGraph();
+    std::string skipped;
+    for (const char* name : renderGraph.get_culledPasses()) skipped += std::string(" -") + name;
+    for (const char* name : renderGraph.get_disabledPasses()) skipped += std::string(" ~") + name;
+    ImGui::Text("Render graph %d passes%s", static_cast<int>(renderGraph.get_steps().size()), skipped.c_str());
+    ImGui::SameLine();
+    bool dynamicResolutionEnabled = Renderer::getInstance().is_dynamicResolutionEnabled();
+    if (ImGui::Checkbox("Dynamic resolution", &dynamicResolutionEnabled)) Renderer::getInstance().set_dynamicResolutionEnabled(dynamicResolutionEnabled);
+    if (dynamicResolutionEnabled) {
+        DynamicResolution& dynamicResolution = Renderer::getInstance().get_dynamicResolution();
+        float targetFrameMs = dynamicResolution.get_targetFrameMs();
+        if (ImGui::SliderFloat("GPU budget (ms)", &targetFrameMs, 2.0f, 50.0f)) dynamicResolution.set_targetFrameMs(targetFrameMs);
+        float minScale = dynamicResolution.get_minScale();
+        if (ImGui::SliderFloat("Min scale", &minScale, 0.25f, 1.0f)) dynamicResolution.set_minScale(minScale);
+        ImGui::Text("Render scale %.2f  %dx%d  avg GPU %.3f ms", dynamicResolution.get_scale(),
+                    Renderer::getInstance().get_renderWidth(), Renderer::getInstance().get_renderHeight(), dynamicResolution.get_averageFrameMs());
+    }
+    bool clusteredLightingEnabled = Renderer::getInstance().is_clusteredLightingEnabled();
+    if (ImGui::Checkbox("Clustered lighting", &clusteredLightingEnabled)) Renderer::getInstance().set_clusteredLightingEnabled(clusteredLightingEnabled);
+    if (clusteredLightingEnabled) {
+        ImGui::SameLine();
+        ImGui::Text("clusters %dx%dx%d  lights %d", ClusteredLighting::GRID_X, ClusteredLighting::GRID_Y, ClusteredLighting::GRID_Z,
+                    Renderer::getInstance().get_clusteredLighting().get_lightCount());
+    }
+    if (OcclusionQueries* queries = Renderer::getInstance().get_activeOcclusionQueries()) {
+        ImGui::Text("Occlusion queries: visible %d  hidden %d  issued %d",
+                    queries->get_visibleCount(), queries->get_hiddenCount(), queries->get_queryCount());
+    }
+    // 本帧各几何通道的剔除结果（ImGui 通道在几何通道之后执行）
+    for (const auto& stats : Renderer::getInstance().get_cullingStats()) {
+        ImGui::Text("%-16s drawn %6d  culled %6d", stats.name, stats.drawn, stats.culled);
+    }
+    drawGpuProfiler();
+    drawGLStats();
     ImGui::End();
 
     // 渲染 ImGui
@@ -258,83 +818,218 @@ void ImGuiPass::execute()
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
+void ImGuiPass::drawGLStats()
+{
+    GLStats& stats = GLStats::getInstance();
+    if (!ImGui::CollapsingHeader("GL Stats")) return;
+
+    bool recording = stats.is_recording();
+    if (ImGui::Checkbox("Record##gl_stats", &recording)) stats.set_recording(recording);
+    ImGui::SameLine();
+    if (ImGui::Button("Export##gl_stats")) {
+        if (stats.exportJson("gl_stats.json")) {
+            std::cout << "GL stats exported to gl_stats.json (" << stats.get_recordedFrames().size() << " frames)" << std::endl;
+        }
+    }
+
+    // 上一帧的计数
+    const GLStats::FrameCounters& frame = stats.get_lastFrame();
+    for (int i = 0; i < GLStats::COUNTER_COUNT; ++i) {
+        ImGui::Text("%-20s %10llu", GLStats::get_counterName(static_cast<GLStats::Counter>(i)), (unsigned long long)frame.values[i]);
+    }
+}
+
+void ImGuiPass::drawGpuProfiler()
+{
+    GpuProfiler& profiler = GpuProfiler::getInstance();
+    if (!ImGui::CollapsingHeader("GPU Profiler")) return;
+
+    bool enabled = profiler.is_enabled();
+    if (ImGui::Checkbox("Enable", &enabled)) profiler.set_enabled(enabled);
+    ImGui::SameLine();
+    bool recording = profiler.is_recording();
+    if (ImGui::Checkbox("Record", &recording)) profiler.set_recording(recording);
+    ImGui::SameLine();
+    if (ImGui::Button("Export")) {
+        profiler.flush();
+        if (profiler.exportTimeSeries("gpu_profile.json")) {
+            std::cout << "GPU profile exported to gpu_profile.json (" << profiler.get_recordedFrames().size() << " frames)" << std::endl;
+        }
+    }
+    if (!enabled) return;
+
+    // 帧总耗时曲线
+    std::vector<float> frameSamples(profiler.get_frameHistory().begin(), profiler.get_frameHistory().end());
+    if (!frameSamples.empty()) {
+        ImGui::Text("Frame: %.3f ms", frameSamples.back());
+        ImGui::PlotLines("##gpu_frame", frameSamples.data(), (int)frameSamples.size(), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+    }
+
+    // 各通道及子阶段
+    for (const auto& path : profiler.get_zoneOrder()) {
+        const GpuProfiler::ZoneHistory* history = profiler.get_zoneHistory(path);
+        if (!history) continue;
+        ImGui::Text("%*s%-24s %7.3f ms (avg %7.3f)", history->depth * 2, "", path.c_str(), history->lastMs, history->average());
+    }
+}
+
+void PBRPass::declare(RenderGraph::PassBuilder& builder)
+{
+    builder.read(RenderResource::OccluderDepth);
+    builder.read(RenderResource::CullCommands);
+    builder.read(RenderResource::Clusters);
+    // 深度单独作为 SceneDepth（Hi-Z 构建、紧凑布局重建位置），之后挂在场景缓冲上直到合成；G-Buffer 的颜色附件光照之后归还
+    if (Renderer::getInstance().is_compactGBufferEnabled()) {
+        // 八面体法线 4 + 反照率 4 + 金属度/粗糙度/AO 4 + 深度 4 = 16 字节/像素
+        builder.create(RenderResource::GBuffer, windowSizedDesc({
+            {GL_RG16, GL_RG, GL_UNSIGNED_SHORT},
+            {GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE},
+            {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE}
+        }));
+    } else {
+        // 位置与线性深度 8 + 法线 6 + 反照率 6 + 金属度/粗糙度/AO 6 + 深度 4 = 30 字节/像素
+        builder.create(RenderResource::GBuffer, windowSizedDesc({
+            {GL_RGBA16F, GL_RGBA, GL_FLOAT},
+            {GL_RGB16F, GL_RGB, GL_FLOAT},
+            {GL_RGB16F, GL_RGB, GL_FLOAT},
+            {GL_RGB16F, GL_RGB, GL_FLOAT}
+        }));
+    }
+    builder.create(RenderResource::SceneDepth, sceneDepthDesc());
+    builder.write(RenderResource::SceneColor);
+}
+
 void PBRPass::execute()
 {
-    // G-Buffer 阶段
-    pbr_g_shader->bind();
+    bool gpuCulled = Renderer::getInstance().is_gpuCullingEnabled();
+    bool depthPrepass = Renderer::getInstance().is_depthPrepassEnabled();
+    bool compact = Renderer::getInstance().is_compactGBufferEnabled();
+    FramebufferPool& pool = Renderer::getInstance().get_framebufferPool();
+    pbrDeferredFramebuffer = Renderer::getInstance().get_renderGraph().get_framebuffer(RenderResource::GBuffer);
+    Framebuffer* sceneDepth = Renderer::getInstance().get_renderGraph().get_framebuffer(RenderResource::SceneDepth);
+    pbrDeferredFramebuffer->share_depth(sceneDepth);
     pbrDeferredFramebuffer->bind(); // 绑定帧缓冲
-    glClearBufferfv(GL_COLOR, 0, glm::value_ptr(glm::vec4(0.0f))); // gPosition
-    glClearBufferfv(GL_COLOR, 1, glm::value_ptr(glm::vec3(0.0f))); // gNormal
-    glClearBufferfv(GL_COLOR, 2, glm::value_ptr(glm::vec3(0.0f))); // gAlbedo
-    glClearBufferfv(GL_COLOR, 3, glm::value_ptr(glm::vec3(0.0f))); // gMetallicRoughnessAO
+    glViewport(0, 0, Renderer::getInstance().get_renderWidth(), Renderer::getInstance().get_renderHeight());
     glClear(GL_DEPTH_BUFFER_BIT);
-    for(auto model : models){
-        model->draw(pbr_g_shader.get());
+
+    // 深度预渲染：只用位置流写深度，之后 G-Buffer 以 GL_EQUAL 比较且不写深度，每个像素只写一次 G-Buffer
+    if (depthPrepass) {
+        GpuProfileScope gpuZone("DepthPrepass");
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        if (gpuCulled) {
+            drawModelsGpuCulled(models, instancedModels, depth_prepass_shader.get(), "DepthPrepass", *sceneDepth, true);
+        } else {
+            drawModels(queue, models, depth_prepass_shader.get(), "DepthPrepass", Renderer::getInstance().get_cameraFrustum(), true);
+            drawInstancedModels(instancedModels, depth_prepass_shader.get(), "DepthPrepass", Renderer::getInstance().get_cameraFrustum(), true);
+        }
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+    }
+
+    // G-Buffer 阶段
+    {
+        GpuProfileScope gpuZone("GBuffer");
+        pbr_g_shader->bind();
+        pbr_g_shader->setUniform1i("compactGBuffer", compact ? 1 : 0);
+        if (compact) {
+            glClearBufferfv(GL_COLOR, 0, glm::value_ptr(glm::vec4(0.0f))); // 八面体法线
+            glClearBufferfv(GL_COLOR, 1, glm::value_ptr(glm::vec4(0.0f))); // gAlbedo
+            glClearBufferfv(GL_COLOR, 2, glm::value_ptr(glm::vec4(0.0f))); // gMetallicRoughnessAO
+            // 反照率附件为 sRGB 格式，写入时由硬件编码，采样时解码回线性值
+            glEnable(GL_FRAMEBUFFER_SRGB);
+        } else {
+            glClearBufferfv(GL_COLOR, 0, glm::value_ptr(glm::vec4(0.0f))); // gPosition
+            glClearBufferfv(GL_COLOR, 1, glm::value_ptr(glm::vec3(0.0f))); // gNormal
+            glClearBufferfv(GL_COLOR, 2, glm::value_ptr(glm::vec3(0.0f))); // gAlbedo
+            glClearBufferfv(GL_COLOR, 3, glm::value_ptr(glm::vec3(0.0f))); // gMetallicRoughnessAO
+        }
+        if (gpuCulled && depthPrepass) {
+            redrawModelsGpuCulled(models, instancedModels, pbr_g_shader.get(), get_name());
+        } else if (gpuCulled) {
+            drawModelsGpuCulled(models, instancedModels, pbr_g_shader.get(), get_name(), *sceneDepth);
+        } else {
+            drawModels(queue, models, pbr_g_shader.get(), get_name(), Renderer::getInstance().get_cameraFrustum());
+            drawInstancedModels(instancedModels, pbr_g_shader.get(), get_name(), Renderer::getInstance().get_cameraFrustum());
+        }
+        if (depthPrepass) {
+            glDepthFunc(GL_LESS);
+            glDepthMask(GL_TRUE);
+        }
+        if (compact) glDisable(GL_FRAMEBUFFER_SRGB);
+        pbrDeferredFramebuffer->unbind(); // 解绑帧缓冲
+    }
+
+    // 紧凑布局没有位置附件：单元 0 改绑深度纹理（gDepth），其余附件依次前移一位
+    GLuint positionTexture = compact ? sceneDepth->get_depthTexture() : pbrDeferredFramebuffer->get_texture(0);
+    int attachmentOffset = compact ? 0 : 1;
+    glm::mat4 inverseViewProjection(1.0f);
+    AmbientOcclusion::GBufferInputs gBuffer;
+    if (Camera* camera = Renderer::getInstance().get_camera()) {
+        inverseViewProjection = glm::inverse(camera->getViewProjectionMatrix());
+        gBuffer.previousViewProjection = camera->getPreviousViewProjectionMatrix();
+        gBuffer.previousViewPosition = camera->getPreviousCameraPosition();
     }
-    pbrDeferredFramebuffer->unbind(); // 解绑帧缓冲
 
     // SSAO 阶段
-    ssaoFrameBuffer->bind(); // 绑定 SSAO 帧缓冲
-    glClear(GL_COLOR_BUFFER_BIT); // 清除颜色缓存
-    ssao_shader->bind();
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, pbrDeferredFramebuffer->get_texture(0));
-    ssao_shader->setUniform1i("gPosition", 0);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, pbrDeferredFramebuffer->get_texture(1));
-    ssao_shader->setUniform1i("gNormal", 1);
-    noiseTexture->bind(ssao_shader.get(), TextureType::Noise, 2); // 绑定噪声纹理
-    ssao_shader->setUniform3fv("samples", ssaoKernel.size(), glm::value_ptr(ssaoKernel[0])); // 传入 SSAO 内核
-    ssao_shader->setUniform1f("ssaoStrengh", Renderer::getInstance().ssaoStrength); // 设置 SSAO 强度
-    dummy_screen->draw();   // 利用屏幕四边形绘制结果
-    ssaoFrameBuffer->unbind(); // 解绑 SSAO 帧缓冲
+    gBuffer.position = positionTexture;
+    gBuffer.normal = pbrDeferredFramebuffer->get_texture(attachmentOffset);
+    gBuffer.compact = compact;
+    gBuffer.inverseViewProjection = inverseViewProjection;
+    gBuffer.width = Renderer::getInstance().get_renderWidth();
+    gBuffer.height = Renderer::getInstance().get_renderHeight();
+    Framebuffer* ssaoFrameBuffer = pool.acquire(ssaoTargetDesc());
+    {
+        GpuProfileScope gpuZone("SSAO");
+        Renderer::getInstance().get_ambientOcclusion().compute(ssao_shader.get(), gBuffer, *ssaoFrameBuffer, *dummy_screen, Renderer::getInstance().ssaoStrength);
+    }
 
     // 光照阶段
+    GpuProfileScope gpuZone("Lighting");
     pbr_l_shader->bind();
     // pbr_l_shader->setUniform1i("debugMode", Renderer::getInstance().get_debugMode()); // 使用全局调试模式
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, pbrDeferredFramebuffer->get_texture(0));
+    gl::bindTexture(GL_TEXTURE_2D, positionTexture);
     pbr_l_shader->setUniform1i("gPosition", 0);
+    pbr_l_shader->setUniform1i("gDepth", 0);
     glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, pbrDeferredFramebuffer->get_texture(1));
+    gl::bindTexture(GL_TEXTURE_2D, pbrDeferredFramebuffer->get_texture(attachmentOffset));
     pbr_l_shader->setUniform1i("gNormal", 1);
     glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, pbrDeferredFramebuffer->get_texture(2));
+    gl::bindTexture(GL_TEXTURE_2D, pbrDeferredFramebuffer->get_texture(attachmentOffset + 1));
     pbr_l_shader->setUniform1i("gAlbedo", 2);
     glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, pbrDeferredFramebuffer->get_texture(3));
+    gl::bindTexture(GL_TEXTURE_2D, pbrDeferredFramebuffer->get_texture(attachmentOffset + 2));
     pbr_l_shader->setUniform1i("gMetallicRoughnessAO", 3);
+    pbr_l_shader->setUniform1i("compactGBuffer", compact ? 1 : 0);
+    pbr_l_shader->setUniform4fv("inverseViewProjection", inverseViewProjection);
     glActiveTexture(GL_TEXTURE4);
-    glBindTexture(GL_TEXTURE_2D, ssaoFrameBuffer->get_texture(0)); // 绑定 SSAO 结果
+    gl::bindTexture(GL_TEXTURE_2D, ssaoFrameBuffer->get_texture(0)); // 绑定 SSAO 结果
     pbr_l_shader->setUniform1i("ssao", 4);
     brdfLUT->bind(pbr_l_shader.get(), TextureType::BRDF, 5);   // 绑定 brdfLUT
     prefilterMap->bind(pbr_l_shader.get(), TextureType::Prefilter, 6); // 绑定预过滤的立方体贴图
+    // 直接光照：分簇结果由 LightCullingPass 在本帧生成，条件与其一致
+    Renderer& renderer = Renderer::getInstance();
+    int lightCount = light ? light->get_lightCount() : 0;
+    bool clustered = lightCount > 0 && renderer.is_clusteredLightingEnabled() && renderer.get_camera();
+    if (lightCount > 0) light->lightsSSBO->bindBase();
+    if (clustered) renderer.get_clusteredLighting().bind(pbr_l_shader.get());
+    pbr_l_shader->setUniform1i("numLights", lightCount);
+    pbr_l_shader->setUniform1i("clustered", clustered ? 1 : 0);
+    glm::vec2 uvScale = renderer.get_renderUVScale();
+    pbr_l_shader->setUniform2f("uvScale", uvScale.x, uvScale.y);
 
-    glClear(GL_DEPTH_BUFFER_BIT); // 清除深度缓存
+    // 屏幕四边形不测试也不写深度。紧凑布局在这里采样 SceneDepth（gDepth），同一纹理同时挂在绘制目标上构成反馈回路，
+    // 即使关闭深度测试和写入也是未定义行为，因此先挂着场景缓冲自己的深度绘制
+    Framebuffer* sceneFramebuffer = renderer.get_sceneFramebuffer();
+    sceneFramebuffer->share_depth(compact ? nullptr : sceneDepth);
+    renderer.bind_sceneTarget();
+    glDisable(GL_DEPTH_TEST);
     dummy_screen->draw();   // 利用屏幕四边形绘制结果
+    glEnable(GL_DEPTH_TEST);
+    // 场景缓冲挂上场景深度，天空盒和之后的通道直接深度测试
+    sceneFramebuffer->share_depth(sceneDepth);
+    // G-Buffer 本通道结束后归还，先摘掉借来的深度
+    pbrDeferredFramebuffer->share_depth(nullptr);
+    pool.release(ssaoFrameBuffer);
 }
-
-std::vector<glm::vec3> generateSSAOKernel(int kernelSize)
-{
-    std::vector<glm::vec3> kernel;
-    kernel.reserve(kernelSize);
-
-    for (int i = 0; i < kernelSize; ++i) {
-        glm::vec3 sample(
-            (float)rand() / RAND_MAX * 2.0f - 1.0f, // x in [-1, 1]
-            (float)rand() / RAND_MAX * 2.0f - 1.0f, // y in [-1, 1]
-            (float)rand() / RAND_MAX                // z in [0, 1]
-        );
-        sample = glm::normalize(sample);
-        sample *= (float)rand() / RAND_MAX;
-
-        // 让靠近原点的点分布更密集（指数分布）
-        float scale = (float)i / kernelSize;
-        scale = glm::mix(0.1f, 1.0f, scale * scale);
-        sample *= scale;
-
-        kernel.push_back(sample);
-    }
-
-    return kernel;
-}
\ No newline at end of file
@@ -0,0 +1,319 @@
+#include "SceneBVH.h"
+#include "Model.h"
+#include "Mesh.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+
+namespace {
+    float surfaceArea(const AABB& box) {
+        if (!box.is_valid()) return 0.0f;
+        glm::vec3 d = box.max - box.min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    bool sameBounds(const AABB& a, const AABB& b) {
+        return a.min == b.min && a.max == b.max;
+    }
+}
+
+SceneBVH::~SceneBVH()
+{
+    detachPrimitives();
+}
+
+void SceneBVH::update(const std::vector<std::shared_ptr<Model>>& models)
+{
+    bool modelsChanged = models.size() != builtModels.size();
+    for (size_t i = 0; !modelsChanged && i < models.size(); ++i) {
+        modelsChanged = models[i].get() != builtModels[i];
+    }
+    if (needsRebuild || modelsChanged) {
+        detachPrimitives();
+        primitives.clear();
+        builtModels.clear();
+        for (const auto& model : models) {
+            builtModels.push_back(model.get());
+            for (Mesh* mesh : model->get_meshes()) {
+                const AABB& bounds = mesh->get_worldBounds();
+                primitives.push_back({mesh, bounds, bounds.center(), -1});
+            }
+        }
+        build();
+        return;
+    }
+    refit();
+}
+
+void SceneBVH::detachPrimitives()
+{
+    // 已析构的网格在 remove_primitive() 中置空
+    for (const auto& primitive : primitives) {
+        if (primitive.mesh) primitive.mesh->detach_bvh(this);
+    }
+}
+
+void SceneBVH::remove_primitive(int primitive, const Mesh* mesh)
+{
+    if (primitive < 0 || primitive >= (int)primitives.size() || primitives[primitive].mesh != mesh) return;
+    primitives[primitive].mesh = nullptr;
+    needsRebuild = true;
+}
+
+void SceneBVH::mark_dirty(int primitive, const Mesh* mesh)
+{
+    // 重建后索引可能已指向别的网格，核对后再记录
+    if (primitive < 0 || primitive >= (int)primitives.size() || primitives[primitive].mesh != mesh) return;
+    if (primitiveDirty[primitive]) return;
+    primitiveDirty[primitive] = 1;
+    dirtyPrimitives.push_back(primitive);
+}
+
+void SceneBVH::build()
+{
+    CPU_PROFILE_SCOPE("SceneBVH::build");
+    nodes.clear();
+    dirtyPrimitives.clear();
+    primitiveDirty.assign(primitives.size(), 0);
+    needsRebuild = false;
+    rebuildCount++;
+    if (primitives.empty()) return;
+
+    nodes.reserve(primitives.size() * 2);
+    buildNode(0, static_cast<int>(primitives.size()), -1);
+
+    for (int i = 0; i < (int)nodes.size(); ++i) {
+        const Node& node = nodes[i];
+        for (int p = node.first; p < node.first + node.count; ++p) {
+            primitives[p].leaf = i;
+        }
+    }
+    for (int p = 0; p < (int)primitives.size(); ++p) {
+        primitives[p].mesh->set_bvhPrimitive(this, p);
+    }
+}
+
+int SceneBVH::buildNode(int first, int count, int parent)
+{
+    int index = static_cast<int>(nodes.size());
+    nodes.emplace_back();
+    nodes[index].parent = parent;
+    nodes[index].first = first;
+    nodes[index].span = count;
+
+    AABB bounds;
+    AABB centroidBounds;
+    for (int i = first; i < first + count; ++i) {
+        bounds.expand(primitives[i].bounds);
+        centroidBounds.expand(primitives[i].centroid);
+    }
+    nodes[index].bounds = bounds;
+
+    if (count <= MAX_LEAF_SIZE) {
+        nodes[index].count = count;
+        return index;
+    }
+
+    // 在质心跨度最大的轴上分箱，按 SAH 代价选择划分位置
+    glm::vec3 size = centroidBounds.max - centroidBounds.min;
+    int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+    float extent = size[axis];
+    auto begin = primitives.begin() + first;
+    auto end = begin + count;
+    int mid = first + count / 2;
+
+    if (extent > 0.0f) {
+        struct Bin {
+            AABB bounds;
+            int count = 0;
+        } bins[SAH_BINS];
+        float scale = SAH_BINS / extent;
+        float axisMin = centroidBounds.min[axis];
+        auto binOf = [&](const Primitive& primitive) {
+            int bin = static_cast<int>((primitive.centroid[axis] - axisMin) * scale);
+            return std::min(bin, SAH_BINS - 1);
+        };
+        for (auto it = begin; it != end; ++it) {
+            Bin& bin = bins[binOf(*it)];
+            bin.count++;
+            bin.bounds.expand(it->bounds);
+        }
+
+        // 从右向左累积，得到每个划分位置右侧的面积和数量
+        float rightArea[SAH_BINS];
+        int rightCount[SAH_BINS];
+        AABB accumulated;
+        int accumulatedCount = 0;
+        for (int b = SAH_BINS - 1; b > 0; --b) {
+            accumulated.expand(bins[b].bounds);
+            accumulatedCount += bins[b].count;
+            rightArea[b] = surfaceArea(accumulated);
+            rightCount[b] = accumulatedCount;
+        }
+
+        float bestCost = FLT_MAX;
+        int bestSplit = -1;   // 划分在 bestSplit 与 bestSplit + 1 之间
+        accumulated = AABB();
+        accumulatedCount = 0;
+        for (int b = 0; b < SAH_BINS - 1; ++b) {
+            accumulated.expand(bins[b].bounds);
+            accumulatedCount += bins[b].count;
+            if (accumulatedCount == 0 || rightCount[b + 1] == 0) continue;
+            float cost = accumulatedCount * surfaceArea(accumulated) + rightCount[b + 1] * rightArea[b + 1];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestSplit = b;
+            }
+        }
+
+        if (bestSplit >= 0) {
+            auto split = std::partition(begin, end, [&](const Primitive& primitive) { return binOf(primitive) <= bestSplit; });
+            mid = static_cast<int>(split - primitives.begin());
+        }
+    }
+
+    // 无法按 SAH 划分（质心重合等）时退回按质心中位数对半分
+    if (mid == first || mid == first + count) {
+        mid = first + count / 2;
+        std::nth_element(begin, primitives.begin() + mid, end, [axis](const Primitive& a, const Primitive& b) {
+            return a.centroid[axis] < b.centroid[axis];
+        });
+    }
+
+    int left = buildNode(first, mid - first, index);
+    int right = buildNode(mid, first + count - mid, index);
+    nodes[index].left = left;
+    nodes[index].right = right;
+    return index;
+}
+
+void SceneBVH::refit()
+{
+    lastRefitCount = static_cast<int>(dirtyPrimitives.size());
+    if (dirtyPrimitives.empty()) return;
+    CPU_PROFILE_SCOPE("SceneBVH::refit");
+
+    for (int p : dirtyPrimitives) {
+        Primitive& primitive = primitives[p];
+        primitive.bounds = primitive.mesh->get_worldBounds();
+        primitive.centroid = primitive.bounds.center();
+        primitiveDirty[p] = 0;
+    }
+
+    // 大量图元移动后层次质量变差，直接重建比逐个向上拟合更划算
+    if (dirtyPrimitives.size() * 4 > primitives.size()) {
+        build();
+        return;
+    }
+
+    for (int p : dirtyPrimitives) {
+        int nodeIndex = primitives[p].leaf;
+        while (nodeIndex != -1) {
+            Node& node = nodes[nodeIndex];
+            AABB bounds;
+            if (node.count > 0) {
+                for (int i = node.first; i < node.first + node.count; ++i) bounds.expand(primitives[i].bounds);
+            } else {
+                bounds.expand(nodes[node.left].bounds);
+                bounds.expand(nodes[node.right].bounds);
+            }
+            // 包围盒没有变化时祖先也不会变化
+            if (sameBounds(bounds, node.bounds)) break;
+            node.bounds = bounds;
+            nodeIndex = node.parent;
+        }
+    }
+    dirtyPrimitives.clear();
+}
+
+void SceneBVH::query(const Frustum& frustum, std::vector<Mesh*>& result) const
+{
+    CPU_PROFILE_SCOPE("SceneBVH::query");
+    if (nodes.empty()) return;
+
+    std::vector<int> stack;
+    stack.push_back(0);
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        int nodeIndex = stack.back();
+        stack.pop_back();
+
+        Frustum::Containment containment = frustum.classify(node.bounds);
+        if (containment == Frustum::Containment::Outside) continue;
+        if (containment == Frustum::Containment::Inside) {
+            collectSubtree(nodeIndex, result);
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                const Primitive& primitive = primitives[i];
+                if (primitive.mesh->get_visibility() && frustum.intersects(primitive.bounds)) {
+                    result.push_back(primitive.mesh);
+                }
+            }
+        } else {
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+}
+
+void SceneBVH::collectSubtree(int nodeIndex, std::vector<Mesh*>& result) const
+{
+    // 子树的图元在数组中是连续的
+    const Node& node = nodes[nodeIndex];
+    for (int i = node.first; i < node.first + node.span; ++i) {
+        if (primitives[i].mesh->get_visibility()) result.push_back(primitives[i].mesh);
+    }
+}
+
+int SceneBVH::get_visiblePrimitiveCount() const
+{
+    int count = 0;
+    for (const Primitive& primitive : primitives) {
+        if (primitive.mesh->get_visibility()) count++;
+    }
+    return count;
+}
+
+bool SceneBVH::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const
+{
+    if (nodes.empty()) return false;
+
+    glm::vec3 invDirection = 1.0f / direction;
+    float closest = maxDistance;
+    bool found = false;
+
+    std::vector<int> stack;
+    stack.push_back(0);
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+
+        float tEnter;
+        if (!intersectRayAABB(origin, invDirection, node.bounds, closest, tEnter)) continue;
+
+        if (node.count > 0) {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                const Primitive& primitive = primitives[i];
+                if (!primitive.mesh->get_visibility()) continue;
+                if (!intersectRayAABB(origin, invDirection, primitive.bounds, closest, tEnter)) continue;
+                float t;
+                if (primitive.mesh->intersect_ray(origin, direction, closest, t)) {
+                    closest = t;
+                    hit.mesh = primitive.mesh;
+                    found = true;
+                }
+            }
+        } else {
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+
+    if (found) {
+        hit.distance = closest;
+        hit.position = origin + direction * closest;
+    }
+    return found;
+}
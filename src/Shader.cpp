@@ -1,9 +1,43 @@
 #include "Shader.h"
+#include "GLStats.h"
+
+unsigned int Shader::s_BoundProgram = 0;
+
+namespace {
+    // 展开 #include "路径"（相对于包含它的文件所在的目录），被包含的文件中可以继续 #include
+    void appendSource(std::stringstream& out, const std::string& line, const std::string& directory)
+    {
+        size_t start = line.find_first_not_of(" \t");
+        size_t first = line.find('"');
+        size_t last = line.rfind('"');
+        if (start == std::string::npos || line.compare(start, 8, "#include") != 0 || first == std::string::npos || last <= first) {
+            out << line << '\n';
+            return;
+        }
+        std::string path = directory + line.substr(first + 1, last - first - 1);
+        std::ifstream stream(path);
+        if (!stream.is_open()) {
+            std::cout << "Failed to open shader include " << path << std::endl;
+            return;
+        }
+        std::string includeDirectory = path.substr(0, path.find_last_of('/') + 1);
+        std::string includeLine;
+        while (getline(stream, includeLine)) {
+            appendSource(out, includeLine, includeDirectory);
+        }
+    }
+}
 
 Shader::Shader(const std::string& filepath): m_FilePath(filepath), m_Program(0)
 {
 // 解析shader源码文件
     auto shadersCode = ParseShader();
+    // 只有 compute 段时创建计算着色器程序
+    std::string computeShaderCode = shadersCode[3].str();
+    if (!computeShaderCode.empty()) {
+        CreateComputeShader(computeShaderCode);
+        return;
+    }
     std::string vertexShaderCode = shadersCode[0].str();
     std::string fragmentShaderCode = shadersCode[1].str();
     std::string geometryShaderCode = shadersCode.size() > 2 ? shadersCode[2].str() : "";
@@ -13,17 +47,21 @@ Shader::Shader(const std::string& filepath): m_FilePath(filepath), m_Program(0)
 
 Shader::~Shader()
 {
+    if (s_BoundProgram == m_Program) s_BoundProgram = 0;
     glDeleteProgram(m_Program);
 }
 
 void Shader::bind() const
 {
-    glUseProgram(m_Program);
+    if (s_BoundProgram == m_Program) return;
+    gl::useProgram(m_Program);
+    s_BoundProgram = m_Program;
 }
 
 void Shader::unbind() const
 {
-    glUseProgram(0);
+    gl::useProgram(0);
+    s_BoundProgram = 0;
 }
 
 
@@ -46,57 +84,81 @@ int Shader::getUniformLocation(const std::string &name)
 void Shader::setUniform1f(const std::string &name, float v1)
 {
     int loc = getUniformLocation(name);
-    if (loc != -1)
-        glUniform1f(loc, v1);
+    if (loc != -1) {
+        gl::uniform(glUniform1f, loc, v1);
+    }
 }
 
 void Shader::setUniform2f(const std::string &name, float v1, float v2)
 {
     int loc = getUniformLocation(name);
-    if (loc != -1)
-        glUniform2f(loc, v1, v2);
+    if (loc != -1) {
+        gl::uniform(glUniform2f, loc, v1, v2);
+    }
 }
 
 void Shader::setUniform3f(const std::string &name, float v1, float v2, float v3)
 {
     int loc = getUniformLocation(name);
-    if (loc != -1)
-        glUniform3f(loc, v1, v2, v3);
+    if (loc != -1) {
+        gl::uniform(glUniform3f, loc, v1, v2, v3);
+    }
 }
 
 void Shader::setUniform4f(const std::string &name, float v1, float v2, float v3, float v4)
 {
     int loc = getUniformLocation(name);
-    if (loc != -1)
-        glUniform4f(loc, v1, v2, v3, v4);
+    if (loc != -1) {
+        gl::uniform(glUniform4f, loc, v1, v2, v3, v4);
+    }
 }
 
 void Shader::setUniform1i(const std::string &name, int v1)
 {
     int loc = getUniformLocation(name);
-    if (loc != -1)
-        glUniform1i(loc, v1);
+    if (loc != -1) {
+        gl::uniform(glUniform1i, loc, v1);
+    }
+}
+
+void Shader::setUniform2i(const std::string &name, int v1, int v2)
+{
+    int loc = getUniformLocation(name);
+    if (loc != -1) {
+        gl::uniform(glUniform2i, loc, v1, v2);
+    }
 }
 
 void Shader::setUniform1iv(const std::string& name, int count, const int* values)
 {
     int loc = getUniformLocation(name);
-    if (loc != -1)
-        glUniform1iv(loc, count, values);
+    if (loc != -1) {
+        gl::uniform(glUniform1iv, loc, count, values);
+    }
 }
 
 void Shader::setUniform3fv(const std::string &name, int count, const float *values)
 {
     int loc = getUniformLocation(name);
-    if (loc != -1)
-        glUniform3fv(loc, count, values);
+    if (loc != -1) {
+        gl::uniform(glUniform3fv, loc, count, values);
+    }
+}
+
+void Shader::setUniform4fv(const std::string &name, int count, const float *values)
+{
+    int loc = getUniformLocation(name);
+    if (loc != -1) {
+        gl::uniform(glUniform4fv, loc, count, values);
+    }
 }
 
 void Shader::setUniform4fv(const std::string &name, glm::mat4& mat)
 {
     int loc = getUniformLocation(name);
-    if (loc != -1)
-        glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(mat));
+    if (loc != -1) {
+        gl::uniform(glUniformMatrix4fv, loc, 1, GL_FALSE, glm::value_ptr(mat));
+    }
 }
 
 std::vector<std::stringstream> Shader::ParseShader()
@@ -108,12 +170,14 @@ std::vector<std::stringstream> Shader::ParseShader()
         NONE = -1,
         VERTEX = 0,
         FRAGMENT = 1,
-        GEOMETRY = 2
+        GEOMETRY = 2,
+        COMPUTE = 3
     };
 
     ShaderType type = ShaderType::NONE;
+    std::string directory = m_FilePath.substr(0, m_FilePath.find_last_of('/') + 1);
     std::string line;
-    std::vector<std::stringstream> ss(3); // Support for 3 shader types
+    std::vector<std::stringstream> ss(4); // Support for 4 shader types
     while (getline(stream, line))
     {
         if (line.find("#shader") != std::string::npos)
@@ -130,12 +194,16 @@ std::vector<std::stringstream> Shader::ParseShader()
             {
                 type = ShaderType::GEOMETRY;
             }
+            else if (line.find("compute") != std::string::npos)
+            {
+                type = ShaderType::COMPUTE;
+            }
         }
         else
         {
             if (type != ShaderType::NONE)
             {
-                ss[static_cast<int>(type)] << line << '\n';
+                appendSource(ss[static_cast<int>(type)], line, directory);
             }
         }
     }
@@ -168,6 +236,8 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
             shaderType = "FragmentShader";
         else if (type == GL_GEOMETRY_SHADER)
             shaderType = "GeometryShader";
+        else if (type == GL_COMPUTE_SHADER)
+            shaderType = "ComputeShader";
         else
             shaderType = "UnknownShader";
 
@@ -217,4 +287,26 @@ void Shader::CreateShader(const std::string& VertexShader, const std::string& Fr
     {
         glDeleteShader(gs);
     }
-}
\ No newline at end of file
+}
+
+void Shader::CreateComputeShader(const std::string& ComputeShader)
+{
+    m_Program = glCreateProgram();
+    unsigned int cs = CompileShader(GL_COMPUTE_SHADER, ComputeShader);
+    glAttachShader(m_Program, cs);
+    glLinkProgram(m_Program);
+
+    int isLinked;
+    glGetProgramiv(m_Program, GL_LINK_STATUS, &isLinked);
+    if (isLinked == GL_FALSE)
+    {
+        int length;
+        glGetProgramiv(m_Program, GL_INFO_LOG_LENGTH, &length);
+        char* message = new char[length];
+        glGetProgramInfoLog(m_Program, length, &length, message);
+        std::cout << "Failed to link program of " << m_FilePath << ": "<< message << std::endl;
+        delete[] message;
+    }
+
+    glDeleteShader(cs);
+}
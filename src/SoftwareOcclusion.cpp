@@ -0,0 +1,370 @@
+#include "SoftwareOcclusion.h"
+#include "Model.h"
+#include "Mesh.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SOFTWARE_OCCLUSION_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+// 只有这几个函数使用 AVX2 指令，其余代码不要求编译选项开启 -mavx2
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+    const int MAX_THREADS = 8;
+    const float MIN_W = 1e-5f;
+
+    bool cpuSupportsAVX2()
+    {
+#if defined(SOFTWARE_OCCLUSION_X86) && defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        __cpuidex(info, 7, 0);
+        bool avx2 = (info[1] & (1 << 5)) != 0;
+        return osxsave && avx2 && (_xgetbv(0) & 0x6) == 0x6;
+#elif defined(SOFTWARE_OCCLUSION_X86)
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+
+    // 屏幕空间位置：x, y 为像素坐标（原点在左下角，与 GL 窗口坐标一致），z 为 [0, 1] 深度
+    inline glm::vec3 toScreen(const glm::vec4& clip, int width, int height)
+    {
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        return glm::vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f);
+    }
+}
+
+SoftwareOcclusion::SoftwareOcclusion()
+{
+    useAVX2 = cpuSupportsAVX2();
+    set_resolution(256, 144);
+}
+
+SoftwareOcclusion::~SoftwareOcclusion()
+{
+    stopWorkers();
+}
+
+void SoftwareOcclusion::set_resolution(int width, int height)
+{
+    this->width = std::max(1, width);
+    this->height = std::max(1, height);
+    stride = (this->width + 7) & ~7;
+    depth.assign(static_cast<size_t>(stride) * this->height, 1.0f);
+}
+
+void SoftwareOcclusion::set_threadCount(int count)
+{
+    threadCount = std::max(0, count);
+}
+
+void SoftwareOcclusion::render(const glm::mat4& viewProjection, const std::vector<std::shared_ptr<Model>>& models)
+{
+    CPU_PROFILE_SCOPE("SoftwareOcclusion::render");
+    this->viewProjection = viewProjection;
+    testedCount = 0;
+    culledCount = 0;
+    std::fill(depth.begin(), depth.end(), 1.0f);
+
+    setupTriangles(viewProjection, models);
+    if (triangles.empty()) return;
+
+    int bands = threadCount > 0 ? threadCount : static_cast<int>(std::thread::hardware_concurrency());
+    bands = std::min(std::max(bands, 1), std::min(MAX_THREADS, height));
+    startWorkers(bands - 1);
+    int rowsPerBand = (height + bands - 1) / bands;
+
+    // 每个线程负责连续的若干行，所有三角形都要与自己的行带求交，写入互不重叠
+    {
+        std::lock_guard<std::mutex> lock(workerMutex);
+        bandRows = rowsPerBand;
+        pendingWorkers = static_cast<int>(workers.size());
+        workerGeneration++;
+    }
+    workerWake.notify_all();
+    {
+        CPU_PROFILE_SCOPE("SoftwareOcclusion::rasterizeBand");
+        rasterizeBand(0, std::min(height, rowsPerBand));
+    }
+    std::unique_lock<std::mutex> lock(workerMutex);
+    workerDone.wait(lock, [this]() { return pendingWorkers == 0; });
+}
+
+void SoftwareOcclusion::startWorkers(int count)
+{
+    if (static_cast<int>(workers.size()) == count) return;
+    stopWorkers();
+    // 工作线程常驻，每帧只唤醒一次；线程数变化时才重建
+    for (int band = 1; band <= count; ++band) {
+        workers.emplace_back(&SoftwareOcclusion::workerLoop, this, band, workerGeneration);
+    }
+}
+
+void SoftwareOcclusion::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(workerMutex);
+        stopping = true;
+    }
+    workerWake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    stopping = false;
+}
+
+void SoftwareOcclusion::workerLoop(int band, unsigned int seenGeneration)
+{
+    // seenGeneration 在创建线程时传入，线程启动晚于第一次唤醒也不会漏掉这一帧
+    CPU_PROFILE_THREAD_NAME("SoftwareOcclusion");
+    while (true) {
+        int rows = 0;
+        {
+            std::unique_lock<std::mutex> lock(workerMutex);
+            workerWake.wait(lock, [&]() { return stopping || workerGeneration != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = workerGeneration;
+            rows = bandRows;
+        }
+
+        int y0 = band * rows;
+        int y1 = std::min(height, y0 + rows);
+        if (y0 < y1) {
+            CPU_PROFILE_SCOPE("SoftwareOcclusion::rasterizeBand");
+            rasterizeBand(y0, y1);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(workerMutex);
+            pendingWorkers--;
+        }
+        workerDone.notify_one();
+    }
+}
+
+void SoftwareOcclusion::setupTriangles(const glm::mat4& viewProjection, const std::vector<std::shared_ptr<Model>>& models)
+{
+    triangles.clear();
+    occluderCount = 0;
+    for (const auto& model : models) {
+        for (Mesh* mesh : model->get_meshes()) {
+            if (!mesh->is_occluder() || !mesh->get_visibility()) continue;
+            occluderCount++;
+
+            glm::mat4 mvp = viewProjection * mesh->getModelMatrix();
+            const auto& vertices = mesh->get_vertices();
+            const auto& indices = mesh->get_indices();
+            clipPositions.resize(vertices.size());
+            for (size_t i = 0; i < vertices.size(); ++i) {
+                clipPositions[i] = mvp * glm::vec4(vertices[i].Position, 1.0f);
+            }
+
+            for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+                const glm::vec4& c0 = clipPositions[indices[i]];
+                const glm::vec4& c1 = clipPositions[indices[i + 1]];
+                const glm::vec4& c2 = clipPositions[indices[i + 2]];
+                // 跨过摄像机平面的三角形直接丢弃：少画遮挡物只会少剔除，不会错剔
+                if (c0.w < MIN_W || c1.w < MIN_W || c2.w < MIN_W) continue;
+
+                glm::vec3 v[3] = {toScreen(c0, width, height), toScreen(c1, width, height), toScreen(c2, width, height)};
+                float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+                if (std::fabs(area) < 1e-6f) continue;
+                // 不做背面剔除（遮挡物的两面都是真实表面），统一为逆时针方便边函数取正
+                if (area < 0.0f) {
+                    std::swap(v[1], v[2]);
+                    area = -area;
+                }
+
+                Triangle tri;
+                float minX = std::min({v[0].x, v[1].x, v[2].x});
+                float maxX = std::max({v[0].x, v[1].x, v[2].x});
+                float minY = std::min({v[0].y, v[1].y, v[2].y});
+                float maxY = std::max({v[0].y, v[1].y, v[2].y});
+                // 像素 x 覆盖 [x, x + 1]，只有整个落在包围盒内的像素才可能被完全覆盖
+                tri.minX = std::max(0, static_cast<int>(std::ceil(minX)));
+                tri.maxX = std::min(width - 1, static_cast<int>(std::floor(maxX)) - 1);
+                tri.minY = std::max(0, static_cast<int>(std::ceil(minY)));
+                tri.maxY = std::min(height - 1, static_cast<int>(std::floor(maxY)) - 1);
+                if (tri.minX > tri.maxX || tri.minY > tri.maxY) continue;
+
+                // 边 i 与顶点 i 相对，边函数除以面积即为顶点 i 的重心坐标
+                float invArea = 1.0f / area;
+                tri.zA = tri.zB = tri.zC = 0.0f;
+                for (int e = 0; e < 3; ++e) {
+                    const glm::vec3& a = v[(e + 1) % 3];
+                    const glm::vec3& b = v[(e + 2) % 3];
+                    tri.edgeA[e] = a.y - b.y;
+                    tri.edgeB[e] = b.x - a.x;
+                    tri.edgeC[e] = a.x * b.y - a.y * b.x;
+                    tri.zA += tri.edgeA[e] * invArea * v[e].z;
+                    tri.zB += tri.edgeB[e] * invArea * v[e].z;
+                    tri.zC += tri.edgeC[e] * invArea * v[e].z;
+                }
+                // 保守光栅化：线性函数在像素方块上的极值落在某个角上，与中心相差 0.5 * (|A| + |B|)。
+                // 边函数减去这个量后在中心求值，等于在最靠外的角求值，仍不小于 0 说明整个像素都被覆盖；
+                // 深度加上这个量，得到三角形在该像素内最远的深度，避免遮挡物挡住它实际没挡住的部分
+                for (int e = 0; e < 3; ++e) {
+                    tri.edgeC[e] -= 0.5f * (std::fabs(tri.edgeA[e]) + std::fabs(tri.edgeB[e]));
+                }
+                tri.zC += 0.5f * (std::fabs(tri.zA) + std::fabs(tri.zB));
+                triangles.push_back(tri);
+            }
+        }
+    }
+}
+
+void SoftwareOcclusion::rasterizeBand(int y0, int y1)
+{
+    if (useAVX2) {
+        rasterizeBandAVX2(y0, y1);
+    } else {
+        rasterizeBandScalar(y0, y1);
+    }
+}
+
+void SoftwareOcclusion::rasterizeBandScalar(int y0, int y1)
+{
+    for (const Triangle& tri : triangles) {
+        int rowBegin = std::max(tri.minY, y0);
+        int rowEnd = std::min(tri.maxY, y1 - 1);
+        for (int y = rowBegin; y <= rowEnd; ++y) {
+            float py = y + 0.5f;
+            float* row = &depth[static_cast<size_t>(y) * stride];
+            float rowEdge[3];
+            for (int e = 0; e < 3; ++e) rowEdge[e] = tri.edgeB[e] * py + tri.edgeC[e];
+            float rowZ = tri.zB * py + tri.zC;
+            for (int x = tri.minX; x <= tri.maxX; ++x) {
+                float px = x + 0.5f;
+                if (tri.edgeA[0] * px + rowEdge[0] < 0.0f ||
+                    tri.edgeA[1] * px + rowEdge[1] < 0.0f ||
+                    tri.edgeA[2] * px + rowEdge[2] < 0.0f) continue;
+                row[x] = std::min(row[x], tri.zA * px + rowZ);
+            }
+        }
+    }
+}
+
+bool SoftwareOcclusion::is_visible(const AABB& worldBounds) const
+{
+    testedCount++;
+    if (!worldBounds.is_valid()) return true;
+
+    glm::vec3 lo(FLT_MAX);
+    glm::vec3 hi(-FLT_MAX);
+    for (int i = 0; i < 8; ++i) {
+        glm::vec3 corner((i & 1) ? worldBounds.max.x : worldBounds.min.x,
+                         (i & 2) ? worldBounds.max.y : worldBounds.min.y,
+                         (i & 4) ? worldBounds.max.z : worldBounds.min.z);
+        glm::vec4 clip = viewProjection * glm::vec4(corner, 1.0f);
+        // 包围盒跨过摄像机平面时投影不可靠，视为可见
+        if (clip.w < MIN_W) return true;
+        glm::vec3 screen = toScreen(clip, width, height);
+        lo = glm::min(lo, screen);
+        hi = glm::max(hi, screen);
+    }
+    if (lo.z <= 0.0f) return true;
+
+    // 包围盒投影覆盖到的所有像素（不只是中心落在内部的）
+    int x0 = std::max(0, static_cast<int>(std::floor(lo.x)));
+    int x1 = std::min(width - 1, static_cast<int>(std::floor(hi.x)));
+    int y0 = std::max(0, static_cast<int>(std::floor(lo.y)));
+    int y1 = std::min(height - 1, static_cast<int>(std::floor(hi.y)));
+    // 完全在屏幕外的交给视锥剔除
+    if (x0 > x1 || y0 > y1) return true;
+
+    bool visible = useAVX2 ? testRectAVX2(x0, x1, y0, y1, lo.z) : testRectScalar(x0, x1, y0, y1, lo.z);
+    if (!visible) culledCount++;
+    return visible;
+}
+
+bool SoftwareOcclusion::testRectScalar(int x0, int x1, int y0, int y1, float minDepth) const
+{
+    // 只要有一个像素不比物体最近点更近，物体就可能可见
+    for (int y = y0; y <= y1; ++y) {
+        const float* row = &depth[static_cast<size_t>(y) * stride];
+        for (int x = x0; x <= x1; ++x) {
+            if (row[x] >= minDepth) return true;
+        }
+    }
+    return false;
+}
+
+#if defined(SOFTWARE_OCCLUSION_X86)
+AVX2_TARGET void SoftwareOcclusion::rasterizeBandAVX2(int y0, int y1)
+{
+    const __m256 laneCenters = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    const __m256 zero = _mm256_setzero_ps();
+    for (const Triangle& tri : triangles) {
+        int rowBegin = std::max(tri.minY, y0);
+        int rowEnd = std::min(tri.maxY, y1 - 1);
+        if (rowBegin > rowEnd) continue;
+
+        const __m256 edgeA0 = _mm256_set1_ps(tri.edgeA[0]);
+        const __m256 edgeA1 = _mm256_set1_ps(tri.edgeA[1]);
+        const __m256 edgeA2 = _mm256_set1_ps(tri.edgeA[2]);
+        const __m256 zA = _mm256_set1_ps(tri.zA);
+        // 从 8 对齐的列开始，超出三角形包围盒的像素边函数必然为负，不会被写入
+        int xBegin = tri.minX & ~7;
+        for (int y = rowBegin; y <= rowEnd; ++y) {
+            float py = y + 0.5f;
+            float* row = &depth[static_cast<size_t>(y) * stride];
+            const __m256 rowEdge0 = _mm256_set1_ps(tri.edgeB[0] * py + tri.edgeC[0]);
+            const __m256 rowEdge1 = _mm256_set1_ps(tri.edgeB[1] * py + tri.edgeC[1]);
+            const __m256 rowEdge2 = _mm256_set1_ps(tri.edgeB[2] * py + tri.edgeC[2]);
+            const __m256 rowZ = _mm256_set1_ps(tri.zB * py + tri.zC);
+            for (int x = xBegin; x <= tri.maxX; x += 8) {
+                __m256 px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), laneCenters);
+                __m256 inside = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA0, px), rowEdge0), zero, _CMP_GE_OQ);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA1, px), rowEdge1), zero, _CMP_GE_OQ));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA2, px), rowEdge2), zero, _CMP_GE_OQ));
+                if (_mm256_movemask_ps(inside) == 0) continue;
+
+                __m256 z = _mm256_add_ps(_mm256_mul_ps(zA, px), rowZ);
+                __m256 old = _mm256_loadu_ps(row + x);
+                _mm256_storeu_ps(row + x, _mm256_blendv_ps(old, _mm256_min_ps(old, z), inside));
+            }
+        }
+    }
+}
+
+AVX2_TARGET bool SoftwareOcclusion::testRectAVX2(int x0, int x1, int y0, int y1, float minDepth) const
+{
+    const __m256 objectDepth = _mm256_set1_ps(minDepth);
+    int xBegin = x0 & ~7;
+    for (int y = y0; y <= y1; ++y) {
+        const float* row = &depth[static_cast<size_t>(y) * stride];
+        for (int x = xBegin; x <= x1; x += 8) {
+            int farther = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(row + x), objectDepth, _CMP_GE_OQ));
+            // 去掉矩形左右两侧之外的通道
+            int first = std::max(0, x0 - x);
+            int last = std::min(7, x1 - x);
+            int lanes = (0xFF << first) & (0xFF >> (7 - last));
+            if (farther & lanes) return true;
+        }
+    }
+    return false;
+}
+#else
+void SoftwareOcclusion::rasterizeBandAVX2(int y0, int y1)
+{
+    rasterizeBandScalar(y0, y1);
+}
+
+bool SoftwareOcclusion::testRectAVX2(int x0, int x1, int y0, int y1, float minDepth) const
+{
+    return testRectScalar(x0, x1, y0, y1, minDepth);
+}
+#endif
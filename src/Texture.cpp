@@ -2,6 +2,7 @@
 #include "Mesh.h"
 #include "GlobalSettings.h"
 #include <algorithm> // For std::count_if
+#include "CpuProfiler.h"
 
 std::unordered_map<std::string, unsigned int> Texture::textureCache;
 
@@ -35,6 +36,7 @@ Texture::~Texture() {
 }
 
 void Texture::add_image(const std::string& filePath, TextureType type, const unsigned char* rawData, size_t size) {
+    CPU_PROFILE_SCOPE("Texture::add_image");
     // 检查当前类型的贴图数量
     int count = std::count_if(images.begin(), images.end(), [type](const TextureImage& img) {
         return img.type == type;
@@ -101,6 +103,7 @@ void Texture::add_image(const std::string& filePath, TextureType type, const uns
 
 void Texture::add_image_from_raw(const std::string &filePath, TextureType type, const unsigned char *rawData, int width, int height, int channel)
 {
+    CPU_PROFILE_SCOPE("Texture::add_image_from_raw");
     // 检查当前类型的贴图数量
     int count = std::count_if(images.begin(), images.end(), [type](const TextureImage& img) {
         return img.type == type;
@@ -166,6 +169,7 @@ void Texture::add_hdri(const std::string& filePath) {
 
 void Texture::add_hdri_to_cubemap(const std::string &filePath, int resolution, bool prefilter)
 {
+    CPU_PROFILE_SCOPE("Texture::add_hdri_to_cubemap");
     unsigned int hdrTexture = load_hdr_texture(filePath);
     GLuint cubemap = convert_HDRI_to_cubemap(hdrTexture, resolution);
     if (cubemap && prefilter) {
@@ -261,7 +265,28 @@ void Texture::add_preCal_CT_BRDF(int resolution)
     images.push_back(image);
 }
 
+bool Texture::has_same_images(const Texture& other) const
+{
+    if (this == &other) return true;
+    if (images.size() != other.images.size() || height_scale != other.height_scale) return false;
+    for (size_t i = 0; i < images.size(); i++) {
+        if (images[i].type != other.images[i].type || images[i].textureID != other.images[i].textureID) return false;
+    }
+    return true;
+}
+
+size_t Texture::get_imageHash() const
+{
+    size_t hash = images.size();
+    for (const auto& image : images) {
+        hash = hash * 31 + static_cast<size_t>(image.type);
+        hash = hash * 31 + image.textureID;
+    }
+    return hash;
+}
+
 void Texture::bind(Shader* shader, TextureType type, unsigned int binding_point) {
+    CPU_PROFILE_SCOPE("Texture::bind");
     if (images.empty()) {
         std::cerr << "No textures to bind." << std::endl;
         return;
@@ -277,9 +302,9 @@ void Texture::bind(Shader* shader, TextureType type, unsigned int binding_point)
         if (it != images.end()) {
             glActiveTexture(GL_TEXTURE0 + binding_point);
             if (it->type == TextureType::Cubemap || it->type == TextureType::Prefilter) {
-                glBindTexture(GL_TEXTURE_CUBE_MAP, it->textureID);
+                gl::bindTexture(GL_TEXTURE_CUBE_MAP, it->textureID);
             } else {
-                glBindTexture(GL_TEXTURE_2D, it->textureID);
+                gl::bindTexture(GL_TEXTURE_2D, it->textureID);
             }
             shader->setUniform1i("texture_" + textureTypeNames[type], binding_point); // 着色器中统一用 例如"texture_noise"
             if (type == TextureType::Noise) {
@@ -299,7 +324,7 @@ void Texture::bind(Shader* shader, TextureType type, unsigned int binding_point)
         if (images[i].type == TextureType::Cubemap || images[i].type == TextureType::Prefilter) 
         {
             glActiveTexture(GL_TEXTURE0 + i);
-            glBindTexture(GL_TEXTURE_CUBE_MAP, images[i].textureID);
+            gl::bindTexture(GL_TEXTURE_CUBE_MAP, images[i].textureID);
             // 获取当前类型的索引
             int index = textureCount[images[i].type]++;
             // 生成着色器采样器变量名，如 "texture_cubemap0", "texture_prefilterMap0"
@@ -310,7 +335,7 @@ void Texture::bind(Shader* shader, TextureType type, unsigned int binding_point)
         {
             // 绑定普通贴图
             glActiveTexture(GL_TEXTURE0 + i);
-            glBindTexture(GL_TEXTURE_2D, images[i].textureID);
+            gl::bindTexture(GL_TEXTURE_2D, images[i].textureID);
             // 获取当前类型的索引
             int index = textureCount[images[i].type]++;
             // 生成着色器采样器变量名，如 "texture_diffuse0", "texture_specular1"
@@ -331,7 +356,7 @@ void Texture::bind(Shader* shader, TextureType type, unsigned int binding_point)
         while (count < MAX_TEXTURE_SLOTS_EACH_TYPE) {
             int slot = images.size() + defaultCount;
             glActiveTexture(GL_TEXTURE0 + slot);
-            glBindTexture(GL_TEXTURE_2D, defaultTextureID);
+            gl::bindTexture(GL_TEXTURE_2D, defaultTextureID);
             std::string texUniformName = "texture_" + textureTypeNames[type] + std::to_string(count);
             shader->setUniform1i(texUniformName, slot);
             count++;
@@ -382,7 +407,7 @@ unsigned char *Texture::read_image_from_memory(TextureImage &image, const unsign
     unsigned char* imageData = stbi_load_from_memory(rawData, size, &image.width, &image.height, &image.channel, 0);
     if (!imageData) {
         std::cerr << "Failed to load image from memory\n";
-        return false;
+        return nullptr;
     }
 
     return imageData;
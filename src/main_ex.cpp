@@ -14,6 +14,7 @@
 #include "Light.h"
 #include "Model.h"
 #include "GlobalSettings.h"
+#include "GpuProfiler.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -196,6 +197,7 @@ int main(void)
     // 初始化渲染流程
     Renderer::getInstance().initialize();
     Renderer::getInstance().setupRenderPasses();
+    Renderer::getInstance().set_camera(camera);
 
     // 处理键盘鼠标输入
     InputManager& inputManager = InputManager::getInstance(); // 单例类
@@ -224,6 +226,7 @@ int main(void)
         glfwPollEvents();
         glfwSwapBuffers(window);
     }
+    Renderer::getInstance().set_camera(nullptr);
     delete camera;
 
     // 释放ImGUI资源
@@ -234,6 +237,7 @@ int main(void)
     // 保存设置
     GlobalSettings::getInstance().SaveToFile("res/settings.json");
 
+    GpuProfiler::getInstance().shutdown();
     glfwTerminate();
     return 0;
 }